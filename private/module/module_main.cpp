@@ -1,5 +1,6 @@
 #include "base/prerequisites.h"
 #include "core/core.h"
+#include "async_image_loader.h"
 #include "image_loader.h"
 namespace Arieo
 {
@@ -10,9 +11,14 @@ namespace Arieo
 
         static struct DllLoader
         {
+            TaskPool task_pool;
             ImageLoader image_loader;
+            AsyncImageLoader async_loader{image_loader, task_pool};
             DllLoader()
+                : image_loader(task_pool)
             {
+                image_loader.setMetricsLogInterval(g_default_image_metrics_log_interval);
+                image_loader.setAsyncLoader(&async_loader);
                 Core::ModuleManager::registerInterface<Interface::FileLoader::IImageLoader>(
                     "image_loader", 
                     &image_loader
@@ -24,6 +30,12 @@ namespace Arieo
                 Core::ModuleManager::unregisterInterface<Interface::FileLoader::IImageLoader>(
                     &image_loader
                 );
+                // Shutting down drains the pool, do not run loads nobody waits
+                // for anymore and let the queued tasks see the cancellation.
+                image_loader.setAsyncLoader(nullptr);
+                async_loader.cancelPending();
+                async_loader.drain();
+                task_pool.shutdown();
             }
         } dll_loader;
     }
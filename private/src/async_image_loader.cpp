@@ -0,0 +1,323 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "async_image_loader.h"
+#include "mapped_file.h"
+
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+
+namespace Arieo
+{
+    // Highest priority first, submission order within one priority.
+    struct AsyncImageQueueKey
+    {
+        ImageLoadPriority m_priority;
+        std::uint64_t m_sequence;
+
+        bool operator<(const AsyncImageQueueKey& other) const
+        {
+            if(m_priority != other.m_priority)
+            {
+                return m_priority > other.m_priority;
+            }
+            return m_sequence < other.m_sequence;
+        }
+    };
+
+    // Shared with every request, so handles can still cancel or reprioritise
+    // after the loader is gone; by then they are all done and nothing moves.
+    struct AsyncImageQueue
+    {
+        std::mutex m_mutex;
+        std::map<AsyncImageQueueKey, std::shared_ptr<ImageLoadRequest>> m_pending;
+        std::uint64_t m_next_sequence = 0;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    // ImageCompletionQueue
+
+    void ImageCompletionQueue::post(std::function<void()> callback)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_callbacks.emplace_back(std::move(callback));
+    }
+
+    size_t ImageCompletionQueue::dispatch()
+    {
+        std::deque<std::function<void()>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            callbacks.swap(m_callbacks);
+        }
+        for(std::function<void()>& callback : callbacks)
+        {
+            callback();
+        }
+        return callbacks.size();
+    }
+
+    size_t ImageCompletionQueue::getPendingCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_callbacks.size();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // ImageLoadRequest
+
+    ImageHandle ImageLoadRequest::getImage() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_image;
+    }
+
+    ImageLoadPriority ImageLoadRequest::getPriority() const
+    {
+        std::lock_guard<std::mutex> lock(m_queue->m_mutex);
+        return m_priority;
+    }
+
+    void ImageLoadRequest::setPriority(ImageLoadPriority priority)
+    {
+        std::lock_guard<std::mutex> lock(m_queue->m_mutex);
+        if(m_priority == priority)
+        {
+            return;
+        }
+        auto found = m_queue->m_pending.find(AsyncImageQueueKey{m_priority, m_sequence});
+        m_priority = priority;
+        if(found != m_queue->m_pending.end())
+        {
+            std::shared_ptr<ImageLoadRequest> request = std::move(found->second);
+            m_queue->m_pending.erase(found);
+            m_queue->m_pending.emplace(AsyncImageQueueKey{m_priority, m_sequence}, std::move(request));
+        }
+    }
+
+    void ImageLoadRequest::cancel()
+    {
+        m_cancellation.cancel();
+
+        std::shared_ptr<ImageLoadRequest> request;
+        {
+            std::lock_guard<std::mutex> lock(m_queue->m_mutex);
+            auto found = m_queue->m_pending.find(AsyncImageQueueKey{m_priority, m_sequence});
+            if(found == m_queue->m_pending.end())
+            {
+                return;
+            }
+            request = std::move(found->second);
+            m_queue->m_pending.erase(found);
+        }
+        // The pool task submitted for this request finds the queue one entry
+        // shorter and exits, or runs the next request in line.
+        request->complete(ImageLoadStatus::CANCELLED, nullptr);
+    }
+
+    void ImageLoadRequest::wait() const
+    {
+        while(isDone() == false)
+        {
+            if(m_task_pool->runPendingTask())
+            {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait_for(lock, std::chrono::milliseconds(1), [this]()
+            {
+                return isDone();
+            });
+        }
+    }
+
+    void ImageLoadRequest::complete(ImageLoadStatus status, ImageHandle image)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_image = std::move(image);
+            m_status.store(status, std::memory_order_release);
+        }
+        m_condition.notify_all();
+
+        // The callback usually captures the request handle, do not keep it
+        // around and close the cycle.
+        ImageLoadCallback callback = std::move(m_callback);
+        m_callback = nullptr;
+        if(callback == nullptr)
+        {
+            return;
+        }
+
+        std::shared_ptr<ImageLoadRequest> request = shared_from_this();
+        if(m_completion_queue != nullptr)
+        {
+            m_completion_queue->post([callback = std::move(callback), request = std::move(request)]()
+            {
+                callback(request);
+            });
+            return;
+        }
+        callback(request);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // AsyncImageLoader
+
+    AsyncImageLoader::AsyncImageLoader(ImageLoader& image_loader, TaskPool& task_pool)
+        : m_image_loader(image_loader),
+          m_task_pool(task_pool),
+          m_queue(std::make_shared<AsyncImageQueue>())
+    {
+    }
+
+    AsyncImageLoader::~AsyncImageLoader()
+    {
+        cancelPending();
+
+        // Pool tasks still queued point at this loader.
+        drain();
+    }
+
+    void AsyncImageLoader::drain()
+    {
+        while(m_task_count.load(std::memory_order_acquire) != 0)
+        {
+            if(m_task_pool.runPendingTask() == false)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    std::shared_ptr<ImageLoadRequest> AsyncImageLoader::load(
+        const void* buffer,
+        size_t size,
+        ImageLoadPriority priority,
+        const ImageLoadOptions& options,
+        ImageLoadCallback callback,
+        ImageCompletionQueue* completion_queue)
+    {
+        std::shared_ptr<ImageLoadRequest> request = std::make_shared<ImageLoadRequest>();
+        {
+            request->m_buffer = buffer;
+            request->m_size = size;
+        }
+        return submit(std::move(request), priority, options, std::move(callback), completion_queue);
+    }
+
+    std::shared_ptr<ImageLoadRequest> AsyncImageLoader::loadFile(
+        const std::filesystem::path& path,
+        ImageLoadPriority priority,
+        const ImageLoadOptions& options,
+        ImageLoadCallback callback,
+        ImageCompletionQueue* completion_queue)
+    {
+        std::shared_ptr<ImageLoadRequest> request = std::make_shared<ImageLoadRequest>();
+        {
+            request->m_path = path;
+        }
+        return submit(std::move(request), priority, options, std::move(callback), completion_queue);
+    }
+
+    std::shared_ptr<ImageLoadRequest> AsyncImageLoader::submit(
+        std::shared_ptr<ImageLoadRequest> request,
+        ImageLoadPriority priority,
+        const ImageLoadOptions& options,
+        ImageLoadCallback callback,
+        ImageCompletionQueue* completion_queue)
+    {
+        {
+            request->m_queue = m_queue;
+            request->m_task_pool = &m_task_pool;
+            request->m_options = options;
+            request->m_cancellation = CancellationToken::create();
+            request->m_callback = std::move(callback);
+            request->m_completion_queue = completion_queue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_queue->m_mutex);
+            request->m_priority = priority;
+            request->m_sequence = m_queue->m_next_sequence++;
+            m_queue->m_pending.emplace(AsyncImageQueueKey{priority, request->m_sequence}, request);
+        }
+
+        m_task_count.fetch_add(1, std::memory_order_relaxed);
+        m_task_pool.submit([this]()
+        {
+            runNextRequest();
+        });
+        return request;
+    }
+
+    void AsyncImageLoader::runNextRequest()
+    {
+        std::shared_ptr<ImageLoadRequest> request;
+        {
+            std::lock_guard<std::mutex> lock(m_queue->m_mutex);
+            if(m_queue->m_pending.empty() == false)
+            {
+                auto first = m_queue->m_pending.begin();
+                request = std::move(first->second);
+                m_queue->m_pending.erase(first);
+                request->m_status.store(ImageLoadStatus::RUNNING, std::memory_order_relaxed);
+            }
+        }
+
+        if(request != nullptr)
+        {
+            ImageHandle image;
+            if(request->m_path.empty())
+            {
+                image = m_image_loader.loadCached(request->m_buffer, request->m_size, request->m_options, request->m_cancellation);
+            }
+            else
+            {
+                // The whole file gets decoded, read it in one go rather than page by page.
+                MappedFile mapped_file;
+                if(mapped_file.open(request->m_path))
+                {
+                    mapped_file.prefetch(0, mapped_file.getSize());
+                    image = m_image_loader.loadCached(mapped_file.getData(), mapped_file.getSize(), request->m_options, request->m_cancellation);
+                }
+            }
+
+            ImageLoadStatus status = ImageLoadStatus::COMPLETED;
+            if(image == nullptr)
+            {
+                status = request->m_cancellation.isCancelled() ? ImageLoadStatus::CANCELLED : ImageLoadStatus::FAILED;
+            }
+            request->complete(status, std::move(image));
+        }
+
+        m_task_count.fetch_sub(1, std::memory_order_release);
+    }
+
+    void AsyncImageLoader::cancelPending()
+    {
+        std::vector<std::shared_ptr<ImageLoadRequest>> requests;
+        {
+            std::lock_guard<std::mutex> lock(m_queue->m_mutex);
+            requests.reserve(m_queue->m_pending.size());
+            for(auto& pending : m_queue->m_pending)
+            {
+                requests.emplace_back(std::move(pending.second));
+            }
+            m_queue->m_pending.clear();
+        }
+        for(std::shared_ptr<ImageLoadRequest>& request : requests)
+        {
+            request->m_cancellation.cancel();
+            request->complete(ImageLoadStatus::CANCELLED, nullptr);
+        }
+    }
+
+    size_t AsyncImageLoader::getPendingCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_queue->m_mutex);
+        return m_queue->m_pending.size();
+    }
+}
\ No newline at end of file
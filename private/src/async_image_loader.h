@@ -0,0 +1,167 @@
+#pragma once
+#include "cancellation_token.h"
+#include "image_loader.h"
+#include "task_pool.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+namespace Arieo
+{
+    class ImageLoadRequest;
+    struct AsyncImageQueue;
+
+    enum class ImageLoadPriority : std::uint32_t
+    {
+        LOW,
+        NORMAL,
+        // Visible textures.
+        HIGH,
+        // Textures the frame cannot be drawn without.
+        CRITICAL
+    };
+
+    enum class ImageLoadStatus : std::uint32_t
+    {
+        PENDING,
+        RUNNING,
+        COMPLETED,
+        FAILED,
+        CANCELLED
+    };
+
+    using ImageLoadCallback = std::function<void(const std::shared_ptr<ImageLoadRequest>& request)>;
+
+    // Completion callbacks posted by the workers, run by whichever thread
+    // pumps dispatch, e.g. the streaming system once per frame.
+    class ImageCompletionQueue
+    {
+    public:
+        void post(std::function<void()> callback);
+
+        // Runs every callback posted so far on the calling thread, returns how many ran.
+        size_t dispatch();
+
+        size_t getPendingCount() const;
+
+    private:
+        mutable std::mutex m_mutex;
+        std::deque<std::function<void()>> m_callbacks;
+    };
+
+    // Handle of one asynchronous load, shared between the caller and the loader.
+    class ImageLoadRequest
+        : public std::enable_shared_from_this<ImageLoadRequest>
+    {
+    public:
+        ImageLoadStatus getStatus() const { return m_status.load(std::memory_order_acquire); }
+        bool isDone() const { return getStatus() > ImageLoadStatus::RUNNING; }
+
+        // The loaded image once the request COMPLETED, nullptr otherwise.
+        ImageHandle getImage() const;
+
+        ImageLoadPriority getPriority() const;
+
+        // Moves a pending request within the queue, running requests keep going.
+        void setPriority(ImageLoadPriority priority);
+
+        // A pending request completes as CANCELLED right away, on the calling
+        // thread or through its completion queue. A running one stops at the
+        // next mip level or band and completes as CANCELLED from its worker.
+        void cancel();
+
+        // Blocks until the request is done. Runs queued pool work meanwhile, so
+        // it is safe to call from inside a task.
+        void wait() const;
+
+    private:
+        friend class AsyncImageLoader;
+
+        void complete(ImageLoadStatus status, ImageHandle image);
+
+        std::shared_ptr<AsyncImageQueue> m_queue;
+        TaskPool* m_task_pool = nullptr;
+
+        const void* m_buffer = nullptr;
+        size_t m_size = 0;
+        std::filesystem::path m_path;
+        ImageLoadOptions m_options;
+        CancellationToken m_cancellation;
+        ImageLoadCallback m_callback;
+        ImageCompletionQueue* m_completion_queue = nullptr;
+
+        // Guarded by the queue mutex.
+        ImageLoadPriority m_priority = ImageLoadPriority::NORMAL;
+        std::uint64_t m_sequence = 0;
+
+        std::atomic<ImageLoadStatus> m_status{ImageLoadStatus::PENDING};
+        mutable std::mutex m_mutex;
+        mutable std::condition_variable m_condition;
+        ImageHandle m_image;
+    };
+
+    // Runs loadCached on task_pool. Every request submits one pool task, and
+    // that task takes whichever pending request has the highest priority when
+    // it starts rather than the one it was submitted for, so a request for a
+    // visible texture overtakes everything still queued.
+    // The module runs one over its own loader and pool, reachable through
+    // ImageLoader::getAsyncLoader since IImageLoader has no async entry point.
+    // Callbacks run on the worker that finished the request unless a
+    // completion queue is given.
+    class AsyncImageLoader
+    {
+    public:
+        AsyncImageLoader(ImageLoader& image_loader, TaskPool& task_pool);
+        ~AsyncImageLoader();
+
+        AsyncImageLoader(const AsyncImageLoader&) = delete;
+        AsyncImageLoader& operator=(const AsyncImageLoader&) = delete;
+
+        // buffer has to stay valid until the request is done.
+        std::shared_ptr<ImageLoadRequest> load(
+            const void* buffer,
+            size_t size,
+            ImageLoadPriority priority,
+            const ImageLoadOptions& options = ImageLoadOptions{},
+            ImageLoadCallback callback = nullptr,
+            ImageCompletionQueue* completion_queue = nullptr
+        );
+
+        // The file is mapped by the worker that picks the request up.
+        std::shared_ptr<ImageLoadRequest> loadFile(
+            const std::filesystem::path& path,
+            ImageLoadPriority priority,
+            const ImageLoadOptions& options = ImageLoadOptions{},
+            ImageLoadCallback callback = nullptr,
+            ImageCompletionQueue* completion_queue = nullptr
+        );
+
+        // Cancels every pending request; running ones finish or stop on their own.
+        void cancelPending();
+
+        // Helps the pool until every task this loader submitted has run. Call
+        // cancelPending first, or the pending requests are loaded meanwhile.
+        void drain();
+
+        size_t getPendingCount() const;
+
+    private:
+        std::shared_ptr<ImageLoadRequest> submit(
+            std::shared_ptr<ImageLoadRequest> request,
+            ImageLoadPriority priority,
+            const ImageLoadOptions& options,
+            ImageLoadCallback callback,
+            ImageCompletionQueue* completion_queue
+        );
+        void runNextRequest();
+
+        ImageLoader& m_image_loader;
+        TaskPool& m_task_pool;
+        std::shared_ptr<AsyncImageQueue> m_queue;
+        std::atomic<size_t> m_task_count{0};
+    };
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+namespace Arieo
+{
+    // Helpers shared by the BC decoder and encoder. Colours are packed as
+    // little endian RGBA8 (R in the low byte); swap_red_blue produces BGRA8.
+
+    inline std::uint16_t readBCUint16(const std::uint8_t* data)
+    {
+        return (std::uint16_t)(data[0] | (data[1] << 8));
+    }
+
+    inline std::uint32_t readBCUint32(const std::uint8_t* data)
+    {
+        std::uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    inline std::uint64_t readBCUint64(const std::uint8_t* data)
+    {
+        std::uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    inline std::uint32_t packBCColor(std::uint32_t r, std::uint32_t g, std::uint32_t b, std::uint32_t a, bool swap_red_blue)
+    {
+        return swap_red_blue
+            ? (b | (g << 8) | (r << 16) | (a << 24))
+            : (r | (g << 8) | (b << 16) | (a << 24));
+    }
+
+    inline void unpackBC565(std::uint16_t color, std::uint32_t& r, std::uint32_t& g, std::uint32_t& b)
+    {
+        std::uint32_t r5 = (color >> 11) & 0x1F;
+        std::uint32_t g6 = (color >> 5) & 0x3F;
+        std::uint32_t b5 = color & 0x1F;
+        r = (r5 << 3) | (r5 >> 2);
+        g = (g6 << 2) | (g6 >> 4);
+        b = (b5 << 3) | (b5 >> 2);
+    }
+
+    // BC2 and BC3 colour blocks always use the four colour mode.
+    inline void buildBC1Palette(const std::uint8_t* block, bool allow_three_color, bool swap_red_blue, std::uint32_t palette[4])
+    {
+        std::uint16_t color0 = readBCUint16(block);
+        std::uint16_t color1 = readBCUint16(block + 2);
+
+        std::uint32_t r0, g0, b0, r1, g1, b1;
+        unpackBC565(color0, r0, g0, b0);
+        unpackBC565(color1, r1, g1, b1);
+
+        palette[0] = packBCColor(r0, g0, b0, 255, swap_red_blue);
+        palette[1] = packBCColor(r1, g1, b1, 255, swap_red_blue);
+        if(color0 > color1 || allow_three_color == false)
+        {
+            palette[2] = packBCColor((2 * r0 + r1 + 1) / 3, (2 * g0 + g1 + 1) / 3, (2 * b0 + b1 + 1) / 3, 255, swap_red_blue);
+            palette[3] = packBCColor((r0 + 2 * r1 + 1) / 3, (g0 + 2 * g1 + 1) / 3, (b0 + 2 * b1 + 1) / 3, 255, swap_red_blue);
+        }
+        else
+        {
+            palette[2] = packBCColor((r0 + r1 + 1) / 2, (g0 + g1 + 1) / 2, (b0 + b1 + 1) / 2, 255, swap_red_blue);
+            palette[3] = 0;
+        }
+    }
+
+    inline void buildBC4PaletteUnorm(const std::uint8_t* block, std::uint8_t palette[8])
+    {
+        std::uint32_t a0 = block[0];
+        std::uint32_t a1 = block[1];
+        palette[0] = (std::uint8_t)a0;
+        palette[1] = (std::uint8_t)a1;
+        if(a0 > a1)
+        {
+            for(std::uint32_t i = 1; i < 7; ++i)
+            {
+                palette[i + 1] = (std::uint8_t)(((7 - i) * a0 + i * a1 + 3) / 7);
+            }
+        }
+        else
+        {
+            for(std::uint32_t i = 1; i < 5; ++i)
+            {
+                palette[i + 1] = (std::uint8_t)(((5 - i) * a0 + i * a1 + 2) / 5);
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    inline std::int32_t roundBCDivide(std::int32_t value, std::int32_t divisor)
+    {
+        return value >= 0 ? (value + divisor / 2) / divisor : -((-value + divisor / 2) / divisor);
+    }
+
+    // -128 is an alias of -127 in BC4/BC5 SNORM.
+    inline void buildBC4PaletteSnorm(const std::uint8_t* block, std::int8_t palette[8])
+    {
+        std::int32_t a0 = (std::int8_t)block[0] == -128 ? -127 : (std::int8_t)block[0];
+        std::int32_t a1 = (std::int8_t)block[1] == -128 ? -127 : (std::int8_t)block[1];
+        palette[0] = (std::int8_t)a0;
+        palette[1] = (std::int8_t)a1;
+        if(a0 > a1)
+        {
+            for(std::int32_t i = 1; i < 7; ++i)
+            {
+                palette[i + 1] = (std::int8_t)roundBCDivide((7 - i) * a0 + i * a1, 7);
+            }
+        }
+        else
+        {
+            for(std::int32_t i = 1; i < 5; ++i)
+            {
+                palette[i + 1] = (std::int8_t)roundBCDivide((5 - i) * a0 + i * a1, 5);
+            }
+            palette[6] = -127;
+            palette[7] = 127;
+        }
+    }
+
+    // 48 bits of 3 bit indices following the two BC4 endpoints.
+    inline std::uint64_t readBC4Indices(const std::uint8_t* block)
+    {
+        return readBCUint64(block) >> 16;
+    }
+}
\ No newline at end of file
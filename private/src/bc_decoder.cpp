@@ -0,0 +1,827 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "bc_decoder.h"
+#include "bc_common.h"
+#include "bc_tables.h"
+#include "image_format.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Arieo
+{
+    // Reads little endian bit fields out of a 128 bit block.
+    class BCBitReader
+    {
+    public:
+        explicit BCBitReader(const std::uint8_t* block)
+            : m_low(readBCUint64(block)), m_high(readBCUint64(block + 8))
+        {
+        }
+
+        std::uint32_t read(std::uint32_t count)
+        {
+            std::uint64_t value = 0;
+            if(m_position >= 64)
+            {
+                value = m_high >> (m_position - 64);
+            }
+            else if(m_position == 0)
+            {
+                value = m_low;
+            }
+            else
+            {
+                value = (m_low >> m_position) | (m_high << (64 - m_position));
+            }
+            m_position += count;
+            return (std::uint32_t)(value & ((std::uint64_t(1) << count) - 1));
+        }
+
+        std::uint32_t getPosition() const { return m_position; }
+        void setPosition(std::uint32_t position) { m_position = position; }
+
+    private:
+        std::uint64_t m_low;
+        std::uint64_t m_high;
+        std::uint32_t m_position = 0;
+    };
+
+    static std::int32_t signExtend(std::uint32_t value, std::uint32_t bits)
+    {
+        std::uint32_t shift = 32 - bits;
+        return (std::int32_t)(value << shift) >> shift;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // BC1 - BC5
+
+    static void writeBCColorBlock(const std::uint32_t palette[4], std::uint32_t indices, const std::uint8_t* alpha, std::uint8_t* destination, size_t destination_row_pitch)
+    {
+        for(std::uint32_t y = 0; y < 4; ++y)
+        {
+            std::uint32_t* row = (std::uint32_t*)(destination + y * destination_row_pitch);
+            for(std::uint32_t x = 0; x < 4; ++x)
+            {
+                std::uint32_t pixel = y * 4 + x;
+                std::uint32_t color = palette[(indices >> (pixel * 2)) & 0x3];
+                if(alpha != nullptr)
+                {
+                    color = (color & 0x00FFFFFF) | (std::uint32_t(alpha[pixel]) << 24);
+                }
+                std::memcpy(row + x, &color, sizeof(color));
+            }
+        }
+    }
+
+    static void decodeBC1BlockScalar(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool swap_red_blue)
+    {
+        std::uint32_t palette[4];
+        buildBC1Palette(block, true, swap_red_blue, palette);
+        writeBCColorBlock(palette, readBCUint32(block + 4), nullptr, destination, destination_row_pitch);
+    }
+
+    static void decodeBC2BlockScalar(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool swap_red_blue)
+    {
+        std::uint8_t alpha[16];
+        std::uint64_t alpha_bits = readBCUint64(block);
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            alpha[pixel] = (std::uint8_t)(((alpha_bits >> (pixel * 4)) & 0xF) * 17);
+        }
+
+        std::uint32_t palette[4];
+        buildBC1Palette(block + 8, false, swap_red_blue, palette);
+        writeBCColorBlock(palette, readBCUint32(block + 12), alpha, destination, destination_row_pitch);
+    }
+
+    static void expandBC4Unorm(const std::uint8_t* block, std::uint8_t values[16])
+    {
+        std::uint8_t palette[8];
+        buildBC4PaletteUnorm(block, palette);
+        std::uint64_t indices = readBC4Indices(block);
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            values[pixel] = palette[(indices >> (pixel * 3)) & 0x7];
+        }
+    }
+
+    static void expandBC4Snorm(const std::uint8_t* block, std::uint8_t values[16])
+    {
+        std::int8_t palette[8];
+        buildBC4PaletteSnorm(block, palette);
+        std::uint64_t indices = readBC4Indices(block);
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            values[pixel] = (std::uint8_t)palette[(indices >> (pixel * 3)) & 0x7];
+        }
+    }
+
+    static void decodeBC3BlockScalar(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool swap_red_blue)
+    {
+        std::uint8_t alpha[16];
+        expandBC4Unorm(block, alpha);
+
+        std::uint32_t palette[4];
+        buildBC1Palette(block + 8, false, swap_red_blue, palette);
+        writeBCColorBlock(palette, readBCUint32(block + 12), alpha, destination, destination_row_pitch);
+    }
+
+    static void writeBCChannelBlock(const std::uint8_t* red, const std::uint8_t* green, std::uint8_t* destination, size_t destination_row_pitch)
+    {
+        for(std::uint32_t y = 0; y < 4; ++y)
+        {
+            std::uint8_t* row = destination + y * destination_row_pitch;
+            for(std::uint32_t x = 0; x < 4; ++x)
+            {
+                if(green == nullptr)
+                {
+                    row[x] = red[y * 4 + x];
+                }
+                else
+                {
+                    row[x * 2 + 0] = red[y * 4 + x];
+                    row[x * 2 + 1] = green[y * 4 + x];
+                }
+            }
+        }
+    }
+
+    static void decodeBC4UnormBlockScalar(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        std::uint8_t red[16];
+        expandBC4Unorm(block, red);
+        writeBCChannelBlock(red, nullptr, destination, destination_row_pitch);
+    }
+
+    static void decodeBC4SnormBlockScalar(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        std::uint8_t red[16];
+        expandBC4Snorm(block, red);
+        writeBCChannelBlock(red, nullptr, destination, destination_row_pitch);
+    }
+
+    static void decodeBC5UnormBlockScalar(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        std::uint8_t red[16];
+        std::uint8_t green[16];
+        expandBC4Unorm(block, red);
+        expandBC4Unorm(block + 8, green);
+        writeBCChannelBlock(red, green, destination, destination_row_pitch);
+    }
+
+    static void decodeBC5SnormBlockScalar(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        std::uint8_t red[16];
+        std::uint8_t green[16];
+        expandBC4Snorm(block, red);
+        expandBC4Snorm(block + 8, green);
+        writeBCChannelBlock(red, green, destination, destination_row_pitch);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // BC6H
+
+    enum BC6HField : std::uint8_t
+    {
+        BC6H_RW, BC6H_GW, BC6H_BW,
+        BC6H_RX, BC6H_GX, BC6H_BX,
+        BC6H_RY, BC6H_GY, BC6H_BY,
+        BC6H_RZ, BC6H_GZ, BC6H_BZ,
+        BC6H_D,
+        BC6H_END
+    };
+
+    // field[high:low] as written in the format specification. Bits are read
+    // starting at low, so a reversed range (low > high) is read backwards.
+    struct BC6HSegment
+    {
+        BC6HField m_field;
+        std::uint8_t m_high;
+        std::uint8_t m_low;
+    };
+
+    struct BC6HMode
+    {
+        std::uint32_t m_mode_bits;
+        bool m_transformed;
+        std::uint32_t m_endpoint_bits;
+        std::uint32_t m_delta_bits[3];
+        std::uint32_t m_subset_count;
+        BC6HSegment m_segments[28];
+    };
+
+    static const BC6HMode g_bc6h_modes[] =
+    {
+        // mode 1
+        { 0x00, true, 10, {5, 5, 5}, 2, {
+            {BC6H_GY,4,4}, {BC6H_BY,4,4}, {BC6H_BZ,4,4}, {BC6H_RW,9,0}, {BC6H_GW,9,0}, {BC6H_BW,9,0},
+            {BC6H_RX,4,0}, {BC6H_GZ,4,4}, {BC6H_GY,3,0}, {BC6H_GX,4,0}, {BC6H_BZ,0,0}, {BC6H_GZ,3,0},
+            {BC6H_BX,4,0}, {BC6H_BZ,1,1}, {BC6H_BY,3,0}, {BC6H_RY,4,0}, {BC6H_BZ,2,2}, {BC6H_RZ,4,0},
+            {BC6H_BZ,3,3}, {BC6H_D,4,0}, {BC6H_END,0,0} } },
+        // mode 2
+        { 0x01, true, 7, {6, 6, 6}, 2, {
+            {BC6H_GY,5,5}, {BC6H_GZ,4,4}, {BC6H_GZ,5,5}, {BC6H_RW,6,0}, {BC6H_BZ,0,0}, {BC6H_BZ,1,1},
+            {BC6H_BY,4,4}, {BC6H_GW,6,0}, {BC6H_BY,5,5}, {BC6H_BZ,2,2}, {BC6H_GY,4,4}, {BC6H_BW,6,0},
+            {BC6H_BZ,3,3}, {BC6H_BZ,5,5}, {BC6H_BZ,4,4}, {BC6H_RX,5,0}, {BC6H_GY,3,0}, {BC6H_GX,5,0},
+            {BC6H_GZ,3,0}, {BC6H_BX,5,0}, {BC6H_BY,3,0}, {BC6H_RY,5,0}, {BC6H_RZ,5,0}, {BC6H_D,4,0},
+            {BC6H_END,0,0} } },
+        // mode 3
+        { 0x02, true, 11, {5, 4, 4}, 2, {
+            {BC6H_RW,9,0}, {BC6H_GW,9,0}, {BC6H_BW,9,0}, {BC6H_RX,4,0}, {BC6H_RW,10,10}, {BC6H_GY,3,0},
+            {BC6H_GX,3,0}, {BC6H_GW,10,10}, {BC6H_BZ,0,0}, {BC6H_GZ,3,0}, {BC6H_BX,3,0}, {BC6H_BW,10,10},
+            {BC6H_BZ,1,1}, {BC6H_BY,3,0}, {BC6H_RY,4,0}, {BC6H_BZ,2,2}, {BC6H_RZ,4,0}, {BC6H_BZ,3,3},
+            {BC6H_D,4,0}, {BC6H_END,0,0} } },
+        // mode 4
+        { 0x06, true, 11, {4, 5, 4}, 2, {
+            {BC6H_RW,9,0}, {BC6H_GW,9,0}, {BC6H_BW,9,0}, {BC6H_RX,3,0}, {BC6H_RW,10,10}, {BC6H_GZ,4,4},
+            {BC6H_GY,3,0}, {BC6H_GX,4,0}, {BC6H_GW,10,10}, {BC6H_GZ,3,0}, {BC6H_BX,3,0}, {BC6H_BW,10,10},
+            {BC6H_BZ,1,1}, {BC6H_BY,3,0}, {BC6H_RY,3,0}, {BC6H_BZ,0,0}, {BC6H_BZ,2,2}, {BC6H_RZ,3,0},
+            {BC6H_GY,4,4}, {BC6H_BZ,3,3}, {BC6H_D,4,0}, {BC6H_END,0,0} } },
+        // mode 5
+        { 0x0A, true, 11, {4, 4, 5}, 2, {
+            {BC6H_RW,9,0}, {BC6H_GW,9,0}, {BC6H_BW,9,0}, {BC6H_RX,3,0}, {BC6H_RW,10,10}, {BC6H_BY,4,4},
+            {BC6H_GY,3,0}, {BC6H_GX,3,0}, {BC6H_GW,10,10}, {BC6H_BZ,0,0}, {BC6H_GZ,3,0}, {BC6H_BX,4,0},
+            {BC6H_BW,10,10}, {BC6H_BY,3,0}, {BC6H_RY,3,0}, {BC6H_BZ,1,1}, {BC6H_BZ,2,2}, {BC6H_RZ,3,0},
+            {BC6H_BZ,4,4}, {BC6H_BZ,3,3}, {BC6H_D,4,0}, {BC6H_END,0,0} } },
+        // mode 6
+        { 0x0E, true, 9, {5, 5, 5}, 2, {
+            {BC6H_RW,8,0}, {BC6H_BY,4,4}, {BC6H_GW,8,0}, {BC6H_GY,4,4}, {BC6H_BW,8,0}, {BC6H_BZ,4,4},
+            {BC6H_RX,4,0}, {BC6H_GZ,4,4}, {BC6H_GY,3,0}, {BC6H_GX,4,0}, {BC6H_BZ,0,0}, {BC6H_GZ,3,0},
+            {BC6H_BX,4,0}, {BC6H_BZ,1,1}, {BC6H_BY,3,0}, {BC6H_RY,4,0}, {BC6H_BZ,2,2}, {BC6H_RZ,4,0},
+            {BC6H_BZ,3,3}, {BC6H_D,4,0}, {BC6H_END,0,0} } },
+        // mode 7
+        { 0x12, true, 8, {6, 5, 5}, 2, {
+            {BC6H_RW,7,0}, {BC6H_GZ,4,4}, {BC6H_BY,4,4}, {BC6H_GW,7,0}, {BC6H_BZ,2,2}, {BC6H_GY,4,4},
+            {BC6H_BW,7,0}, {BC6H_BZ,3,3}, {BC6H_BZ,4,4}, {BC6H_RX,5,0}, {BC6H_GY,3,0}, {BC6H_GX,4,0},
+            {BC6H_BZ,0,0}, {BC6H_GZ,3,0}, {BC6H_BX,4,0}, {BC6H_BZ,1,1}, {BC6H_BY,3,0}, {BC6H_RY,5,0},
+            {BC6H_RZ,5,0}, {BC6H_D,4,0}, {BC6H_END,0,0} } },
+        // mode 8
+        { 0x16, true, 8, {5, 6, 5}, 2, {
+            {BC6H_RW,7,0}, {BC6H_BZ,0,0}, {BC6H_BY,4,4}, {BC6H_GW,7,0}, {BC6H_GY,5,5}, {BC6H_GY,4,4},
+            {BC6H_BW,7,0}, {BC6H_GZ,5,5}, {BC6H_BZ,4,4}, {BC6H_RX,4,0}, {BC6H_GZ,4,4}, {BC6H_GY,3,0},
+            {BC6H_GX,5,0}, {BC6H_GZ,3,0}, {BC6H_BX,4,0}, {BC6H_BZ,1,1}, {BC6H_BY,3,0}, {BC6H_RY,4,0},
+            {BC6H_BZ,2,2}, {BC6H_RZ,4,0}, {BC6H_BZ,3,3}, {BC6H_D,4,0}, {BC6H_END,0,0} } },
+        // mode 9
+        { 0x1A, true, 8, {5, 5, 6}, 2, {
+            {BC6H_RW,7,0}, {BC6H_BZ,1,1}, {BC6H_BY,4,4}, {BC6H_GW,7,0}, {BC6H_BY,5,5}, {BC6H_GY,4,4},
+            {BC6H_BW,7,0}, {BC6H_BZ,5,5}, {BC6H_BZ,4,4}, {BC6H_RX,4,0}, {BC6H_GZ,4,4}, {BC6H_GY,3,0},
+            {BC6H_GX,4,0}, {BC6H_BZ,0,0}, {BC6H_GZ,3,0}, {BC6H_BX,5,0}, {BC6H_BY,3,0}, {BC6H_RY,4,0},
+            {BC6H_BZ,2,2}, {BC6H_RZ,4,0}, {BC6H_BZ,3,3}, {BC6H_D,4,0}, {BC6H_END,0,0} } },
+        // mode 10
+        { 0x1E, false, 6, {6, 6, 6}, 2, {
+            {BC6H_RW,5,0}, {BC6H_GZ,4,4}, {BC6H_BZ,0,0}, {BC6H_BZ,1,1}, {BC6H_BY,4,4}, {BC6H_GW,5,0},
+            {BC6H_GY,5,5}, {BC6H_BY,5,5}, {BC6H_BZ,2,2}, {BC6H_GY,4,4}, {BC6H_BW,5,0}, {BC6H_GZ,5,5},
+            {BC6H_BZ,3,3}, {BC6H_BZ,5,5}, {BC6H_BZ,4,4}, {BC6H_RX,5,0}, {BC6H_GY,3,0}, {BC6H_GX,5,0},
+            {BC6H_GZ,3,0}, {BC6H_BX,5,0}, {BC6H_BY,3,0}, {BC6H_RY,5,0}, {BC6H_RZ,5,0}, {BC6H_D,4,0},
+            {BC6H_END,0,0} } },
+        // mode 11
+        { 0x03, false, 10, {10, 10, 10}, 1, {
+            {BC6H_RW,9,0}, {BC6H_GW,9,0}, {BC6H_BW,9,0}, {BC6H_RX,9,0}, {BC6H_GX,9,0}, {BC6H_BX,9,0},
+            {BC6H_END,0,0} } },
+        // mode 12
+        { 0x07, true, 11, {9, 9, 9}, 1, {
+            {BC6H_RW,9,0}, {BC6H_GW,9,0}, {BC6H_BW,9,0}, {BC6H_RX,8,0}, {BC6H_RW,10,10}, {BC6H_GX,8,0},
+            {BC6H_GW,10,10}, {BC6H_BX,8,0}, {BC6H_BW,10,10}, {BC6H_END,0,0} } },
+        // mode 13
+        { 0x0B, true, 12, {8, 8, 8}, 1, {
+            {BC6H_RW,9,0}, {BC6H_GW,9,0}, {BC6H_BW,9,0}, {BC6H_RX,7,0}, {BC6H_RW,10,11}, {BC6H_GX,7,0},
+            {BC6H_GW,10,11}, {BC6H_BX,7,0}, {BC6H_BW,10,11}, {BC6H_END,0,0} } },
+        // mode 14
+        { 0x0F, true, 16, {4, 4, 4}, 1, {
+            {BC6H_RW,9,0}, {BC6H_GW,9,0}, {BC6H_BW,9,0}, {BC6H_RX,3,0}, {BC6H_RW,10,15}, {BC6H_GX,3,0},
+            {BC6H_GW,10,15}, {BC6H_BX,3,0}, {BC6H_BW,10,15}, {BC6H_END,0,0} } },
+    };
+
+    static const BC6HMode* findBC6HMode(BCBitReader& reader)
+    {
+        std::uint32_t mode_bits = reader.read(2);
+        if(mode_bits > 1)
+        {
+            mode_bits |= reader.read(3) << 2;
+        }
+        for(const BC6HMode& mode : g_bc6h_modes)
+        {
+            if(mode.m_mode_bits == mode_bits)
+            {
+                return &mode;
+            }
+        }
+        return nullptr;
+    }
+
+    static std::int32_t unquantizeBC6H(std::int32_t value, std::uint32_t bits, bool is_signed)
+    {
+        if(is_signed == false)
+        {
+            if(bits >= 15 || value == 0)
+            {
+                return value;
+            }
+            if(value == (1 << bits) - 1)
+            {
+                return 0xFFFF;
+            }
+            return ((value << 16) + 0x8000) >> bits;
+        }
+
+        if(bits >= 16 || value == 0)
+        {
+            return value;
+        }
+        bool is_negative = value < 0;
+        std::int32_t magnitude = is_negative ? -value : value;
+        std::int32_t result = 0;
+        if(magnitude >= (1 << (bits - 1)) - 1)
+        {
+            result = 0x7FFF;
+        }
+        else
+        {
+            result = ((magnitude << 15) + 0x4000) >> (bits - 1);
+        }
+        return is_negative ? -result : result;
+    }
+
+    static std::uint16_t finishBC6HUnquantize(std::int32_t value, bool is_signed)
+    {
+        if(is_signed == false)
+        {
+            return (std::uint16_t)((value * 31) >> 6);
+        }
+        if(value < 0)
+        {
+            return (std::uint16_t)(0x8000 | (((-value) * 31) >> 5));
+        }
+        return (std::uint16_t)((value * 31) >> 5);
+    }
+
+    bool readBC6HEndpoints(const std::uint8_t* block, bool is_signed, BC6HEndpoints& endpoints)
+    {
+        BCBitReader reader(block);
+        const BC6HMode* mode = findBC6HMode(reader);
+        if(mode == nullptr)
+        {
+            return false;
+        }
+
+        std::uint32_t fields[BC6H_END] = {};
+        for(const BC6HSegment* segment = mode->m_segments; segment->m_field != BC6H_END; ++segment)
+        {
+            if(segment->m_high >= segment->m_low)
+            {
+                for(std::uint32_t bit = segment->m_low; bit <= segment->m_high; ++bit)
+                {
+                    fields[segment->m_field] |= reader.read(1) << bit;
+                }
+            }
+            else
+            {
+                for(std::int32_t bit = segment->m_low; bit >= (std::int32_t)segment->m_high; --bit)
+                {
+                    fields[segment->m_field] |= reader.read(1) << bit;
+                }
+            }
+        }
+
+        std::uint32_t endpoint_count = mode->m_subset_count * 2;
+        std::uint32_t endpoint_mask = (mode->m_endpoint_bits >= 32) ? 0xFFFFFFFF : ((1u << mode->m_endpoint_bits) - 1);
+        for(std::uint32_t channel = 0; channel < 3; ++channel)
+        {
+            std::uint32_t base = fields[BC6H_RW + channel];
+            endpoints.m_endpoints[0][channel] = is_signed ? signExtend(base, mode->m_endpoint_bits) : (std::int32_t)base;
+            for(std::uint32_t endpoint = 1; endpoint < endpoint_count; ++endpoint)
+            {
+                std::uint32_t value = fields[BC6H_RW + endpoint * 3 + channel];
+                if(mode->m_transformed)
+                {
+                    value = (base + (std::uint32_t)signExtend(value, mode->m_delta_bits[channel])) & endpoint_mask;
+                }
+                endpoints.m_endpoints[endpoint][channel] = is_signed ? signExtend(value, mode->m_endpoint_bits) : (std::int32_t)value;
+            }
+        }
+
+        for(std::uint32_t endpoint = 0; endpoint < endpoint_count; ++endpoint)
+        {
+            for(std::uint32_t channel = 0; channel < 3; ++channel)
+            {
+                endpoints.m_endpoints[endpoint][channel] = unquantizeBC6H(endpoints.m_endpoints[endpoint][channel], mode->m_endpoint_bits, is_signed);
+            }
+        }
+
+        endpoints.m_subset_count = mode->m_subset_count;
+        endpoints.m_partition = fields[BC6H_D];
+        endpoints.m_index_offset = mode->m_subset_count == 1 ? 65 : 82;
+        return true;
+    }
+
+    static void decodeBC6HBlock(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool is_signed)
+    {
+        BC6HEndpoints endpoints;
+        if(readBC6HEndpoints(block, is_signed, endpoints) == false)
+        {
+            // Reserved modes decode to black.
+            for(std::uint32_t y = 0; y < 4; ++y)
+            {
+                std::memset(destination + y * destination_row_pitch, 0, 4 * 4 * sizeof(std::uint16_t));
+            }
+            return;
+        }
+
+        std::uint32_t subset_count = endpoints.m_subset_count;
+        std::uint32_t partition = endpoints.m_partition;
+        std::uint32_t index_bits = subset_count == 1 ? 4 : 3;
+        const std::uint8_t* weights = subset_count == 1 ? g_bc_weights4 : g_bc_weights3;
+        BCBitReader reader(block);
+        reader.setPosition(endpoints.m_index_offset);
+
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            std::uint32_t subset = subset_count == 1 ? 0 : getBCPartitionSubset(2, partition, pixel);
+            bool is_anchor = pixel == 0 || (subset_count == 2 && pixel == g_bc_anchor_2_subset_second[partition]);
+            std::uint32_t index = reader.read(is_anchor ? index_bits - 1 : index_bits);
+            std::int32_t weight = weights[index];
+
+            std::uint16_t half[4];
+            for(std::uint32_t channel = 0; channel < 3; ++channel)
+            {
+                std::int32_t value0 = endpoints.m_endpoints[subset * 2][channel];
+                std::int32_t value1 = endpoints.m_endpoints[subset * 2 + 1][channel];
+                std::int32_t value = ((64 - weight) * value0 + weight * value1 + 32) >> 6;
+                half[channel] = finishBC6HUnquantize(value, is_signed);
+            }
+            half[3] = 0x3C00;
+
+            std::uint8_t* texel = destination + (pixel / 4) * destination_row_pitch + (pixel % 4) * sizeof(half);
+            std::memcpy(texel, half, sizeof(half));
+        }
+    }
+
+    static void decodeBC6HUfloatBlockScalar(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        decodeBC6HBlock(block, destination, destination_row_pitch, false);
+    }
+
+    static void decodeBC6HSfloatBlockScalar(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        decodeBC6HBlock(block, destination, destination_row_pitch, true);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // BC7
+
+    struct BC7Mode
+    {
+        std::uint32_t m_subset_count;
+        std::uint32_t m_partition_bits;
+        std::uint32_t m_rotation_bits;
+        std::uint32_t m_index_selection_bits;
+        std::uint32_t m_color_bits;
+        std::uint32_t m_alpha_bits;
+        std::uint32_t m_endpoint_pbits;
+        std::uint32_t m_shared_pbits;
+        std::uint32_t m_index_bits;
+        std::uint32_t m_secondary_index_bits;
+    };
+
+    static const BC7Mode g_bc7_modes[8] =
+    {
+        {3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+        {2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+        {3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+        {2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+        {1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+        {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+        {1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+        {2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+    };
+
+    static std::uint32_t unquantizeBC7(std::uint32_t value, std::uint32_t bits)
+    {
+        value <<= (8 - bits);
+        return value | (value >> bits);
+    }
+
+    bool readBC7Endpoints(const std::uint8_t* block, BC7Endpoints& endpoints)
+    {
+        std::uint32_t mode_index = 0;
+        while(mode_index < 8 && (block[0] & (1 << mode_index)) == 0)
+        {
+            ++mode_index;
+        }
+        if(mode_index == 8)
+        {
+            return false;
+        }
+
+        const BC7Mode& mode = g_bc7_modes[mode_index];
+        BCBitReader reader(block);
+        reader.read(mode_index + 1);
+
+        endpoints.m_subset_count = mode.m_subset_count;
+        endpoints.m_partition = reader.read(mode.m_partition_bits);
+        endpoints.m_rotation = reader.read(mode.m_rotation_bits);
+        endpoints.m_index_selection = reader.read(mode.m_index_selection_bits);
+        endpoints.m_index_bits = mode.m_index_bits;
+        endpoints.m_secondary_index_bits = mode.m_secondary_index_bits;
+
+        std::uint32_t endpoint_count = mode.m_subset_count * 2;
+        std::uint32_t values[6][4] = {};
+        for(std::uint32_t channel = 0; channel < 3; ++channel)
+        {
+            for(std::uint32_t endpoint = 0; endpoint < endpoint_count; ++endpoint)
+            {
+                values[endpoint][channel] = reader.read(mode.m_color_bits);
+            }
+        }
+        if(mode.m_alpha_bits != 0)
+        {
+            for(std::uint32_t endpoint = 0; endpoint < endpoint_count; ++endpoint)
+            {
+                values[endpoint][3] = reader.read(mode.m_alpha_bits);
+            }
+        }
+
+        std::uint32_t pbits[6] = {};
+        bool has_pbits = mode.m_endpoint_pbits != 0 || mode.m_shared_pbits != 0;
+        if(mode.m_endpoint_pbits != 0)
+        {
+            for(std::uint32_t endpoint = 0; endpoint < endpoint_count; ++endpoint)
+            {
+                pbits[endpoint] = reader.read(1);
+            }
+        }
+        if(mode.m_shared_pbits != 0)
+        {
+            for(std::uint32_t subset = 0; subset < mode.m_subset_count; ++subset)
+            {
+                std::uint32_t pbit = reader.read(1);
+                pbits[subset * 2] = pbit;
+                pbits[subset * 2 + 1] = pbit;
+            }
+        }
+        endpoints.m_index_offset = reader.getPosition();
+
+        for(std::uint32_t endpoint = 0; endpoint < endpoint_count; ++endpoint)
+        {
+            for(std::uint32_t channel = 0; channel < 4; ++channel)
+            {
+                std::uint32_t bits = channel < 3 ? mode.m_color_bits : mode.m_alpha_bits;
+                if(bits == 0)
+                {
+                    endpoints.m_endpoints[endpoint][channel] = 255;
+                    continue;
+                }
+                std::uint32_t value = values[endpoint][channel];
+                if(has_pbits)
+                {
+                    value = (value << 1) | pbits[endpoint];
+                    bits += 1;
+                }
+                endpoints.m_endpoints[endpoint][channel] = (std::uint8_t)unquantizeBC7(value, bits);
+            }
+        }
+        return true;
+    }
+
+    static void decodeBC7BlockScalar(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool swap_red_blue)
+    {
+        BC7Endpoints endpoints;
+        if(readBC7Endpoints(block, endpoints) == false)
+        {
+            // Reserved mode, decodes to transparent black.
+            for(std::uint32_t y = 0; y < 4; ++y)
+            {
+                std::memset(destination + y * destination_row_pitch, 0, 4 * sizeof(std::uint32_t));
+            }
+            return;
+        }
+
+        std::uint32_t subset_count = endpoints.m_subset_count;
+        std::uint32_t partition = endpoints.m_partition;
+        std::uint32_t index_bits = endpoints.m_index_bits;
+        std::uint32_t secondary_index_bits = endpoints.m_secondary_index_bits;
+        BCBitReader reader(block);
+        reader.setPosition(endpoints.m_index_offset);
+
+        std::uint32_t indices[16] = {};
+        std::uint32_t secondary_indices[16] = {};
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            std::uint32_t subset = getBCPartitionSubset(subset_count, partition, pixel);
+            bool is_anchor = pixel == getBCAnchorIndex(subset_count, partition, subset);
+            indices[pixel] = reader.read(is_anchor ? index_bits - 1 : index_bits);
+        }
+        if(secondary_index_bits != 0)
+        {
+            for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+            {
+                secondary_indices[pixel] = reader.read(pixel == 0 ? secondary_index_bits - 1 : secondary_index_bits);
+            }
+        }
+
+        const std::uint8_t* weights = getBCWeights(index_bits);
+        const std::uint8_t* secondary_weights = getBCWeights(secondary_index_bits);
+
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            std::uint32_t subset = getBCPartitionSubset(subset_count, partition, pixel);
+            const std::uint8_t* endpoint0 = endpoints.m_endpoints[subset * 2];
+            const std::uint8_t* endpoint1 = endpoints.m_endpoints[subset * 2 + 1];
+
+            std::uint32_t color_weight = weights[indices[pixel]];
+            std::uint32_t alpha_weight = color_weight;
+            if(secondary_index_bits != 0)
+            {
+                if(endpoints.m_index_selection == 0)
+                {
+                    alpha_weight = secondary_weights[secondary_indices[pixel]];
+                }
+                else
+                {
+                    color_weight = secondary_weights[secondary_indices[pixel]];
+                    alpha_weight = weights[indices[pixel]];
+                }
+            }
+
+            std::uint32_t channels[4];
+            for(std::uint32_t channel = 0; channel < 4; ++channel)
+            {
+                std::uint32_t weight = channel < 3 ? color_weight : alpha_weight;
+                channels[channel] = ((64 - weight) * endpoint0[channel] + weight * endpoint1[channel] + 32) >> 6;
+            }
+
+            if(endpoints.m_rotation != 0)
+            {
+                std::swap(channels[3], channels[endpoints.m_rotation - 1]);
+            }
+
+            std::uint32_t color = packBCColor(channels[0], channels[1], channels[2], channels[3], swap_red_blue);
+            std::memcpy(destination + (pixel / 4) * destination_row_pitch + (pixel % 4) * sizeof(color), &color, sizeof(color));
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+
+    const BCBlockDecoders& getScalarBCBlockDecoders()
+    {
+        static const BCBlockDecoders decoders =
+        {
+            decodeBC1BlockScalar,
+            decodeBC2BlockScalar,
+            decodeBC3BlockScalar,
+            decodeBC4UnormBlockScalar,
+            decodeBC4SnormBlockScalar,
+            decodeBC5UnormBlockScalar,
+            decodeBC5SnormBlockScalar,
+            decodeBC6HUfloatBlockScalar,
+            decodeBC6HSfloatBlockScalar,
+            decodeBC7BlockScalar,
+        };
+        return decoders;
+    }
+
+    const BCBlockDecoders& getBCBlockDecoders(SimdLevel simd_level)
+    {
+#if ARIEO_IMAGE_LOADER_X86
+        static const BCBlockDecoders sse41_decoders = []()
+        {
+            BCBlockDecoders decoders = getScalarBCBlockDecoders();
+            fillSSE41BCBlockDecoders(decoders);
+            return decoders;
+        }();
+        static const BCBlockDecoders avx2_decoders = []()
+        {
+            BCBlockDecoders decoders = sse41_decoders;
+            fillAVX2BCBlockDecoders(decoders);
+            return decoders;
+        }();
+
+        switch(simd_level)
+        {
+        case SimdLevel::AVX2: return avx2_decoders;
+        case SimdLevel::SSE41: return sse41_decoders;
+        default: break;
+        }
+#endif
+        return getScalarBCBlockDecoders();
+    }
+
+    Interface::RHI::Format getBCDecodedFormat(Interface::RHI::Format format)
+    {
+        switch(format)
+        {
+        case Interface::RHI::Format::BC1_RGB_UNORM_BLOCK:
+        case Interface::RHI::Format::BC2_UNORM_BLOCK:
+        case Interface::RHI::Format::BC3_UNORM_BLOCK:
+        case Interface::RHI::Format::BC7_UNORM_BLOCK:
+            return Interface::RHI::Format::R8G8B8A8_UNORM;
+        case Interface::RHI::Format::BC1_RGB_SRGB_BLOCK:
+        case Interface::RHI::Format::BC2_SRGB_BLOCK:
+        case Interface::RHI::Format::BC3_SRGB_BLOCK:
+        case Interface::RHI::Format::BC7_SRGB_BLOCK:
+            return Interface::RHI::Format::B8G8R8A8_SRGB;
+        case Interface::RHI::Format::BC4_UNORM_BLOCK:
+            return Interface::RHI::Format::R8_UNORM;
+        case Interface::RHI::Format::BC4_SNORM_BLOCK:
+            return Interface::RHI::Format::R8_SNORM;
+        case Interface::RHI::Format::BC5_UNORM_BLOCK:
+            return Interface::RHI::Format::R8G8_UNORM;
+        case Interface::RHI::Format::BC5_SNORM_BLOCK:
+            return Interface::RHI::Format::R8G8_SNORM;
+        case Interface::RHI::Format::BC6H_UFLOAT_BLOCK:
+        case Interface::RHI::Format::BC6H_SFLOAT_BLOCK:
+            return Interface::RHI::Format::R16G16B16A16_SFLOAT;
+        default:
+            return Interface::RHI::Format::UNKNOWN;
+        }
+    }
+
+    static BCBlockDecodeFunc selectBCBlockDecoder(const BCBlockDecoders& decoders, Interface::RHI::Format format)
+    {
+        switch(format)
+        {
+        case Interface::RHI::Format::BC1_RGB_UNORM_BLOCK:
+        case Interface::RHI::Format::BC1_RGB_SRGB_BLOCK:
+            return decoders.m_bc1;
+        case Interface::RHI::Format::BC2_UNORM_BLOCK:
+        case Interface::RHI::Format::BC2_SRGB_BLOCK:
+            return decoders.m_bc2;
+        case Interface::RHI::Format::BC3_UNORM_BLOCK:
+        case Interface::RHI::Format::BC3_SRGB_BLOCK:
+            return decoders.m_bc3;
+        case Interface::RHI::Format::BC4_UNORM_BLOCK:
+            return decoders.m_bc4_unorm;
+        case Interface::RHI::Format::BC4_SNORM_BLOCK:
+            return decoders.m_bc4_snorm;
+        case Interface::RHI::Format::BC5_UNORM_BLOCK:
+            return decoders.m_bc5_unorm;
+        case Interface::RHI::Format::BC5_SNORM_BLOCK:
+            return decoders.m_bc5_snorm;
+        case Interface::RHI::Format::BC6H_UFLOAT_BLOCK:
+            return decoders.m_bc6h_ufloat;
+        case Interface::RHI::Format::BC6H_SFLOAT_BLOCK:
+            return decoders.m_bc6h_sfloat;
+        case Interface::RHI::Format::BC7_UNORM_BLOCK:
+        case Interface::RHI::Format::BC7_SRGB_BLOCK:
+            return decoders.m_bc7;
+        default:
+            return nullptr;
+        }
+    }
+
+    void decodeBCBlockRows(
+        Interface::RHI::Format format,
+        SimdLevel simd_level,
+        const void* source,
+        size_t source_row_pitch,
+        void* destination,
+        size_t destination_row_pitch,
+        std::uint32_t width,
+        std::uint32_t height,
+        std::uint32_t first_block_row,
+        std::uint32_t block_row_count)
+    {
+        BCBlockDecodeFunc decode_block = selectBCBlockDecoder(getBCBlockDecoders(simd_level), format);
+        Interface::RHI::Format decoded_format = getBCDecodedFormat(format);
+        if(decode_block == nullptr || decoded_format == Interface::RHI::Format::UNKNOWN)
+        {
+            return;
+        }
+
+        size_t block_size = getImageFormatInfo(format).m_bytes_per_block;
+        size_t texel_size = getImageFormatInfo(decoded_format).m_bytes_per_block;
+        bool swap_red_blue = decoded_format == Interface::RHI::Format::B8G8R8A8_SRGB;
+        std::uint32_t block_column_count = (width + 3) / 4;
+
+        for(std::uint32_t block_row = first_block_row; block_row < first_block_row + block_row_count; ++block_row)
+        {
+            const std::uint8_t* source_row = (const std::uint8_t*)source + block_row * source_row_pitch;
+            std::uint32_t y = block_row * 4;
+            std::uint32_t rows = std::min<std::uint32_t>(4, height - y);
+
+            for(std::uint32_t block_column = 0; block_column < block_column_count; ++block_column)
+            {
+                const std::uint8_t* block = source_row + block_column * block_size;
+                std::uint32_t x = block_column * 4;
+                std::uint32_t columns = std::min<std::uint32_t>(4, width - x);
+                std::uint8_t* target = (std::uint8_t*)destination + y * destination_row_pitch + x * texel_size;
+
+                if(rows == 4 && columns == 4)
+                {
+                    decode_block(block, target, destination_row_pitch, swap_red_blue);
+                    continue;
+                }
+
+                // Edge block, decode aside and keep only the texels inside the image.
+                std::uint8_t decoded_block[4 * 4 * 8];
+                decode_block(block, decoded_block, 4 * texel_size, swap_red_blue);
+                for(std::uint32_t row = 0; row < rows; ++row)
+                {
+                    std::memcpy(target + row * destination_row_pitch, decoded_block + row * 4 * texel_size, columns * texel_size);
+                }
+            }
+        }
+    }
+}
\ No newline at end of file
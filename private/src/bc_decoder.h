@@ -0,0 +1,84 @@
+#pragma once
+#include "interface/file_loader/image_loader.h"
+#include "cpu_features.h"
+#include <cstdint>
+namespace Arieo
+{
+    // Writes one decoded 4x4 block; rows are destination_row_pitch bytes apart.
+    using BCBlockDecodeFunc = void (*)(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool swap_red_blue);
+
+    struct BCBlockDecoders
+    {
+        BCBlockDecodeFunc m_bc1 = nullptr;
+        BCBlockDecodeFunc m_bc2 = nullptr;
+        BCBlockDecodeFunc m_bc3 = nullptr;
+        BCBlockDecodeFunc m_bc4_unorm = nullptr;
+        BCBlockDecodeFunc m_bc4_snorm = nullptr;
+        BCBlockDecodeFunc m_bc5_unorm = nullptr;
+        BCBlockDecodeFunc m_bc5_snorm = nullptr;
+        BCBlockDecodeFunc m_bc6h_ufloat = nullptr;
+        BCBlockDecodeFunc m_bc6h_sfloat = nullptr;
+        BCBlockDecodeFunc m_bc7 = nullptr;
+    };
+
+    // Endpoints of one BC6H block unquantized to 16 bits. Read by the scalar
+    // decoder and the SIMD kernels alike, they only differ in the per texel work.
+    struct BC6HEndpoints
+    {
+        std::uint32_t m_subset_count = 0;
+        std::uint32_t m_partition = 0;
+        // First bit of the indices.
+        std::uint32_t m_index_offset = 0;
+        // [subset * 2 + end][channel]
+        std::int32_t m_endpoints[4][3] = {};
+    };
+
+    // False for reserved modes, which decode to black.
+    bool readBC6HEndpoints(const std::uint8_t* block, bool is_signed, BC6HEndpoints& endpoints);
+
+    // Same for BC7, endpoints unquantized to 8 bits.
+    struct BC7Endpoints
+    {
+        std::uint32_t m_subset_count = 0;
+        std::uint32_t m_partition = 0;
+        std::uint32_t m_rotation = 0;
+        std::uint32_t m_index_selection = 0;
+        std::uint32_t m_index_bits = 0;
+        std::uint32_t m_secondary_index_bits = 0;
+        // First bit of the primary indices, the secondary ones follow them.
+        std::uint32_t m_index_offset = 0;
+        // [subset * 2 + end][channel]
+        std::uint8_t m_endpoints[6][4] = {};
+    };
+
+    // False for the reserved mode, which decodes to transparent black.
+    bool readBC7Endpoints(const std::uint8_t* block, BC7Endpoints& endpoints);
+
+    // The scalar decoders are the reference, every SIMD kernel has to match them bit for bit.
+    const BCBlockDecoders& getScalarBCBlockDecoders();
+#if ARIEO_IMAGE_LOADER_X86
+    // Kernels not implemented for a level fall back to the scalar ones.
+    void fillSSE41BCBlockDecoders(BCBlockDecoders& decoders);
+    void fillAVX2BCBlockDecoders(BCBlockDecoders& decoders);
+#endif
+    const BCBlockDecoders& getBCBlockDecoders(SimdLevel simd_level);
+
+    // Uncompressed format a block compressed format decodes to, UNKNOWN if not
+    // decodable. sRGB formats decode to B8G8R8A8_SRGB.
+    Interface::RHI::Format getBCDecodedFormat(Interface::RHI::Format format);
+
+    // Decodes block rows [first_block_row, first_block_row + block_row_count) of
+    // one slice. source and destination point at the first row of the slice.
+    void decodeBCBlockRows(
+        Interface::RHI::Format format,
+        SimdLevel simd_level,
+        const void* source,
+        size_t source_row_pitch,
+        void* destination,
+        size_t destination_row_pitch,
+        std::uint32_t width,
+        std::uint32_t height,
+        std::uint32_t first_block_row,
+        std::uint32_t block_row_count
+    );
+}
\ No newline at end of file
@@ -0,0 +1,740 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "bc_decoder.h"
+#include "bc_common.h"
+#include "bc_tables.h"
+
+#if ARIEO_IMAGE_LOADER_X86
+#include <immintrin.h>
+#include <cstring>
+#include <utility>
+
+// Palettes are built by the shared scalar helpers, the kernels here only
+// vectorise the index expansion and texel writes. That keeps them bit exact
+// with the scalar reference by construction. BC6H and BC7 work the same way:
+// endpoints come from readBC6HEndpoints / readBC7Endpoints, weights, subset
+// selection and interpolation run here.
+
+namespace Arieo
+{
+    // Index bits of a BC6H or BC7 block starting at offset, with the implicit
+    // zero top bit of every anchor restored so each pixel takes bits bits.
+    static inline std::uint64_t readBCIndexStream(const std::uint8_t* block, std::uint32_t offset, std::uint32_t bits, std::uint32_t anchor_second, std::uint32_t anchor_third)
+    {
+        std::uint64_t low = readBCUint64(block);
+        std::uint64_t high = readBCUint64(block + 8);
+        std::uint64_t indices = offset >= 64 ? high >> (offset - 64) : (low >> offset) | (high << (64 - offset));
+
+        std::uint32_t anchors[3] = {0, anchor_second, anchor_third};
+        std::uint32_t anchor_count = 1 + (anchor_second != 0) + (anchor_third != 0);
+        if(anchor_count == 3 && anchors[1] > anchors[2])
+        {
+            std::swap(anchors[1], anchors[2]);
+        }
+        indices &= ((std::uint64_t)1 << (16 * bits - anchor_count)) - 1;
+
+        // Ascending order, so every earlier insertion has already shifted the later anchors into place.
+        for(std::uint32_t anchor = 0; anchor < anchor_count; ++anchor)
+        {
+            std::uint32_t top_bit = bits * (anchors[anchor] + 1) - 1;
+            std::uint64_t below = indices & (((std::uint64_t)1 << top_bit) - 1);
+            indices = below | ((indices >> top_bit) << (top_bit + 1));
+        }
+        return indices;
+    }
+
+    // What the BC7 kernels need of one block beyond the raw index streams.
+    struct BC7KernelBlock
+    {
+        // Endpoint bytes by [4 * subset + output channel], swap and rotation applied.
+        std::uint8_t m_endpoint0[16] = {};
+        std::uint8_t m_endpoint1[16] = {};
+        // 0xFF for the output channels interpolated with the alpha weights, per texel.
+        std::uint8_t m_alpha_channels[16] = {};
+        std::uint64_t m_color_indices = 0;
+        std::uint64_t m_alpha_indices = 0;
+        std::uint32_t m_color_index_bits = 0;
+        std::uint32_t m_alpha_index_bits = 0;
+        // 0, 1 or 2 bits per pixel.
+        std::uint32_t m_subsets = 0;
+        std::uint32_t m_subset_bits = 0;
+    };
+
+    static void prepareBC7KernelBlock(const std::uint8_t* block, const BC7Endpoints& endpoints, bool swap_red_blue, BC7KernelBlock& kernel_block)
+    {
+        std::uint32_t partition = endpoints.m_partition;
+        std::uint32_t anchor_second = 0;
+        std::uint32_t anchor_third = 0;
+        if(endpoints.m_subset_count == 2)
+        {
+            anchor_second = g_bc_anchor_2_subset_second[partition];
+            kernel_block.m_subsets = g_bc_partitions_2_subset[partition];
+            kernel_block.m_subset_bits = 1;
+        }
+        else if(endpoints.m_subset_count == 3)
+        {
+            anchor_second = g_bc_anchor_3_subset_second[partition];
+            anchor_third = g_bc_anchor_3_subset_third[partition];
+            kernel_block.m_subsets = g_bc_partitions_3_subset[partition];
+            kernel_block.m_subset_bits = 2;
+        }
+
+        std::uint64_t indices = readBCIndexStream(block, endpoints.m_index_offset, endpoints.m_index_bits, anchor_second, anchor_third);
+        kernel_block.m_color_indices = indices;
+        kernel_block.m_color_index_bits = endpoints.m_index_bits;
+        kernel_block.m_alpha_indices = indices;
+        kernel_block.m_alpha_index_bits = endpoints.m_index_bits;
+        if(endpoints.m_secondary_index_bits != 0)
+        {
+            std::uint32_t secondary_offset = endpoints.m_index_offset + 16 * endpoints.m_index_bits - endpoints.m_subset_count;
+            std::uint64_t secondary_indices = readBCIndexStream(block, secondary_offset, endpoints.m_secondary_index_bits, 0, 0);
+            if(endpoints.m_index_selection == 0)
+            {
+                kernel_block.m_alpha_indices = secondary_indices;
+                kernel_block.m_alpha_index_bits = endpoints.m_secondary_index_bits;
+            }
+            else
+            {
+                kernel_block.m_color_indices = secondary_indices;
+                kernel_block.m_color_index_bits = endpoints.m_secondary_index_bits;
+            }
+        }
+
+        std::uint32_t rotation = endpoints.m_rotation;
+        for(std::uint32_t position = 0; position < 4; ++position)
+        {
+            std::uint32_t channel = (swap_red_blue && position != 3) ? 2 - position : position;
+            std::uint32_t source = channel;
+            bool is_alpha_weighted = channel == 3;
+            if(rotation != 0 && channel == rotation - 1)
+            {
+                source = 3;
+                is_alpha_weighted = true;
+            }
+            else if(rotation != 0 && channel == 3)
+            {
+                source = rotation - 1;
+                is_alpha_weighted = false;
+            }
+
+            for(std::uint32_t subset = 0; subset < endpoints.m_subset_count; ++subset)
+            {
+                kernel_block.m_endpoint0[subset * 4 + position] = endpoints.m_endpoints[subset * 2][source];
+                kernel_block.m_endpoint1[subset * 4 + position] = endpoints.m_endpoints[subset * 2 + 1][source];
+            }
+            for(std::uint32_t texel = 0; texel < 4; ++texel)
+            {
+                kernel_block.m_alpha_channels[texel * 4 + position] = is_alpha_weighted ? 0xFF : 0;
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // SSE4.1
+
+    // Four 2 bit indices of one row to the matching four palette colours.
+    ARIEO_TARGET_SSE41 static inline __m128i expandBC1RowSSE41(__m128i palette, std::uint32_t row_indices)
+    {
+        // Multiplying moves each lane's index to bits 6..7, a variable shift without AVX2.
+        __m128i indices = _mm_mullo_epi32(_mm_set1_epi32((int)row_indices), _mm_setr_epi32(1 << 6, 1 << 4, 1 << 2, 1));
+        indices = _mm_and_si128(_mm_srli_epi32(indices, 6), _mm_set1_epi32(0x3));
+        __m128i shuffle = _mm_add_epi32(
+            _mm_mullo_epi32(_mm_slli_epi32(indices, 2), _mm_set1_epi32(0x01010101)),
+            _mm_set1_epi32(0x03020100)
+        );
+        return _mm_shuffle_epi8(palette, shuffle);
+    }
+
+    // Sixteen indices of bits bits each, pixel 0 lowest, to one byte per pixel.
+    ARIEO_TARGET_SSE41 static inline __m128i unpackBCIndicesSSE41(std::uint64_t indices, std::uint32_t bits)
+    {
+        const __m128i multipliers = _mm_setr_epi32(1 << (bits * 3), 1 << (bits * 2), 1 << bits, 1);
+        const __m128i shift = _mm_cvtsi32_si128((int)(bits * 3));
+        const __m128i mask = _mm_set1_epi32((1 << bits) - 1);
+        const std::uint32_t row_bits = bits * 4;
+
+        __m128i rows[4];
+        for(std::uint32_t y = 0; y < 4; ++y)
+        {
+            std::uint32_t row_indices = (std::uint32_t)((indices >> (y * row_bits)) & ((1u << row_bits) - 1));
+            __m128i row = _mm_mullo_epi32(_mm_set1_epi32((int)row_indices), multipliers);
+            rows[y] = _mm_and_si128(_mm_srl_epi32(row, shift), mask);
+        }
+        return _mm_packus_epi16(_mm_packus_epi32(rows[0], rows[1]), _mm_packus_epi32(rows[2], rows[3]));
+    }
+
+    // Sixteen 3 bit BC4 indices to sixteen palette bytes.
+    ARIEO_TARGET_SSE41 static inline __m128i expandBC4SSE41(const std::uint8_t* block, __m128i palette)
+    {
+        return _mm_shuffle_epi8(palette, unpackBCIndicesSSE41(readBC4Indices(block), 3));
+    }
+
+    ARIEO_TARGET_SSE41 static inline __m128i loadBC4PaletteUnormSSE41(const std::uint8_t* block)
+    {
+        std::uint8_t palette[8];
+        buildBC4PaletteUnorm(block, palette);
+        return _mm_loadl_epi64((const __m128i*)palette);
+    }
+
+    ARIEO_TARGET_SSE41 static inline __m128i loadBC4PaletteSnormSSE41(const std::uint8_t* block)
+    {
+        std::int8_t palette[8];
+        buildBC4PaletteSnorm(block, palette);
+        return _mm_loadl_epi64((const __m128i*)palette);
+    }
+
+    // Replaces the alpha byte of four RGBA texels of row y with alpha[4y .. 4y+3].
+    ARIEO_TARGET_SSE41 static inline __m128i insertAlphaRowSSE41(__m128i colors, __m128i alpha, std::uint32_t y)
+    {
+        const char z = (char)0x80;
+        const char a = (char)(y * 4);
+        __m128i shuffle = _mm_setr_epi8(z, z, z, a, z, z, z, (char)(a + 1), z, z, z, (char)(a + 2), z, z, z, (char)(a + 3));
+        return _mm_or_si128(
+            _mm_and_si128(colors, _mm_set1_epi32(0x00FFFFFF)),
+            _mm_shuffle_epi8(alpha, shuffle)
+        );
+    }
+
+    ARIEO_TARGET_SSE41 static void writeBCColorBlockSSE41(const std::uint8_t* color_block, const __m128i* alpha, std::uint8_t* destination, size_t destination_row_pitch, bool allow_three_color, bool swap_red_blue)
+    {
+        std::uint32_t palette[4];
+        buildBC1Palette(color_block, allow_three_color, swap_red_blue, palette);
+        __m128i palette_vector = _mm_loadu_si128((const __m128i*)palette);
+        std::uint32_t indices = readBCUint32(color_block + 4);
+
+        for(std::uint32_t y = 0; y < 4; ++y)
+        {
+            __m128i row = expandBC1RowSSE41(palette_vector, (indices >> (y * 8)) & 0xFF);
+            if(alpha != nullptr)
+            {
+                row = insertAlphaRowSSE41(row, *alpha, y);
+            }
+            _mm_storeu_si128((__m128i*)(destination + y * destination_row_pitch), row);
+        }
+    }
+
+    ARIEO_TARGET_SSE41 static void decodeBC1BlockSSE41(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool swap_red_blue)
+    {
+        writeBCColorBlockSSE41(block, nullptr, destination, destination_row_pitch, true, swap_red_blue);
+    }
+
+    ARIEO_TARGET_SSE41 static void decodeBC2BlockSSE41(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool swap_red_blue)
+    {
+        __m128i nibbles = _mm_loadl_epi64((const __m128i*)block);
+        __m128i low = _mm_and_si128(nibbles, _mm_set1_epi8(0x0F));
+        __m128i high = _mm_and_si128(_mm_srli_epi16(nibbles, 4), _mm_set1_epi8(0x0F));
+        __m128i alpha = _mm_unpacklo_epi8(low, high);
+        alpha = _mm_or_si128(alpha, _mm_slli_epi16(alpha, 4));
+
+        writeBCColorBlockSSE41(block + 8, &alpha, destination, destination_row_pitch, false, swap_red_blue);
+    }
+
+    ARIEO_TARGET_SSE41 static void decodeBC3BlockSSE41(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool swap_red_blue)
+    {
+        __m128i alpha = expandBC4SSE41(block, loadBC4PaletteUnormSSE41(block));
+        writeBCColorBlockSSE41(block + 8, &alpha, destination, destination_row_pitch, false, swap_red_blue);
+    }
+
+    ARIEO_TARGET_SSE41 static void writeBC4BlockSSE41(__m128i red, std::uint8_t* destination, size_t destination_row_pitch)
+    {
+        std::uint32_t rows[4] =
+        {
+            (std::uint32_t)_mm_extract_epi32(red, 0),
+            (std::uint32_t)_mm_extract_epi32(red, 1),
+            (std::uint32_t)_mm_extract_epi32(red, 2),
+            (std::uint32_t)_mm_extract_epi32(red, 3),
+        };
+        for(std::uint32_t y = 0; y < 4; ++y)
+        {
+            std::memcpy(destination + y * destination_row_pitch, &rows[y], sizeof(rows[y]));
+        }
+    }
+
+    ARIEO_TARGET_SSE41 static void writeBC5BlockSSE41(__m128i red, __m128i green, std::uint8_t* destination, size_t destination_row_pitch)
+    {
+        __m128i rows01 = _mm_unpacklo_epi8(red, green);
+        __m128i rows23 = _mm_unpackhi_epi8(red, green);
+        _mm_storel_epi64((__m128i*)(destination + 0 * destination_row_pitch), rows01);
+        _mm_storel_epi64((__m128i*)(destination + 1 * destination_row_pitch), _mm_srli_si128(rows01, 8));
+        _mm_storel_epi64((__m128i*)(destination + 2 * destination_row_pitch), rows23);
+        _mm_storel_epi64((__m128i*)(destination + 3 * destination_row_pitch), _mm_srli_si128(rows23, 8));
+    }
+
+    ARIEO_TARGET_SSE41 static void decodeBC4UnormBlockSSE41(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        writeBC4BlockSSE41(expandBC4SSE41(block, loadBC4PaletteUnormSSE41(block)), destination, destination_row_pitch);
+    }
+
+    ARIEO_TARGET_SSE41 static void decodeBC4SnormBlockSSE41(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        writeBC4BlockSSE41(expandBC4SSE41(block, loadBC4PaletteSnormSSE41(block)), destination, destination_row_pitch);
+    }
+
+    ARIEO_TARGET_SSE41 static void decodeBC5UnormBlockSSE41(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        writeBC5BlockSSE41(
+            expandBC4SSE41(block, loadBC4PaletteUnormSSE41(block)),
+            expandBC4SSE41(block + 8, loadBC4PaletteUnormSSE41(block + 8)),
+            destination,
+            destination_row_pitch
+        );
+    }
+
+    ARIEO_TARGET_SSE41 static void decodeBC5SnormBlockSSE41(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        writeBC5BlockSSE41(
+            expandBC4SSE41(block, loadBC4PaletteSnormSSE41(block)),
+            expandBC4SSE41(block + 8, loadBC4PaletteSnormSSE41(block + 8)),
+            destination,
+            destination_row_pitch
+        );
+    }
+
+    // Interpolation weight of each of the sixteen pixels.
+    ARIEO_TARGET_SSE41 static inline __m128i expandBCWeightsSSE41(std::uint64_t indices, std::uint32_t index_bits)
+    {
+        std::uint8_t weight_table[16] = {};
+        std::memcpy(weight_table, getBCWeights(index_bits), (size_t)1 << index_bits);
+        return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)weight_table), unpackBCIndicesSSE41(indices, index_bits));
+    }
+
+    // Interpolated value to half bits, as finishBC6HUnquantize.
+    ARIEO_TARGET_SSE41 static inline __m128i finishBC6HSSE41(__m128i value, bool is_signed)
+    {
+        if(is_signed == false)
+        {
+            return _mm_srli_epi32(_mm_mullo_epi32(value, _mm_set1_epi32(31)), 6);
+        }
+        __m128i magnitude = _mm_srli_epi32(_mm_mullo_epi32(_mm_abs_epi32(value), _mm_set1_epi32(31)), 5);
+        __m128i sign = _mm_and_si128(_mm_cmpgt_epi32(_mm_setzero_si128(), value), _mm_set1_epi32(0x8000));
+        return _mm_or_si128(magnitude, sign);
+    }
+
+    ARIEO_TARGET_SSE41 static void decodeBC6HBlockSSE41(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool is_signed)
+    {
+        BC6HEndpoints endpoints;
+        if(readBC6HEndpoints(block, is_signed, endpoints) == false)
+        {
+            for(std::uint32_t y = 0; y < 4; ++y)
+            {
+                _mm_storeu_si128((__m128i*)(destination + y * destination_row_pitch), _mm_setzero_si128());
+                _mm_storeu_si128((__m128i*)(destination + y * destination_row_pitch + 16), _mm_setzero_si128());
+            }
+            return;
+        }
+
+        bool is_partitioned = endpoints.m_subset_count == 2;
+        std::uint32_t index_bits = is_partitioned ? 3 : 4;
+        std::uint32_t anchor_second = is_partitioned ? g_bc_anchor_2_subset_second[endpoints.m_partition] : 0;
+        std::uint64_t indices = readBCIndexStream(block, endpoints.m_index_offset, index_bits, anchor_second, 0);
+        __m128i weights = expandBCWeightsSSE41(indices, index_bits);
+        // 0xFF for the pixels of the second subset.
+        __m128i subsets = is_partitioned
+            ? _mm_sub_epi8(_mm_setzero_si128(), unpackBCIndicesSSE41(g_bc_partitions_2_subset[endpoints.m_partition], 1))
+            : _mm_setzero_si128();
+
+        const __m128i rounding = _mm_set1_epi32(32);
+        const __m128i alpha = _mm_set1_epi32(0x3C00);
+        for(std::uint32_t y = 0; y < 4; ++y)
+        {
+            __m128i weight1 = _mm_cvtepu8_epi32(weights);
+            __m128i weight0 = _mm_sub_epi32(_mm_set1_epi32(64), weight1);
+            __m128i second_subset = _mm_cvtepi8_epi32(subsets);
+
+            __m128i channels[3];
+            for(std::uint32_t channel = 0; channel < 3; ++channel)
+            {
+                __m128i endpoint0 = _mm_blendv_epi8(_mm_set1_epi32(endpoints.m_endpoints[0][channel]), _mm_set1_epi32(endpoints.m_endpoints[2][channel]), second_subset);
+                __m128i endpoint1 = _mm_blendv_epi8(_mm_set1_epi32(endpoints.m_endpoints[1][channel]), _mm_set1_epi32(endpoints.m_endpoints[3][channel]), second_subset);
+                __m128i value = _mm_add_epi32(_mm_mullo_epi32(weight0, endpoint0), _mm_mullo_epi32(weight1, endpoint1));
+                channels[channel] = finishBC6HSSE41(_mm_srai_epi32(_mm_add_epi32(value, rounding), 6), is_signed);
+            }
+
+            __m128i red_green = _mm_packus_epi32(channels[0], channels[1]);
+            __m128i blue_alpha = _mm_packus_epi32(channels[2], alpha);
+            __m128i red_blue = _mm_unpacklo_epi16(red_green, blue_alpha);
+            __m128i green_alpha = _mm_unpackhi_epi16(red_green, blue_alpha);
+            std::uint8_t* row = destination + y * destination_row_pitch;
+            _mm_storeu_si128((__m128i*)row, _mm_unpacklo_epi16(red_blue, green_alpha));
+            _mm_storeu_si128((__m128i*)(row + 16), _mm_unpackhi_epi16(red_blue, green_alpha));
+
+            weights = _mm_srli_si128(weights, 4);
+            subsets = _mm_srli_si128(subsets, 4);
+        }
+    }
+
+    ARIEO_TARGET_SSE41 static void decodeBC6HUfloatBlockSSE41(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        decodeBC6HBlockSSE41(block, destination, destination_row_pitch, false);
+    }
+
+    ARIEO_TARGET_SSE41 static void decodeBC6HSfloatBlockSSE41(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        decodeBC6HBlockSSE41(block, destination, destination_row_pitch, true);
+    }
+
+    ARIEO_TARGET_SSE41 static void decodeBC7BlockSSE41(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool swap_red_blue)
+    {
+        BC7Endpoints endpoints;
+        if(readBC7Endpoints(block, endpoints) == false)
+        {
+            for(std::uint32_t y = 0; y < 4; ++y)
+            {
+                _mm_storeu_si128((__m128i*)(destination + y * destination_row_pitch), _mm_setzero_si128());
+            }
+            return;
+        }
+
+        BC7KernelBlock kernel_block;
+        prepareBC7KernelBlock(block, endpoints, swap_red_blue, kernel_block);
+
+        __m128i color_weights = expandBCWeightsSSE41(kernel_block.m_color_indices, kernel_block.m_color_index_bits);
+        __m128i alpha_weights = expandBCWeightsSSE41(kernel_block.m_alpha_indices, kernel_block.m_alpha_index_bits);
+        __m128i subsets = kernel_block.m_subset_bits != 0
+            ? unpackBCIndicesSSE41(kernel_block.m_subsets, kernel_block.m_subset_bits)
+            : _mm_setzero_si128();
+
+        const __m128i endpoint0_table = _mm_loadu_si128((const __m128i*)kernel_block.m_endpoint0);
+        const __m128i endpoint1_table = _mm_loadu_si128((const __m128i*)kernel_block.m_endpoint1);
+        const __m128i alpha_channels = _mm_loadu_si128((const __m128i*)kernel_block.m_alpha_channels);
+        const __m128i positions = _mm_set1_epi32(0x03020100);
+        const __m128i rounding = _mm_set1_epi16(32);
+        __m128i texels = _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+        for(std::uint32_t y = 0; y < 4; ++y)
+        {
+            // Subsets are at most 2, so the shift by 2 stays inside each byte.
+            __m128i table_index = _mm_add_epi8(_mm_slli_epi16(_mm_shuffle_epi8(subsets, texels), 2), positions);
+            __m128i endpoint0 = _mm_shuffle_epi8(endpoint0_table, table_index);
+            __m128i endpoint1 = _mm_shuffle_epi8(endpoint1_table, table_index);
+            __m128i weight1 = _mm_blendv_epi8(_mm_shuffle_epi8(color_weights, texels), _mm_shuffle_epi8(alpha_weights, texels), alpha_channels);
+            __m128i weight0 = _mm_sub_epi8(_mm_set1_epi8(64), weight1);
+
+            __m128i low = _mm_maddubs_epi16(_mm_unpacklo_epi8(endpoint0, endpoint1), _mm_unpacklo_epi8(weight0, weight1));
+            __m128i high = _mm_maddubs_epi16(_mm_unpackhi_epi8(endpoint0, endpoint1), _mm_unpackhi_epi8(weight0, weight1));
+            low = _mm_srli_epi16(_mm_add_epi16(low, rounding), 6);
+            high = _mm_srli_epi16(_mm_add_epi16(high, rounding), 6);
+            _mm_storeu_si128((__m128i*)(destination + y * destination_row_pitch), _mm_packus_epi16(low, high));
+
+            texels = _mm_add_epi8(texels, _mm_set1_epi8(4));
+        }
+    }
+
+    void fillSSE41BCBlockDecoders(BCBlockDecoders& decoders)
+    {
+        decoders.m_bc1 = decodeBC1BlockSSE41;
+        decoders.m_bc2 = decodeBC2BlockSSE41;
+        decoders.m_bc3 = decodeBC3BlockSSE41;
+        decoders.m_bc4_unorm = decodeBC4UnormBlockSSE41;
+        decoders.m_bc4_snorm = decodeBC4SnormBlockSSE41;
+        decoders.m_bc5_unorm = decodeBC5UnormBlockSSE41;
+        decoders.m_bc5_snorm = decodeBC5SnormBlockSSE41;
+        decoders.m_bc6h_ufloat = decodeBC6HUfloatBlockSSE41;
+        decoders.m_bc6h_sfloat = decodeBC6HSfloatBlockSSE41;
+        decoders.m_bc7 = decodeBC7BlockSSE41;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // AVX2, two rows per register and real variable shifts for index extraction.
+
+    ARIEO_TARGET_AVX2 static inline __m256i expandBC1RowPairAVX2(__m256i palette, std::uint32_t indices, __m256i shifts)
+    {
+        __m256i lanes = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32((int)indices), shifts), _mm256_set1_epi32(0x3));
+        __m256i shuffle = _mm256_add_epi32(
+            _mm256_mullo_epi32(_mm256_slli_epi32(lanes, 2), _mm256_set1_epi32(0x01010101)),
+            _mm256_set1_epi32(0x03020100)
+        );
+        return _mm256_shuffle_epi8(palette, shuffle);
+    }
+
+    // Sixteen indices of bits bits each, pixel 0 lowest, to one byte per pixel.
+    ARIEO_TARGET_AVX2 static inline __m128i unpackBCIndicesAVX2(std::uint64_t indices, std::uint32_t bits)
+    {
+        const __m256i shifts = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((int)bits));
+        const __m256i mask = _mm256_set1_epi32((1 << bits) - 1);
+        const std::uint32_t half_bits = bits * 8;
+
+        std::uint32_t first_indices = (std::uint32_t)(indices & (((std::uint64_t)1 << half_bits) - 1));
+        std::uint32_t second_indices = (std::uint32_t)(indices >> half_bits);
+        __m256i first = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32((int)first_indices), shifts), mask);
+        __m256i second = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32((int)second_indices), shifts), mask);
+
+        // packus works per 128 bit lane, restore pixel order afterwards.
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(first, second), _MM_SHUFFLE(3, 1, 2, 0));
+        return _mm_packus_epi16(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1));
+    }
+
+    ARIEO_TARGET_AVX2 static inline __m128i expandBC4AVX2(const std::uint8_t* block, __m128i palette)
+    {
+        return _mm_shuffle_epi8(palette, unpackBCIndicesAVX2(readBC4Indices(block), 3));
+    }
+
+    ARIEO_TARGET_AVX2 static void writeBCColorBlockAVX2(const std::uint8_t* color_block, const __m128i* alpha, std::uint8_t* destination, size_t destination_row_pitch, bool allow_three_color, bool swap_red_blue)
+    {
+        std::uint32_t palette[4];
+        buildBC1Palette(color_block, allow_three_color, swap_red_blue, palette);
+        __m256i palette_vector = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)palette));
+        std::uint32_t indices = readBCUint32(color_block + 4);
+
+        __m256i rows01 = expandBC1RowPairAVX2(palette_vector, indices, _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14));
+        __m256i rows23 = expandBC1RowPairAVX2(palette_vector, indices, _mm256_setr_epi32(16, 18, 20, 22, 24, 26, 28, 30));
+
+        if(alpha != nullptr)
+        {
+            const char z = (char)0x80;
+            __m256i alpha_vector = _mm256_broadcastsi128_si256(*alpha);
+            __m256i shuffle01 = _mm256_setr_epi8(
+                z, z, z, 0, z, z, z, 1, z, z, z, 2, z, z, z, 3,
+                z, z, z, 4, z, z, z, 5, z, z, z, 6, z, z, z, 7);
+            __m256i shuffle23 = _mm256_setr_epi8(
+                z, z, z, 8, z, z, z, 9, z, z, z, 10, z, z, z, 11,
+                z, z, z, 12, z, z, z, 13, z, z, z, 14, z, z, z, 15);
+            __m256i color_mask = _mm256_set1_epi32(0x00FFFFFF);
+            rows01 = _mm256_or_si256(_mm256_and_si256(rows01, color_mask), _mm256_shuffle_epi8(alpha_vector, shuffle01));
+            rows23 = _mm256_or_si256(_mm256_and_si256(rows23, color_mask), _mm256_shuffle_epi8(alpha_vector, shuffle23));
+        }
+
+        _mm_storeu_si128((__m128i*)(destination + 0 * destination_row_pitch), _mm256_castsi256_si128(rows01));
+        _mm_storeu_si128((__m128i*)(destination + 1 * destination_row_pitch), _mm256_extracti128_si256(rows01, 1));
+        _mm_storeu_si128((__m128i*)(destination + 2 * destination_row_pitch), _mm256_castsi256_si128(rows23));
+        _mm_storeu_si128((__m128i*)(destination + 3 * destination_row_pitch), _mm256_extracti128_si256(rows23, 1));
+    }
+
+    ARIEO_TARGET_AVX2 static void decodeBC1BlockAVX2(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool swap_red_blue)
+    {
+        writeBCColorBlockAVX2(block, nullptr, destination, destination_row_pitch, true, swap_red_blue);
+    }
+
+    ARIEO_TARGET_AVX2 static void decodeBC2BlockAVX2(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool swap_red_blue)
+    {
+        __m128i nibbles = _mm_loadl_epi64((const __m128i*)block);
+        __m128i low = _mm_and_si128(nibbles, _mm_set1_epi8(0x0F));
+        __m128i high = _mm_and_si128(_mm_srli_epi16(nibbles, 4), _mm_set1_epi8(0x0F));
+        __m128i alpha = _mm_unpacklo_epi8(low, high);
+        alpha = _mm_or_si128(alpha, _mm_slli_epi16(alpha, 4));
+
+        writeBCColorBlockAVX2(block + 8, &alpha, destination, destination_row_pitch, false, swap_red_blue);
+    }
+
+    ARIEO_TARGET_AVX2 static void decodeBC3BlockAVX2(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool swap_red_blue)
+    {
+        std::uint8_t palette[8];
+        buildBC4PaletteUnorm(block, palette);
+        __m128i alpha = expandBC4AVX2(block, _mm_loadl_epi64((const __m128i*)palette));
+        writeBCColorBlockAVX2(block + 8, &alpha, destination, destination_row_pitch, false, swap_red_blue);
+    }
+
+    ARIEO_TARGET_AVX2 static void decodeBC4UnormBlockAVX2(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        std::uint8_t palette[8];
+        buildBC4PaletteUnorm(block, palette);
+        __m128i red = expandBC4AVX2(block, _mm_loadl_epi64((const __m128i*)palette));
+        for(std::uint32_t y = 0; y < 4; ++y)
+        {
+            std::uint32_t row = (std::uint32_t)_mm_cvtsi128_si32(red);
+            std::memcpy(destination + y * destination_row_pitch, &row, sizeof(row));
+            red = _mm_srli_si128(red, 4);
+        }
+    }
+
+    ARIEO_TARGET_AVX2 static void decodeBC4SnormBlockAVX2(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        std::int8_t palette[8];
+        buildBC4PaletteSnorm(block, palette);
+        __m128i red = expandBC4AVX2(block, _mm_loadl_epi64((const __m128i*)palette));
+        for(std::uint32_t y = 0; y < 4; ++y)
+        {
+            std::uint32_t row = (std::uint32_t)_mm_cvtsi128_si32(red);
+            std::memcpy(destination + y * destination_row_pitch, &row, sizeof(row));
+            red = _mm_srli_si128(red, 4);
+        }
+    }
+
+    ARIEO_TARGET_AVX2 static void writeBC5BlockAVX2(__m128i red, __m128i green, std::uint8_t* destination, size_t destination_row_pitch)
+    {
+        __m128i rows01 = _mm_unpacklo_epi8(red, green);
+        __m128i rows23 = _mm_unpackhi_epi8(red, green);
+        _mm_storel_epi64((__m128i*)(destination + 0 * destination_row_pitch), rows01);
+        _mm_storel_epi64((__m128i*)(destination + 1 * destination_row_pitch), _mm_srli_si128(rows01, 8));
+        _mm_storel_epi64((__m128i*)(destination + 2 * destination_row_pitch), rows23);
+        _mm_storel_epi64((__m128i*)(destination + 3 * destination_row_pitch), _mm_srli_si128(rows23, 8));
+    }
+
+    ARIEO_TARGET_AVX2 static void decodeBC5UnormBlockAVX2(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        std::uint8_t red_palette[8];
+        std::uint8_t green_palette[8];
+        buildBC4PaletteUnorm(block, red_palette);
+        buildBC4PaletteUnorm(block + 8, green_palette);
+        writeBC5BlockAVX2(
+            expandBC4AVX2(block, _mm_loadl_epi64((const __m128i*)red_palette)),
+            expandBC4AVX2(block + 8, _mm_loadl_epi64((const __m128i*)green_palette)),
+            destination,
+            destination_row_pitch
+        );
+    }
+
+    ARIEO_TARGET_AVX2 static void decodeBC5SnormBlockAVX2(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        std::int8_t red_palette[8];
+        std::int8_t green_palette[8];
+        buildBC4PaletteSnorm(block, red_palette);
+        buildBC4PaletteSnorm(block + 8, green_palette);
+        writeBC5BlockAVX2(
+            expandBC4AVX2(block, _mm_loadl_epi64((const __m128i*)red_palette)),
+            expandBC4AVX2(block + 8, _mm_loadl_epi64((const __m128i*)green_palette)),
+            destination,
+            destination_row_pitch
+        );
+    }
+
+    // Interpolation weight of each of the sixteen pixels.
+    ARIEO_TARGET_AVX2 static inline __m128i expandBCWeightsAVX2(std::uint64_t indices, std::uint32_t index_bits)
+    {
+        std::uint8_t weight_table[16] = {};
+        std::memcpy(weight_table, getBCWeights(index_bits), (size_t)1 << index_bits);
+        return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)weight_table), unpackBCIndicesAVX2(indices, index_bits));
+    }
+
+    ARIEO_TARGET_AVX2 static inline __m256i finishBC6HAVX2(__m256i value, bool is_signed)
+    {
+        if(is_signed == false)
+        {
+            return _mm256_srli_epi32(_mm256_mullo_epi32(value, _mm256_set1_epi32(31)), 6);
+        }
+        __m256i magnitude = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_abs_epi32(value), _mm256_set1_epi32(31)), 5);
+        __m256i sign = _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), value), _mm256_set1_epi32(0x8000));
+        return _mm256_or_si256(magnitude, sign);
+    }
+
+    ARIEO_TARGET_AVX2 static void decodeBC6HBlockAVX2(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool is_signed)
+    {
+        BC6HEndpoints endpoints;
+        if(readBC6HEndpoints(block, is_signed, endpoints) == false)
+        {
+            for(std::uint32_t y = 0; y < 4; ++y)
+            {
+                _mm256_storeu_si256((__m256i*)(destination + y * destination_row_pitch), _mm256_setzero_si256());
+            }
+            return;
+        }
+
+        bool is_partitioned = endpoints.m_subset_count == 2;
+        std::uint32_t index_bits = is_partitioned ? 3 : 4;
+        std::uint32_t anchor_second = is_partitioned ? g_bc_anchor_2_subset_second[endpoints.m_partition] : 0;
+        std::uint64_t indices = readBCIndexStream(block, endpoints.m_index_offset, index_bits, anchor_second, 0);
+        __m128i weights = expandBCWeightsAVX2(indices, index_bits);
+        // 0xFF for the pixels of the second subset.
+        __m128i subsets = is_partitioned
+            ? _mm_sub_epi8(_mm_setzero_si128(), unpackBCIndicesAVX2(g_bc_partitions_2_subset[endpoints.m_partition], 1))
+            : _mm_setzero_si128();
+
+        const __m256i rounding = _mm256_set1_epi32(32);
+        const __m256i alpha = _mm256_set1_epi32(0x3C00);
+        for(std::uint32_t y = 0; y < 4; y += 2)
+        {
+            __m256i weight1 = _mm256_cvtepu8_epi32(weights);
+            __m256i weight0 = _mm256_sub_epi32(_mm256_set1_epi32(64), weight1);
+            __m256i second_subset = _mm256_cvtepi8_epi32(subsets);
+
+            __m256i channels[3];
+            for(std::uint32_t channel = 0; channel < 3; ++channel)
+            {
+                __m256i endpoint0 = _mm256_blendv_epi8(_mm256_set1_epi32(endpoints.m_endpoints[0][channel]), _mm256_set1_epi32(endpoints.m_endpoints[2][channel]), second_subset);
+                __m256i endpoint1 = _mm256_blendv_epi8(_mm256_set1_epi32(endpoints.m_endpoints[1][channel]), _mm256_set1_epi32(endpoints.m_endpoints[3][channel]), second_subset);
+                __m256i value = _mm256_add_epi32(_mm256_mullo_epi32(weight0, endpoint0), _mm256_mullo_epi32(weight1, endpoint1));
+                channels[channel] = finishBC6HAVX2(_mm256_srai_epi32(_mm256_add_epi32(value, rounding), 6), is_signed);
+            }
+
+            // Packs and unpacks stay within each 128 bit lane, one row per lane.
+            __m256i red_green = _mm256_packus_epi32(channels[0], channels[1]);
+            __m256i blue_alpha = _mm256_packus_epi32(channels[2], alpha);
+            __m256i red_blue = _mm256_unpacklo_epi16(red_green, blue_alpha);
+            __m256i green_alpha = _mm256_unpackhi_epi16(red_green, blue_alpha);
+            __m256i texels01 = _mm256_unpacklo_epi16(red_blue, green_alpha);
+            __m256i texels23 = _mm256_unpackhi_epi16(red_blue, green_alpha);
+            _mm256_storeu_si256((__m256i*)(destination + y * destination_row_pitch), _mm256_permute2x128_si256(texels01, texels23, 0x20));
+            _mm256_storeu_si256((__m256i*)(destination + (y + 1) * destination_row_pitch), _mm256_permute2x128_si256(texels01, texels23, 0x31));
+
+            weights = _mm_srli_si128(weights, 8);
+            subsets = _mm_srli_si128(subsets, 8);
+        }
+    }
+
+    ARIEO_TARGET_AVX2 static void decodeBC6HUfloatBlockAVX2(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        decodeBC6HBlockAVX2(block, destination, destination_row_pitch, false);
+    }
+
+    ARIEO_TARGET_AVX2 static void decodeBC6HSfloatBlockAVX2(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool)
+    {
+        decodeBC6HBlockAVX2(block, destination, destination_row_pitch, true);
+    }
+
+    ARIEO_TARGET_AVX2 static void decodeBC7BlockAVX2(const std::uint8_t* block, std::uint8_t* destination, size_t destination_row_pitch, bool swap_red_blue)
+    {
+        BC7Endpoints endpoints;
+        if(readBC7Endpoints(block, endpoints) == false)
+        {
+            for(std::uint32_t y = 0; y < 4; ++y)
+            {
+                _mm_storeu_si128((__m128i*)(destination + y * destination_row_pitch), _mm_setzero_si128());
+            }
+            return;
+        }
+
+        BC7KernelBlock kernel_block;
+        prepareBC7KernelBlock(block, endpoints, swap_red_blue, kernel_block);
+
+        __m256i color_weights = _mm256_broadcastsi128_si256(expandBCWeightsAVX2(kernel_block.m_color_indices, kernel_block.m_color_index_bits));
+        __m256i alpha_weights = _mm256_broadcastsi128_si256(expandBCWeightsAVX2(kernel_block.m_alpha_indices, kernel_block.m_alpha_index_bits));
+        __m256i subsets = _mm256_broadcastsi128_si256(
+            kernel_block.m_subset_bits != 0
+                ? unpackBCIndicesAVX2(kernel_block.m_subsets, kernel_block.m_subset_bits)
+                : _mm_setzero_si128()
+        );
+
+        const __m256i endpoint0_table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)kernel_block.m_endpoint0));
+        const __m256i endpoint1_table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)kernel_block.m_endpoint1));
+        const __m256i alpha_channels = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)kernel_block.m_alpha_channels));
+        const __m256i positions = _mm256_set1_epi32(0x03020100);
+        const __m256i rounding = _mm256_set1_epi16(32);
+        __m256i texels = _mm256_setr_epi8(
+            0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+            4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7);
+        for(std::uint32_t y = 0; y < 4; y += 2)
+        {
+            // Subsets are at most 2, so the shift by 2 stays inside each byte.
+            __m256i table_index = _mm256_add_epi8(_mm256_slli_epi16(_mm256_shuffle_epi8(subsets, texels), 2), positions);
+            __m256i endpoint0 = _mm256_shuffle_epi8(endpoint0_table, table_index);
+            __m256i endpoint1 = _mm256_shuffle_epi8(endpoint1_table, table_index);
+            __m256i weight1 = _mm256_blendv_epi8(_mm256_shuffle_epi8(color_weights, texels), _mm256_shuffle_epi8(alpha_weights, texels), alpha_channels);
+            __m256i weight0 = _mm256_sub_epi8(_mm256_set1_epi8(64), weight1);
+
+            __m256i low = _mm256_maddubs_epi16(_mm256_unpacklo_epi8(endpoint0, endpoint1), _mm256_unpacklo_epi8(weight0, weight1));
+            __m256i high = _mm256_maddubs_epi16(_mm256_unpackhi_epi8(endpoint0, endpoint1), _mm256_unpackhi_epi8(weight0, weight1));
+            low = _mm256_srli_epi16(_mm256_add_epi16(low, rounding), 6);
+            high = _mm256_srli_epi16(_mm256_add_epi16(high, rounding), 6);
+            __m256i rows = _mm256_packus_epi16(low, high);
+            _mm_storeu_si128((__m128i*)(destination + y * destination_row_pitch), _mm256_castsi256_si128(rows));
+            _mm_storeu_si128((__m128i*)(destination + (y + 1) * destination_row_pitch), _mm256_extracti128_si256(rows, 1));
+
+            texels = _mm256_add_epi8(texels, _mm256_set1_epi8(8));
+        }
+    }
+
+    void fillAVX2BCBlockDecoders(BCBlockDecoders& decoders)
+    {
+        decoders.m_bc1 = decodeBC1BlockAVX2;
+        decoders.m_bc2 = decodeBC2BlockAVX2;
+        decoders.m_bc3 = decodeBC3BlockAVX2;
+        decoders.m_bc4_unorm = decodeBC4UnormBlockAVX2;
+        decoders.m_bc4_snorm = decodeBC4SnormBlockAVX2;
+        decoders.m_bc5_unorm = decodeBC5UnormBlockAVX2;
+        decoders.m_bc5_snorm = decodeBC5SnormBlockAVX2;
+        decoders.m_bc6h_ufloat = decodeBC6HUfloatBlockAVX2;
+        decoders.m_bc6h_sfloat = decodeBC6HSfloatBlockAVX2;
+        decoders.m_bc7 = decodeBC7BlockAVX2;
+    }
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,750 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "bc_encoder.h"
+#include "bc_common.h"
+#include "bc_tables.h"
+#include "image_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Arieo
+{
+    // Writes little endian bit fields into a 128 bit block.
+    class BCBitWriter
+    {
+    public:
+        explicit BCBitWriter(std::uint8_t* block)
+            : m_block(block)
+        {
+            std::memset(m_block, 0, 16);
+        }
+
+        void write(std::uint32_t value, std::uint32_t count)
+        {
+            for(std::uint32_t bit = 0; bit < count; ++bit, ++m_position)
+            {
+                m_block[m_position >> 3] |= (std::uint8_t)(((value >> bit) & 0x1) << (m_position & 0x7));
+            }
+        }
+
+    private:
+        std::uint8_t* m_block;
+        std::uint32_t m_position = 0;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Endpoint search
+
+    static std::uint32_t getBCChannel(std::uint32_t color, std::uint32_t channel)
+    {
+        return (color >> (channel * 8)) & 0xFF;
+    }
+
+    // Mean and principal axis of the block colours over the first channel_count
+    // channels; the axis comes from a few power iterations on the covariance.
+    static void computeBCPrincipalAxis(const std::uint32_t pixels[16], std::uint32_t channel_count, float mean[4], float axis[4])
+    {
+        float minimum[4] = {255.0f, 255.0f, 255.0f, 255.0f};
+        float maximum[4] = {};
+        for(std::uint32_t channel = 0; channel < 4; ++channel)
+        {
+            mean[channel] = 0.0f;
+            axis[channel] = 0.0f;
+        }
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            for(std::uint32_t channel = 0; channel < channel_count; ++channel)
+            {
+                float value = (float)getBCChannel(pixels[pixel], channel);
+                mean[channel] += value;
+                minimum[channel] = std::min(minimum[channel], value);
+                maximum[channel] = std::max(maximum[channel], value);
+            }
+        }
+        for(std::uint32_t channel = 0; channel < channel_count; ++channel)
+        {
+            mean[channel] /= 16.0f;
+        }
+
+        float covariance[4][4] = {};
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            float delta[4] = {};
+            for(std::uint32_t channel = 0; channel < channel_count; ++channel)
+            {
+                delta[channel] = (float)getBCChannel(pixels[pixel], channel) - mean[channel];
+            }
+            for(std::uint32_t row = 0; row < channel_count; ++row)
+            {
+                for(std::uint32_t column = row; column < channel_count; ++column)
+                {
+                    covariance[row][column] += delta[row] * delta[column];
+                }
+            }
+        }
+        for(std::uint32_t row = 0; row < channel_count; ++row)
+        {
+            for(std::uint32_t column = 0; column < row; ++column)
+            {
+                covariance[row][column] = covariance[column][row];
+            }
+        }
+
+        // The bounding box diagonal is a good first guess and converges in a few steps.
+        float vector[4] = {};
+        for(std::uint32_t channel = 0; channel < channel_count; ++channel)
+        {
+            vector[channel] = maximum[channel] - minimum[channel];
+        }
+        for(std::uint32_t iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[4] = {};
+            float length = 0.0f;
+            for(std::uint32_t row = 0; row < channel_count; ++row)
+            {
+                for(std::uint32_t column = 0; column < channel_count; ++column)
+                {
+                    next[row] += covariance[row][column] * vector[column];
+                }
+                length = std::max(length, std::fabs(next[row]));
+            }
+            if(length < 1e-6f)
+            {
+                break;
+            }
+            for(std::uint32_t channel = 0; channel < channel_count; ++channel)
+            {
+                vector[channel] = next[channel] / length;
+            }
+        }
+
+        float length = 0.0f;
+        for(std::uint32_t channel = 0; channel < channel_count; ++channel)
+        {
+            length += vector[channel] * vector[channel];
+        }
+        if(length < 1e-12f)
+        {
+            // Flat block, any axis works.
+            for(std::uint32_t channel = 0; channel < channel_count; ++channel)
+            {
+                axis[channel] = 1.0f / std::sqrt((float)channel_count);
+            }
+            return;
+        }
+        length = std::sqrt(length);
+        for(std::uint32_t channel = 0; channel < channel_count; ++channel)
+        {
+            axis[channel] = vector[channel] / length;
+        }
+    }
+
+    // Projects the block onto its principal axis; endpoint0 ends up at the low end.
+    // inset pulls both ends towards the middle by that fraction of the range.
+    static void findBCAxisEndpoints(const std::uint32_t pixels[16], std::uint32_t channel_count, float inset, float endpoint0[4], float endpoint1[4])
+    {
+        float mean[4];
+        float axis[4];
+        computeBCPrincipalAxis(pixels, channel_count, mean, axis);
+
+        float minimum = 0.0f;
+        float maximum = 0.0f;
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            float projection = 0.0f;
+            for(std::uint32_t channel = 0; channel < channel_count; ++channel)
+            {
+                projection += ((float)getBCChannel(pixels[pixel], channel) - mean[channel]) * axis[channel];
+            }
+            minimum = std::min(minimum, projection);
+            maximum = std::max(maximum, projection);
+        }
+
+        float margin = (maximum - minimum) * inset;
+        minimum += margin;
+        maximum -= margin;
+        for(std::uint32_t channel = 0; channel < 4; ++channel)
+        {
+            endpoint0[channel] = channel < channel_count ? std::clamp(mean[channel] + axis[channel] * minimum, 0.0f, 255.0f) : 255.0f;
+            endpoint1[channel] = channel < channel_count ? std::clamp(mean[channel] + axis[channel] * maximum, 0.0f, 255.0f) : 255.0f;
+        }
+    }
+
+    // Least squares endpoints for fixed indices; weights are the palette
+    // position of each index in [0, 1]. Returns false when every texel uses
+    // the same weight and the system is singular.
+    static bool refineBCEndpoints(const std::uint32_t pixels[16], const std::uint8_t indices[16], const float* weights, std::uint32_t channel_count, float endpoint0[4], float endpoint1[4])
+    {
+        float a = 0.0f;
+        float b = 0.0f;
+        float c = 0.0f;
+        float x[4] = {};
+        float y[4] = {};
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            float weight = weights[indices[pixel]];
+            float inverse = 1.0f - weight;
+            a += inverse * inverse;
+            b += inverse * weight;
+            c += weight * weight;
+            for(std::uint32_t channel = 0; channel < channel_count; ++channel)
+            {
+                float value = (float)getBCChannel(pixels[pixel], channel);
+                x[channel] += inverse * value;
+                y[channel] += weight * value;
+            }
+        }
+
+        float determinant = a * c - b * b;
+        if(std::fabs(determinant) < 1e-6f)
+        {
+            return false;
+        }
+        for(std::uint32_t channel = 0; channel < channel_count; ++channel)
+        {
+            endpoint0[channel] = std::clamp((c * x[channel] - b * y[channel]) / determinant, 0.0f, 255.0f);
+            endpoint1[channel] = std::clamp((a * y[channel] - b * x[channel]) / determinant, 0.0f, 255.0f);
+        }
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // BC1 colour block
+
+    static const float g_bc1_four_color_weights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+    static const float g_bc1_three_color_weights[3] = {0.0f, 1.0f, 0.5f};
+
+    static std::uint16_t quantizeBC565(const float color[4])
+    {
+        std::uint32_t r = (std::uint32_t)(color[0] * 31.0f / 255.0f + 0.5f);
+        std::uint32_t g = (std::uint32_t)(color[1] * 63.0f / 255.0f + 0.5f);
+        std::uint32_t b = (std::uint32_t)(color[2] * 31.0f / 255.0f + 0.5f);
+        return (std::uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    struct BC1Candidate
+    {
+        std::uint16_t m_color0 = 0;
+        std::uint16_t m_color1 = 0;
+        std::uint8_t m_indices[16] = {};
+        std::uint32_t m_error = 0xFFFFFFFF;
+    };
+
+    // Evaluates one endpoint pair. four_color orders the endpoints so the
+    // decoder picks the four colour mode, otherwise the three colour mode.
+    // Index 3 of the three colour mode is transparent black and never used.
+    // BC3 colour blocks (allow_three_color false) are four colour in any order.
+    static void evaluateBC1Endpoints(const std::uint32_t pixels[16], std::uint16_t color0, std::uint16_t color1, bool four_color, bool allow_three_color, const BCEncodeKernels& kernels, BC1Candidate& best)
+    {
+        if(four_color ? color0 < color1 : color0 > color1)
+        {
+            std::swap(color0, color1);
+        }
+
+        std::uint8_t block[4];
+        std::memcpy(block, &color0, sizeof(color0));
+        std::memcpy(block + 2, &color1, sizeof(color1));
+        std::uint32_t palette[4];
+        buildBC1Palette(block, allow_three_color, false, palette);
+
+        // Equal endpoints always decode in three colour mode.
+        bool three_color = allow_three_color && color0 <= color1;
+        BC1Candidate candidate;
+        candidate.m_color0 = color0;
+        candidate.m_color1 = color1;
+        candidate.m_error = kernels.m_select_color_indices(pixels, palette, three_color ? 3 : 4, false, candidate.m_indices);
+        if(candidate.m_error < best.m_error)
+        {
+            best = candidate;
+        }
+    }
+
+    static void encodeBC1ColorBlock(const std::uint32_t pixels[16], BCEncodeQuality quality, bool allow_three_color, const BCEncodeKernels& kernels, std::uint8_t* block)
+    {
+        float endpoint0[4];
+        float endpoint1[4];
+        // Insetting by 1/16 of the range lets the endpoints land on the palette
+        // points that see the most use.
+        findBCAxisEndpoints(pixels, 3, quality == BCEncodeQuality::FAST ? 1.0f / 16.0f : 0.0f, endpoint0, endpoint1);
+
+        BC1Candidate best;
+        evaluateBC1Endpoints(pixels, quantizeBC565(endpoint1), quantizeBC565(endpoint0), true, allow_three_color, kernels, best);
+
+        if(quality == BCEncodeQuality::HIGH)
+        {
+            for(std::uint32_t iteration = 0; iteration < 2; ++iteration)
+            {
+                bool three_color = allow_three_color && best.m_color0 <= best.m_color1;
+                if(refineBCEndpoints(pixels, best.m_indices, three_color ? g_bc1_three_color_weights : g_bc1_four_color_weights, 3, endpoint0, endpoint1) == false)
+                {
+                    break;
+                }
+                evaluateBC1Endpoints(pixels, quantizeBC565(endpoint0), quantizeBC565(endpoint1), three_color == false, allow_three_color, kernels, best);
+            }
+
+            // The three colour mode wins for blocks with a midpoint heavy distribution.
+            if(allow_three_color)
+            {
+                BC1Candidate three_color_best;
+                evaluateBC1Endpoints(pixels, best.m_color0, best.m_color1, false, true, kernels, three_color_best);
+                if(refineBCEndpoints(pixels, three_color_best.m_indices, g_bc1_three_color_weights, 3, endpoint0, endpoint1))
+                {
+                    evaluateBC1Endpoints(pixels, quantizeBC565(endpoint0), quantizeBC565(endpoint1), false, true, kernels, three_color_best);
+                }
+                if(three_color_best.m_error < best.m_error)
+                {
+                    best = three_color_best;
+                }
+            }
+        }
+
+        std::uint32_t packed_indices = 0;
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            packed_indices |= (std::uint32_t)best.m_indices[pixel] << (pixel * 2);
+        }
+        std::memcpy(block, &best.m_color0, sizeof(best.m_color0));
+        std::memcpy(block + 2, &best.m_color1, sizeof(best.m_color1));
+        std::memcpy(block + 4, &packed_indices, sizeof(packed_indices));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // BC4 channel block, used for the BC3 alpha and both BC5 channels
+
+    static const float g_bc4_eight_value_weights[8] = {0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f};
+
+    struct BC4Candidate
+    {
+        std::uint8_t m_endpoint0 = 0;
+        std::uint8_t m_endpoint1 = 0;
+        std::uint8_t m_indices[16] = {};
+        std::uint32_t m_error = 0xFFFFFFFF;
+    };
+
+    static void evaluateBC4Endpoints(const std::uint8_t values[16], std::uint32_t endpoint0, std::uint32_t endpoint1, const BCEncodeKernels& kernels, BC4Candidate& best)
+    {
+        std::uint8_t block[2] = {(std::uint8_t)endpoint0, (std::uint8_t)endpoint1};
+        std::uint8_t palette[8];
+        buildBC4PaletteUnorm(block, palette);
+
+        BC4Candidate candidate;
+        candidate.m_endpoint0 = block[0];
+        candidate.m_endpoint1 = block[1];
+        candidate.m_error = kernels.m_select_channel_indices(values, palette, candidate.m_indices);
+        if(candidate.m_error < best.m_error)
+        {
+            best = candidate;
+        }
+    }
+
+    static void encodeBC4ChannelBlock(const std::uint8_t values[16], BCEncodeQuality quality, const BCEncodeKernels& kernels, std::uint8_t* block)
+    {
+        std::uint32_t minimum = 255;
+        std::uint32_t maximum = 0;
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            minimum = std::min<std::uint32_t>(minimum, values[pixel]);
+            maximum = std::max<std::uint32_t>(maximum, values[pixel]);
+        }
+
+        // endpoint0 > endpoint1 selects the eight value mode.
+        BC4Candidate best;
+        evaluateBC4Endpoints(values, maximum, minimum, kernels, best);
+
+        if(quality == BCEncodeQuality::HIGH && best.m_error != 0)
+        {
+            float endpoint0[4];
+            float endpoint1[4];
+            std::uint32_t pixels[16];
+            for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+            {
+                pixels[pixel] = values[pixel];
+            }
+            for(std::uint32_t iteration = 0; iteration < 2; ++iteration)
+            {
+                if(best.m_endpoint0 <= best.m_endpoint1 ||
+                   refineBCEndpoints(pixels, best.m_indices, g_bc4_eight_value_weights, 1, endpoint0, endpoint1) == false)
+                {
+                    break;
+                }
+                std::uint32_t refined0 = (std::uint32_t)(endpoint0[0] + 0.5f);
+                std::uint32_t refined1 = (std::uint32_t)(endpoint1[0] + 0.5f);
+                if(refined0 <= refined1)
+                {
+                    break;
+                }
+                evaluateBC4Endpoints(values, refined0, refined1, kernels, best);
+            }
+
+            // The six value mode has exact 0 and 255, so its endpoints only
+            // need to cover the texels in between.
+            std::uint32_t inner_minimum = 255;
+            std::uint32_t inner_maximum = 0;
+            for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+            {
+                if(values[pixel] != 0 && values[pixel] != 255)
+                {
+                    inner_minimum = std::min<std::uint32_t>(inner_minimum, values[pixel]);
+                    inner_maximum = std::max<std::uint32_t>(inner_maximum, values[pixel]);
+                }
+            }
+            if(inner_minimum > inner_maximum)
+            {
+                inner_minimum = inner_maximum = 0;
+            }
+            evaluateBC4Endpoints(values, inner_minimum, inner_maximum, kernels, best);
+        }
+
+        std::uint64_t packed_indices = 0;
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            packed_indices |= (std::uint64_t)best.m_indices[pixel] << (pixel * 3);
+        }
+        block[0] = best.m_endpoint0;
+        block[1] = best.m_endpoint1;
+        for(std::uint32_t byte = 0; byte < 6; ++byte)
+        {
+            block[2 + byte] = (std::uint8_t)(packed_indices >> (byte * 8));
+        }
+    }
+
+    static void extractBCChannel(const std::uint32_t pixels[16], std::uint32_t channel, std::uint8_t values[16])
+    {
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            values[pixel] = (std::uint8_t)getBCChannel(pixels[pixel], channel);
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // BC7 mode 6: one subset, RGBA 7.7.7.7 endpoints with a p-bit each, 4 bit indices
+
+    static const float g_bc7_mode6_weights[16] =
+    {
+        0.0f / 64.0f, 4.0f / 64.0f, 9.0f / 64.0f, 13.0f / 64.0f, 17.0f / 64.0f, 21.0f / 64.0f, 26.0f / 64.0f, 30.0f / 64.0f,
+        34.0f / 64.0f, 38.0f / 64.0f, 43.0f / 64.0f, 47.0f / 64.0f, 51.0f / 64.0f, 55.0f / 64.0f, 60.0f / 64.0f, 64.0f / 64.0f,
+    };
+
+    struct BC7Mode6Endpoint
+    {
+        std::uint8_t m_channels[4] = {};
+        std::uint32_t m_pbit = 0;
+
+        // The p-bit is the low bit of every channel, so the unquantized value is simply (channel << 1) | pbit.
+        std::uint32_t getValue(std::uint32_t channel) const { return ((std::uint32_t)m_channels[channel] << 1) | m_pbit; }
+    };
+
+    static BC7Mode6Endpoint quantizeBC7Mode6Endpoint(const float color[4], std::uint32_t pbit)
+    {
+        BC7Mode6Endpoint endpoint;
+        endpoint.m_pbit = pbit;
+        for(std::uint32_t channel = 0; channel < 4; ++channel)
+        {
+            endpoint.m_channels[channel] = (std::uint8_t)std::clamp((std::int32_t)std::floor((color[channel] - (float)pbit) * 0.5f + 0.5f), 0, 127);
+        }
+        return endpoint;
+    }
+
+    static float getBC7Mode6EndpointError(const float color[4], const BC7Mode6Endpoint& endpoint)
+    {
+        float error = 0.0f;
+        for(std::uint32_t channel = 0; channel < 4; ++channel)
+        {
+            float delta = color[channel] - (float)endpoint.getValue(channel);
+            error += delta * delta;
+        }
+        return error;
+    }
+
+    // Picks the p-bit that quantizes color with the least error on its own.
+    static BC7Mode6Endpoint quantizeBC7Mode6EndpointBestPbit(const float color[4])
+    {
+        BC7Mode6Endpoint even = quantizeBC7Mode6Endpoint(color, 0);
+        BC7Mode6Endpoint odd = quantizeBC7Mode6Endpoint(color, 1);
+        return getBC7Mode6EndpointError(color, odd) < getBC7Mode6EndpointError(color, even) ? odd : even;
+    }
+
+    struct BC7Mode6Candidate
+    {
+        BC7Mode6Endpoint m_endpoints[2];
+        std::uint8_t m_indices[16] = {};
+        std::uint32_t m_error = 0xFFFFFFFF;
+    };
+
+    static void evaluateBC7Mode6Endpoints(const std::uint32_t pixels[16], const BC7Mode6Endpoint& endpoint0, const BC7Mode6Endpoint& endpoint1, const BCEncodeKernels& kernels, BC7Mode6Candidate& best)
+    {
+        std::uint32_t palette[16];
+        for(std::uint32_t index = 0; index < 16; ++index)
+        {
+            std::uint32_t weight = g_bc_weights4[index];
+            std::uint32_t channels[4];
+            for(std::uint32_t channel = 0; channel < 4; ++channel)
+            {
+                channels[channel] = ((64 - weight) * endpoint0.getValue(channel) + weight * endpoint1.getValue(channel) + 32) >> 6;
+            }
+            palette[index] = packBCColor(channels[0], channels[1], channels[2], channels[3], false);
+        }
+
+        BC7Mode6Candidate candidate;
+        candidate.m_endpoints[0] = endpoint0;
+        candidate.m_endpoints[1] = endpoint1;
+        candidate.m_error = kernels.m_select_color_indices(pixels, palette, 16, true, candidate.m_indices);
+        if(candidate.m_error < best.m_error)
+        {
+            best = candidate;
+        }
+    }
+
+    static void evaluateBC7Mode6Colors(const std::uint32_t pixels[16], const float endpoint0[4], const float endpoint1[4], BCEncodeQuality quality, const BCEncodeKernels& kernels, BC7Mode6Candidate& best)
+    {
+        if(quality == BCEncodeQuality::FAST)
+        {
+            evaluateBC7Mode6Endpoints(pixels, quantizeBC7Mode6EndpointBestPbit(endpoint0), quantizeBC7Mode6EndpointBestPbit(endpoint1), kernels, best);
+            return;
+        }
+        for(std::uint32_t pbits = 0; pbits < 4; ++pbits)
+        {
+            evaluateBC7Mode6Endpoints(pixels, quantizeBC7Mode6Endpoint(endpoint0, pbits & 0x1), quantizeBC7Mode6Endpoint(endpoint1, pbits >> 1), kernels, best);
+        }
+    }
+
+    static void encodeBC7Block(const std::uint32_t pixels[16], BCEncodeQuality quality, const BCEncodeKernels& kernels, std::uint8_t* block)
+    {
+        float endpoint0[4];
+        float endpoint1[4];
+        findBCAxisEndpoints(pixels, 4, 0.0f, endpoint0, endpoint1);
+
+        BC7Mode6Candidate best;
+        evaluateBC7Mode6Colors(pixels, endpoint0, endpoint1, quality, kernels, best);
+
+        if(quality == BCEncodeQuality::HIGH)
+        {
+            for(std::uint32_t iteration = 0; iteration < 2 && best.m_error != 0; ++iteration)
+            {
+                if(refineBCEndpoints(pixels, best.m_indices, g_bc7_mode6_weights, 4, endpoint0, endpoint1) == false)
+                {
+                    break;
+                }
+                evaluateBC7Mode6Colors(pixels, endpoint0, endpoint1, quality, kernels, best);
+            }
+        }
+
+        // The anchor texel stores its index without the top bit, mirror the
+        // palette when it would need it.
+        if(best.m_indices[0] & 0x8)
+        {
+            std::swap(best.m_endpoints[0], best.m_endpoints[1]);
+            for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+            {
+                best.m_indices[pixel] = (std::uint8_t)(15 - best.m_indices[pixel]);
+            }
+        }
+
+        BCBitWriter writer(block);
+        writer.write(1 << 6, 7);
+        for(std::uint32_t channel = 0; channel < 4; ++channel)
+        {
+            writer.write(best.m_endpoints[0].m_channels[channel], 7);
+            writer.write(best.m_endpoints[1].m_channels[channel], 7);
+        }
+        writer.write(best.m_endpoints[0].m_pbit, 1);
+        writer.write(best.m_endpoints[1].m_pbit, 1);
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            writer.write(best.m_indices[pixel], pixel == 0 ? 3 : 4);
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Scalar kernels
+
+    static std::uint32_t selectBCColorIndicesScalar(const std::uint32_t pixels[16], const std::uint32_t* palette, std::uint32_t palette_size, bool use_alpha, std::uint8_t indices[16])
+    {
+        std::uint32_t channel_count = use_alpha ? 4 : 3;
+        std::uint32_t total_error = 0;
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            std::uint32_t best_error = 0xFFFFFFFF;
+            std::uint32_t best_index = 0;
+            for(std::uint32_t index = 0; index < palette_size; ++index)
+            {
+                std::uint32_t error = 0;
+                for(std::uint32_t channel = 0; channel < channel_count; ++channel)
+                {
+                    std::int32_t delta = (std::int32_t)getBCChannel(pixels[pixel], channel) - (std::int32_t)getBCChannel(palette[index], channel);
+                    error += (std::uint32_t)(delta * delta);
+                }
+                if(error < best_error)
+                {
+                    best_error = error;
+                    best_index = index;
+                }
+            }
+            indices[pixel] = (std::uint8_t)best_index;
+            total_error += best_error;
+        }
+        return total_error;
+    }
+
+    static std::uint32_t selectBCChannelIndicesScalar(const std::uint8_t values[16], const std::uint8_t palette[8], std::uint8_t indices[16])
+    {
+        std::uint32_t total_error = 0;
+        for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            std::uint32_t best_delta = 0xFFFFFFFF;
+            std::uint32_t best_index = 0;
+            for(std::uint32_t index = 0; index < 8; ++index)
+            {
+                std::uint32_t delta = (std::uint32_t)std::abs((std::int32_t)values[pixel] - (std::int32_t)palette[index]);
+                if(delta < best_delta)
+                {
+                    best_delta = delta;
+                    best_index = index;
+                }
+            }
+            indices[pixel] = (std::uint8_t)best_index;
+            total_error += best_delta * best_delta;
+        }
+        return total_error;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+
+    const BCEncodeKernels& getScalarBCEncodeKernels()
+    {
+        static const BCEncodeKernels kernels =
+        {
+            selectBCColorIndicesScalar,
+            selectBCChannelIndicesScalar,
+        };
+        return kernels;
+    }
+
+    const BCEncodeKernels& getBCEncodeKernels(SimdLevel simd_level)
+    {
+#if ARIEO_IMAGE_LOADER_X86
+        // The index search has no AVX2 specific kernel, AVX2 machines run the SSE4.1 one.
+        static const BCEncodeKernels sse41_kernels = []()
+        {
+            BCEncodeKernels kernels = getScalarBCEncodeKernels();
+            fillSSE41BCEncodeKernels(kernels);
+            return kernels;
+        }();
+
+        if(simd_level != SimdLevel::SCALAR)
+        {
+            return sse41_kernels;
+        }
+#endif
+        return getScalarBCEncodeKernels();
+    }
+
+    bool isBCEncodeTarget(Interface::RHI::Format format)
+    {
+        switch(format)
+        {
+        case Interface::RHI::Format::BC1_RGB_UNORM_BLOCK:
+        case Interface::RHI::Format::BC1_RGB_SRGB_BLOCK:
+        case Interface::RHI::Format::BC3_UNORM_BLOCK:
+        case Interface::RHI::Format::BC3_SRGB_BLOCK:
+        case Interface::RHI::Format::BC5_UNORM_BLOCK:
+        case Interface::RHI::Format::BC7_UNORM_BLOCK:
+        case Interface::RHI::Format::BC7_SRGB_BLOCK:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool isBCEncodeSource(Interface::RHI::Format format)
+    {
+        switch(format)
+        {
+        case Interface::RHI::Format::R8G8B8A8_UNORM:
+        case Interface::RHI::Format::B8G8R8A8_UNORM:
+        case Interface::RHI::Format::B8G8R8A8_SRGB:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    static void encodeBCBlock(Interface::RHI::Format target_format, const std::uint32_t pixels[16], BCEncodeQuality quality, const BCEncodeKernels& kernels, std::uint8_t* block)
+    {
+        std::uint8_t values[16];
+        switch(target_format)
+        {
+        case Interface::RHI::Format::BC1_RGB_UNORM_BLOCK:
+        case Interface::RHI::Format::BC1_RGB_SRGB_BLOCK:
+            encodeBC1ColorBlock(pixels, quality, true, kernels, block);
+            break;
+        case Interface::RHI::Format::BC3_UNORM_BLOCK:
+        case Interface::RHI::Format::BC3_SRGB_BLOCK:
+            extractBCChannel(pixels, 3, values);
+            encodeBC4ChannelBlock(values, quality, kernels, block);
+            encodeBC1ColorBlock(pixels, quality, false, kernels, block + 8);
+            break;
+        case Interface::RHI::Format::BC5_UNORM_BLOCK:
+            extractBCChannel(pixels, 0, values);
+            encodeBC4ChannelBlock(values, quality, kernels, block);
+            extractBCChannel(pixels, 1, values);
+            encodeBC4ChannelBlock(values, quality, kernels, block + 8);
+            break;
+        case Interface::RHI::Format::BC7_UNORM_BLOCK:
+        case Interface::RHI::Format::BC7_SRGB_BLOCK:
+            encodeBC7Block(pixels, quality, kernels, block);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void encodeBCBlockRows(
+        Interface::RHI::Format source_format,
+        Interface::RHI::Format target_format,
+        BCEncodeQuality quality,
+        SimdLevel simd_level,
+        const void* source,
+        size_t source_row_pitch,
+        void* destination,
+        size_t destination_row_pitch,
+        std::uint32_t width,
+        std::uint32_t height,
+        std::uint32_t first_block_row,
+        std::uint32_t block_row_count)
+    {
+        if(isBCEncodeSource(source_format) == false || isBCEncodeTarget(target_format) == false || width == 0 || height == 0)
+        {
+            return;
+        }
+
+        const BCEncodeKernels& kernels = getBCEncodeKernels(simd_level);
+        size_t block_size = getImageFormatInfo(target_format).m_bytes_per_block;
+        bool swap_red_blue = source_format != Interface::RHI::Format::R8G8B8A8_UNORM;
+        std::uint32_t block_column_count = (width + 3) / 4;
+
+        for(std::uint32_t block_row = first_block_row; block_row < first_block_row + block_row_count; ++block_row)
+        {
+            std::uint8_t* destination_row = (std::uint8_t*)destination + block_row * destination_row_pitch;
+            for(std::uint32_t block_column = 0; block_column < block_column_count; ++block_column)
+            {
+                // Gather the block as RGBA, clamping texel coordinates at the image edge.
+                std::uint32_t pixels[16];
+                for(std::uint32_t pixel = 0; pixel < 16; ++pixel)
+                {
+                    std::uint32_t x = std::min(block_column * 4 + pixel % 4, width - 1);
+                    std::uint32_t y = std::min(block_row * 4 + pixel / 4, height - 1);
+                    std::uint32_t color;
+                    std::memcpy(&color, (const std::uint8_t*)source + y * source_row_pitch + x * sizeof(color), sizeof(color));
+                    pixels[pixel] = swap_red_blue
+                        ? packBCColor(getBCChannel(color, 2), getBCChannel(color, 1), getBCChannel(color, 0), getBCChannel(color, 3), false)
+                        : color;
+                }
+                encodeBCBlock(target_format, pixels, quality, kernels, destination_row + block_column * block_size);
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include "interface/file_loader/image_loader.h"
+#include "cpu_features.h"
+#include <cstdint>
+namespace Arieo
+{
+    enum class BCEncodeQuality : std::uint32_t
+    {
+        // Principal axis endpoints, one index search; meant for load time.
+        FAST,
+        // Adds least squares endpoint refinement and tries every alternative
+        // block mode; meant for offline baking.
+        HIGH
+    };
+
+    // Picks the nearest palette entry for each of 16 RGBA8 texels and returns the
+    // summed squared error. With use_alpha false the alpha channel is ignored.
+    // Ties go to the lower index.
+    using BCSelectColorIndicesFunc = std::uint32_t (*)(const std::uint32_t pixels[16], const std::uint32_t* palette, std::uint32_t palette_size, bool use_alpha, std::uint8_t indices[16]);
+
+    // Same for 16 single channel texels against an 8 entry BC4 palette.
+    using BCSelectChannelIndicesFunc = std::uint32_t (*)(const std::uint8_t values[16], const std::uint8_t palette[8], std::uint8_t indices[16]);
+
+    struct BCEncodeKernels
+    {
+        BCSelectColorIndicesFunc m_select_color_indices = nullptr;
+        BCSelectChannelIndicesFunc m_select_channel_indices = nullptr;
+    };
+
+    // The scalar kernels are the reference, every SIMD kernel has to match them bit for bit.
+    const BCEncodeKernels& getScalarBCEncodeKernels();
+#if ARIEO_IMAGE_LOADER_X86
+    void fillSSE41BCEncodeKernels(BCEncodeKernels& kernels);
+#endif
+    const BCEncodeKernels& getBCEncodeKernels(SimdLevel simd_level);
+
+    // True for the formats the encoder produces: BC1, BC3, BC5 UNORM and BC7.
+    bool isBCEncodeTarget(Interface::RHI::Format format);
+
+    // True for the 8 bit four channel formats the encoder reads.
+    bool isBCEncodeSource(Interface::RHI::Format format);
+
+    // Encodes block rows [first_block_row, first_block_row + block_row_count) of
+    // one slice. source and destination point at the first row of the slice.
+    // Blocks crossing the image edge are padded by repeating the edge texels.
+    void encodeBCBlockRows(
+        Interface::RHI::Format source_format,
+        Interface::RHI::Format target_format,
+        BCEncodeQuality quality,
+        SimdLevel simd_level,
+        const void* source,
+        size_t source_row_pitch,
+        void* destination,
+        size_t destination_row_pitch,
+        std::uint32_t width,
+        std::uint32_t height,
+        std::uint32_t first_block_row,
+        std::uint32_t block_row_count
+    );
+}
\ No newline at end of file
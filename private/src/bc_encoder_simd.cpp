@@ -0,0 +1,91 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "bc_encoder.h"
+
+#if ARIEO_IMAGE_LOADER_X86
+#include <immintrin.h>
+
+// Index search dominates encode time: every endpoint candidate is scored
+// against all sixteen texels. The kernels here score four texels (colour) or
+// all sixteen (single channel) per palette entry and keep the scalar tie
+// breaking, so they select the same indices as the reference.
+
+namespace Arieo
+{
+    ARIEO_TARGET_SSE41 static std::uint32_t selectBCColorIndicesSSE41(const std::uint32_t pixels[16], const std::uint32_t* palette, std::uint32_t palette_size, bool use_alpha, std::uint8_t indices[16])
+    {
+        const __m128i channel_mask = _mm_set1_epi32(use_alpha ? -1 : 0x00FFFFFF);
+
+        __m128i entries[16];
+        for(std::uint32_t index = 0; index < palette_size; ++index)
+        {
+            entries[index] = _mm_cvtepu8_epi16(_mm_and_si128(_mm_set1_epi32((int)palette[index]), channel_mask));
+        }
+
+        __m128i total_error = _mm_setzero_si128();
+        for(std::uint32_t group = 0; group < 4; ++group)
+        {
+            __m128i colors = _mm_and_si128(_mm_loadu_si128((const __m128i*)(pixels + group * 4)), channel_mask);
+            __m128i colors_low = _mm_cvtepu8_epi16(colors);
+            __m128i colors_high = _mm_cvtepu8_epi16(_mm_srli_si128(colors, 8));
+
+            __m128i best_error = _mm_set1_epi32(0x7FFFFFFF);
+            __m128i best_index = _mm_setzero_si128();
+            for(std::uint32_t index = 0; index < palette_size; ++index)
+            {
+                __m128i delta_low = _mm_sub_epi16(colors_low, entries[index]);
+                __m128i delta_high = _mm_sub_epi16(colors_high, entries[index]);
+                // madd leaves r*r + g*g and b*b + a*a per texel, hadd folds them.
+                __m128i error = _mm_hadd_epi32(_mm_madd_epi16(delta_low, delta_low), _mm_madd_epi16(delta_high, delta_high));
+                __m128i is_better = _mm_cmplt_epi32(error, best_error);
+                best_error = _mm_min_epi32(error, best_error);
+                best_index = _mm_blendv_epi8(best_index, _mm_set1_epi32((int)index), is_better);
+            }
+
+            __m128i packed = _mm_packus_epi16(_mm_packus_epi32(best_index, best_index), best_index);
+            std::uint32_t group_indices = (std::uint32_t)_mm_cvtsi128_si32(packed);
+            for(std::uint32_t pixel = 0; pixel < 4; ++pixel)
+            {
+                indices[group * 4 + pixel] = (std::uint8_t)(group_indices >> (pixel * 8));
+            }
+            total_error = _mm_add_epi32(total_error, best_error);
+        }
+
+        total_error = _mm_hadd_epi32(total_error, total_error);
+        total_error = _mm_hadd_epi32(total_error, total_error);
+        return (std::uint32_t)_mm_cvtsi128_si32(total_error);
+    }
+
+    ARIEO_TARGET_SSE41 static std::uint32_t selectBCChannelIndicesSSE41(const std::uint8_t values[16], const std::uint8_t palette[8], std::uint8_t indices[16])
+    {
+        __m128i texels = _mm_loadu_si128((const __m128i*)values);
+        __m128i best_delta = _mm_set1_epi8((char)0xFF);
+        __m128i best_index = _mm_setzero_si128();
+        for(std::uint32_t index = 0; index < 8; ++index)
+        {
+            __m128i entry = _mm_set1_epi8((char)palette[index]);
+            __m128i delta = _mm_sub_epi8(_mm_max_epu8(texels, entry), _mm_min_epu8(texels, entry));
+            __m128i minimum = _mm_min_epu8(delta, best_delta);
+            // Strictly smaller exactly when the minimum moved.
+            __m128i is_better = _mm_xor_si128(_mm_cmpeq_epi8(minimum, best_delta), _mm_set1_epi8((char)0xFF));
+            best_delta = minimum;
+            best_index = _mm_blendv_epi8(best_index, _mm_set1_epi8((char)index), is_better);
+        }
+        _mm_storeu_si128((__m128i*)indices, best_index);
+
+        __m128i delta_low = _mm_cvtepu8_epi16(best_delta);
+        __m128i delta_high = _mm_cvtepu8_epi16(_mm_srli_si128(best_delta, 8));
+        __m128i error = _mm_add_epi32(_mm_madd_epi16(delta_low, delta_low), _mm_madd_epi16(delta_high, delta_high));
+        error = _mm_hadd_epi32(error, error);
+        error = _mm_hadd_epi32(error, error);
+        return (std::uint32_t)_mm_cvtsi128_si32(error);
+    }
+
+    void fillSSE41BCEncodeKernels(BCEncodeKernels& kernels)
+    {
+        kernels.m_select_color_indices = selectBCColorIndicesSSE41;
+        kernels.m_select_channel_indices = selectBCChannelIndicesSSE41;
+    }
+}
+#endif
\ No newline at end of file
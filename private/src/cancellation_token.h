@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <memory>
+namespace Arieo
+{
+    // Shared flag for cooperative cancellation. Copies observe the same flag;
+    // a default constructed token can never be cancelled and costs nothing to
+    // check, so loaders take one unconditionally.
+    class CancellationToken
+    {
+    public:
+        CancellationToken() = default;
+
+        static CancellationToken create()
+        {
+            CancellationToken token;
+            token.m_is_cancelled = std::make_shared<std::atomic<bool>>(false);
+            return token;
+        }
+
+        void cancel() const
+        {
+            if(m_is_cancelled != nullptr)
+            {
+                m_is_cancelled->store(true, std::memory_order_relaxed);
+            }
+        }
+
+        bool isCancelled() const
+        {
+            return m_is_cancelled != nullptr && m_is_cancelled->load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> m_is_cancelled;
+    };
+}
\ No newline at end of file
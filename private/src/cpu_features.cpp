@@ -0,0 +1,64 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "cpu_features.h"
+
+#if ARIEO_IMAGE_LOADER_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace Arieo
+{
+    static SimdLevel detectSimdLevel()
+    {
+#if ARIEO_IMAGE_LOADER_X86 && defined(_MSC_VER)
+        int cpu_info[4] = {};
+        __cpuid(cpu_info, 0);
+        int max_leaf = cpu_info[0];
+
+        __cpuid(cpu_info, 1);
+        bool has_sse41 = (cpu_info[2] & (1 << 19)) != 0;
+        bool has_osxsave = (cpu_info[2] & (1 << 27)) != 0;
+        bool has_avx = (cpu_info[2] & (1 << 28)) != 0;
+
+        bool has_avx2 = false;
+        if(max_leaf >= 7 && has_osxsave && has_avx)
+        {
+            // The OS has to save the YMM registers as well.
+            bool has_ymm_state = (_xgetbv(0) & 0x6) == 0x6;
+            __cpuidex(cpu_info, 7, 0);
+            has_avx2 = has_ymm_state && (cpu_info[1] & (1 << 5)) != 0;
+        }
+
+        if(has_avx2 && has_sse41)
+        {
+            return SimdLevel::AVX2;
+        }
+        if(has_sse41)
+        {
+            return SimdLevel::SSE41;
+        }
+        return SimdLevel::SCALAR;
+#elif ARIEO_IMAGE_LOADER_X86
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse4.1"))
+        {
+            return SimdLevel::AVX2;
+        }
+        if(__builtin_cpu_supports("sse4.1"))
+        {
+            return SimdLevel::SSE41;
+        }
+        return SimdLevel::SCALAR;
+#else
+        return SimdLevel::SCALAR;
+#endif
+    }
+
+    SimdLevel getSimdLevel()
+    {
+        static const SimdLevel simd_level = detectSimdLevel();
+        return simd_level;
+    }
+}
\ No newline at end of file
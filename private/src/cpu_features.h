@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ARIEO_IMAGE_LOADER_X86 1
+#else
+#define ARIEO_IMAGE_LOADER_X86 0
+#endif
+
+// SIMD kernels are compiled per function, the rest of the module keeps the
+// baseline instruction set and picks a kernel at runtime.
+#if ARIEO_IMAGE_LOADER_X86 && (defined(__GNUC__) || defined(__clang__))
+#define ARIEO_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define ARIEO_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ARIEO_TARGET_SSE41
+#define ARIEO_TARGET_AVX2
+#endif
+
+namespace Arieo
+{
+    enum class SimdLevel : std::uint32_t
+    {
+        SCALAR,
+        SSE41,
+        AVX2
+    };
+
+    // Highest level supported by both the CPU and the OS, detected once.
+    SimdLevel getSimdLevel();
+}
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "dds_conversion.h"
+
+#include <cstring>
+
+namespace Arieo
+{
+    std::uint32_t getDDSConversionSourceTexelSize(DDSConversion conversion)
+    {
+        switch(conversion)
+        {
+        case DDSConversion::EXPAND_24_TO_32:
+            return 3;
+        case DDSConversion::FILL_ALPHA_X1R5G5B5:
+        case DDSConversion::FILL_ALPHA_X4R4G4B4:
+            return 2;
+        case DDSConversion::FILL_ALPHA_32:
+        case DDSConversion::UNPACK_R10G10B10A2:
+        case DDSConversion::UNPACK_B10G10R10A2:
+        case DDSConversion::UNPACK_R11G11B10_FLOAT:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    bool isDDSConversionInPlace(DDSConversion conversion)
+    {
+        return conversion == DDSConversion::FILL_ALPHA_32
+            || conversion == DDSConversion::FILL_ALPHA_X1R5G5B5
+            || conversion == DDSConversion::FILL_ALPHA_X4R4G4B4;
+    }
+
+    static void expand24To32Scalar(const std::uint8_t* source, std::uint8_t* destination, size_t texel_count)
+    {
+        for(size_t texel = 0; texel < texel_count; ++texel)
+        {
+            destination[texel * 4 + 0] = source[texel * 3 + 0];
+            destination[texel * 4 + 1] = source[texel * 3 + 1];
+            destination[texel * 4 + 2] = source[texel * 3 + 2];
+            destination[texel * 4 + 3] = 0xFF;
+        }
+    }
+
+    static void fillAlphaScalar(const std::uint8_t* source, std::uint8_t* destination, size_t byte_count, std::uint32_t alpha_pattern)
+    {
+        size_t offset = 0;
+        for(; offset + 4 <= byte_count; offset += 4)
+        {
+            std::uint32_t value;
+            std::memcpy(&value, source + offset, sizeof(value));
+            value |= alpha_pattern;
+            std::memcpy(destination + offset, &value, sizeof(value));
+        }
+        for(; offset + 2 <= byte_count; offset += 2)
+        {
+            std::uint16_t value;
+            std::memcpy(&value, source + offset, sizeof(value));
+            value |= (std::uint16_t)alpha_pattern;
+            std::memcpy(destination + offset, &value, sizeof(value));
+        }
+    }
+
+    static std::uint16_t expandUnorm10(std::uint32_t value)
+    {
+        return (std::uint16_t)((value << 6) | (value >> 4));
+    }
+
+    static void unpack10_10_10_2Scalar(const std::uint8_t* source, std::uint8_t* destination, size_t texel_count, bool swap_red_blue)
+    {
+        for(size_t texel = 0; texel < texel_count; ++texel)
+        {
+            std::uint32_t value;
+            std::memcpy(&value, source + texel * 4, sizeof(value));
+            std::uint32_t low = value & 0x3FF;
+            std::uint32_t high = (value >> 20) & 0x3FF;
+            std::uint16_t channels[4] =
+            {
+                expandUnorm10(swap_red_blue ? high : low),
+                expandUnorm10((value >> 10) & 0x3FF),
+                expandUnorm10(swap_red_blue ? low : high),
+                (std::uint16_t)((value >> 30) * 0x5555),
+            };
+            std::memcpy(destination + texel * 8, channels, sizeof(channels));
+        }
+    }
+
+    // Both small floats have the half exponent bias, only the mantissa widens.
+    static void unpack11_11_10FloatScalar(const std::uint8_t* source, std::uint8_t* destination, size_t texel_count)
+    {
+        for(size_t texel = 0; texel < texel_count; ++texel)
+        {
+            std::uint32_t value;
+            std::memcpy(&value, source + texel * 4, sizeof(value));
+            std::uint16_t channels[4] =
+            {
+                (std::uint16_t)((value & 0x7FF) << 4),
+                (std::uint16_t)(((value >> 11) & 0x7FF) << 4),
+                (std::uint16_t)(((value >> 22) & 0x3FF) << 5),
+                0x3C00,
+            };
+            std::memcpy(destination + texel * 8, channels, sizeof(channels));
+        }
+    }
+
+    const DDSConversionKernels& getScalarDDSConversionKernels()
+    {
+        static const DDSConversionKernels kernels =
+        {
+            expand24To32Scalar,
+            fillAlphaScalar,
+            unpack10_10_10_2Scalar,
+            unpack11_11_10FloatScalar,
+        };
+        return kernels;
+    }
+
+    const DDSConversionKernels& getDDSConversionKernels(SimdLevel simd_level)
+    {
+#if ARIEO_IMAGE_LOADER_X86
+        static const DDSConversionKernels sse41_kernels = []()
+        {
+            DDSConversionKernels kernels = getScalarDDSConversionKernels();
+            fillSSE41DDSConversionKernels(kernels);
+            return kernels;
+        }();
+        static const DDSConversionKernels avx2_kernels = []()
+        {
+            DDSConversionKernels kernels = sse41_kernels;
+            fillAVX2DDSConversionKernels(kernels);
+            return kernels;
+        }();
+
+        switch(simd_level)
+        {
+        case SimdLevel::AVX2: return avx2_kernels;
+        case SimdLevel::SSE41: return sse41_kernels;
+        default: break;
+        }
+#endif
+        return getScalarDDSConversionKernels();
+    }
+
+    void convertDDSTexels(DDSConversion conversion, SimdLevel simd_level, const void* source, void* destination, size_t texel_count)
+    {
+        const DDSConversionKernels& kernels = getDDSConversionKernels(simd_level);
+        const std::uint8_t* source_bytes = (const std::uint8_t*)source;
+        std::uint8_t* destination_bytes = (std::uint8_t*)destination;
+        switch(conversion)
+        {
+        case DDSConversion::EXPAND_24_TO_32:
+            kernels.m_expand_24_to_32(source_bytes, destination_bytes, texel_count);
+            break;
+        case DDSConversion::FILL_ALPHA_32:
+            kernels.m_fill_alpha(source_bytes, destination_bytes, texel_count * 4, 0xFF000000);
+            break;
+        case DDSConversion::FILL_ALPHA_X1R5G5B5:
+            kernels.m_fill_alpha(source_bytes, destination_bytes, texel_count * 2, 0x80008000);
+            break;
+        case DDSConversion::FILL_ALPHA_X4R4G4B4:
+            kernels.m_fill_alpha(source_bytes, destination_bytes, texel_count * 2, 0xF000F000);
+            break;
+        case DDSConversion::UNPACK_R10G10B10A2:
+            kernels.m_unpack_10_10_10_2(source_bytes, destination_bytes, texel_count, false);
+            break;
+        case DDSConversion::UNPACK_B10G10R10A2:
+            kernels.m_unpack_10_10_10_2(source_bytes, destination_bytes, texel_count, true);
+            break;
+        case DDSConversion::UNPACK_R11G11B10_FLOAT:
+            kernels.m_unpack_11_11_10_float(source_bytes, destination_bytes, texel_count);
+            break;
+        default:
+            if(source != destination)
+            {
+                std::memcpy(destination, source, texel_count * getDDSConversionSourceTexelSize(conversion));
+            }
+            break;
+        }
+    }
+}
\ No newline at end of file
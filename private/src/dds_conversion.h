@@ -0,0 +1,54 @@
+#pragma once
+#include "cpu_features.h"
+#include <cstddef>
+#include <cstdint>
+namespace Arieo
+{
+    // Texel conversions for DDS formats the RHI cannot sample directly.
+    enum class DDSConversion : std::uint32_t
+    {
+        NONE,
+        // B8G8R8 / R8G8B8 to 32 bits with opaque alpha.
+        EXPAND_24_TO_32,
+        // Padding byte of B8G8R8X8 / R8G8B8X8 set to opaque alpha.
+        FILL_ALPHA_32,
+        // Padding bit of X1R5G5B5 set, read as B5G5R5A1.
+        FILL_ALPHA_X1R5G5B5,
+        // Padding bits of X4R4G4B4 set, read as B4G4R4A4.
+        FILL_ALPHA_X4R4G4B4,
+        // R10G10B10A2 to R16G16B16A16_UNORM.
+        UNPACK_R10G10B10A2,
+        // D3DFMT_A2R10G10B10 (red in the high bits) to R16G16B16A16_UNORM.
+        UNPACK_B10G10R10A2,
+        // R11G11B10_FLOAT to R16G16B16A16_SFLOAT.
+        UNPACK_R11G11B10_FLOAT
+    };
+
+    // Bytes per texel of the data a conversion reads, 0 for NONE.
+    std::uint32_t getDDSConversionSourceTexelSize(DDSConversion conversion);
+
+    // True for the conversions that keep the texel size (the alpha fills),
+    // which convertDDSTexels can run in place.
+    bool isDDSConversionInPlace(DDSConversion conversion);
+
+    struct DDSConversionKernels
+    {
+        void (*m_expand_24_to_32)(const std::uint8_t* source, std::uint8_t* destination, size_t texel_count) = nullptr;
+        // ORs alpha_pattern into every 32 bits; 16 bit formats repeat their mask twice.
+        void (*m_fill_alpha)(const std::uint8_t* source, std::uint8_t* destination, size_t byte_count, std::uint32_t alpha_pattern) = nullptr;
+        void (*m_unpack_10_10_10_2)(const std::uint8_t* source, std::uint8_t* destination, size_t texel_count, bool swap_red_blue) = nullptr;
+        void (*m_unpack_11_11_10_float)(const std::uint8_t* source, std::uint8_t* destination, size_t texel_count) = nullptr;
+    };
+
+    // The scalar kernels are the reference, every SIMD kernel has to match them bit for bit.
+    const DDSConversionKernels& getScalarDDSConversionKernels();
+#if ARIEO_IMAGE_LOADER_X86
+    void fillSSE41DDSConversionKernels(DDSConversionKernels& kernels);
+    void fillAVX2DDSConversionKernels(DDSConversionKernels& kernels);
+#endif
+    const DDSConversionKernels& getDDSConversionKernels(SimdLevel simd_level);
+
+    // Converts texel_count tightly packed texels. Conversions that keep the
+    // texel size may run in place.
+    void convertDDSTexels(DDSConversion conversion, SimdLevel simd_level, const void* source, void* destination, size_t texel_count);
+}
\ No newline at end of file
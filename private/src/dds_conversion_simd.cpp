@@ -0,0 +1,213 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "dds_conversion.h"
+
+#if ARIEO_IMAGE_LOADER_X86
+#include <immintrin.h>
+
+// Every kernel converts whole registers and leaves the remainder to the
+// scalar reference, so the main loops carry no bounds checks per texel.
+
+namespace Arieo
+{
+    ////////////////////////////////////////////////////////////////////////////
+    // SSE4.1
+
+    ARIEO_TARGET_SSE41 static void expand24To32SSE41(const std::uint8_t* source, std::uint8_t* destination, size_t texel_count)
+    {
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+
+        // Four texels use 12 of the 16 bytes loaded, stop while the load stays inside the source.
+        size_t texel = 0;
+        for(; texel + 6 <= texel_count; texel += 4)
+        {
+            __m128i texels = _mm_loadu_si128((const __m128i*)(source + texel * 3));
+            _mm_storeu_si128((__m128i*)(destination + texel * 4), _mm_or_si128(_mm_shuffle_epi8(texels, shuffle), alpha));
+        }
+        getScalarDDSConversionKernels().m_expand_24_to_32(source + texel * 3, destination + texel * 4, texel_count - texel);
+    }
+
+    ARIEO_TARGET_SSE41 static void fillAlphaSSE41(const std::uint8_t* source, std::uint8_t* destination, size_t byte_count, std::uint32_t alpha_pattern)
+    {
+        const __m128i alpha = _mm_set1_epi32((int)alpha_pattern);
+        size_t offset = 0;
+        for(; offset + 16 <= byte_count; offset += 16)
+        {
+            __m128i texels = _mm_loadu_si128((const __m128i*)(source + offset));
+            _mm_storeu_si128((__m128i*)(destination + offset), _mm_or_si128(texels, alpha));
+        }
+        getScalarDDSConversionKernels().m_fill_alpha(source + offset, destination + offset, byte_count - offset, alpha_pattern);
+    }
+
+    ARIEO_TARGET_SSE41 static inline __m128i expandUnorm10SSE41(__m128i value)
+    {
+        return _mm_or_si128(_mm_slli_epi32(value, 6), _mm_srli_epi32(value, 4));
+    }
+
+    // Interleaves 32 bit (r | g << 16) and (b | a << 16) lanes into four 64 bit texels.
+    ARIEO_TARGET_SSE41 static inline void storeRGBA16SSE41(std::uint8_t* destination, __m128i red_green, __m128i blue_alpha)
+    {
+        _mm_storeu_si128((__m128i*)destination, _mm_unpacklo_epi32(red_green, blue_alpha));
+        _mm_storeu_si128((__m128i*)(destination + 16), _mm_unpackhi_epi32(red_green, blue_alpha));
+    }
+
+    ARIEO_TARGET_SSE41 static void unpack10_10_10_2SSE41(const std::uint8_t* source, std::uint8_t* destination, size_t texel_count, bool swap_red_blue)
+    {
+        const __m128i mask = _mm_set1_epi32(0x3FF);
+        const __m128i alpha_scale = _mm_set1_epi32(0x5555);
+
+        size_t texel = 0;
+        for(; texel + 4 <= texel_count; texel += 4)
+        {
+            __m128i texels = _mm_loadu_si128((const __m128i*)(source + texel * 4));
+            __m128i low = _mm_and_si128(texels, mask);
+            __m128i green = _mm_and_si128(_mm_srli_epi32(texels, 10), mask);
+            __m128i high = _mm_and_si128(_mm_srli_epi32(texels, 20), mask);
+            __m128i alpha = _mm_mullo_epi32(_mm_srli_epi32(texels, 30), alpha_scale);
+
+            __m128i red = expandUnorm10SSE41(swap_red_blue ? high : low);
+            __m128i blue = expandUnorm10SSE41(swap_red_blue ? low : high);
+            storeRGBA16SSE41(
+                destination + texel * 8,
+                _mm_or_si128(red, _mm_slli_epi32(expandUnorm10SSE41(green), 16)),
+                _mm_or_si128(blue, _mm_slli_epi32(alpha, 16))
+            );
+        }
+        getScalarDDSConversionKernels().m_unpack_10_10_10_2(source + texel * 4, destination + texel * 8, texel_count - texel, swap_red_blue);
+    }
+
+    ARIEO_TARGET_SSE41 static void unpack11_11_10FloatSSE41(const std::uint8_t* source, std::uint8_t* destination, size_t texel_count)
+    {
+        const __m128i mask = _mm_set1_epi32(0x7FF);
+        const __m128i alpha = _mm_set1_epi32(0x3C00 << 16);
+
+        size_t texel = 0;
+        for(; texel + 4 <= texel_count; texel += 4)
+        {
+            __m128i texels = _mm_loadu_si128((const __m128i*)(source + texel * 4));
+            __m128i red = _mm_slli_epi32(_mm_and_si128(texels, mask), 4);
+            __m128i green = _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(texels, 11), mask), 4);
+            __m128i blue = _mm_slli_epi32(_mm_srli_epi32(texels, 22), 5);
+            storeRGBA16SSE41(
+                destination + texel * 8,
+                _mm_or_si128(red, _mm_slli_epi32(green, 16)),
+                _mm_or_si128(blue, alpha)
+            );
+        }
+        getScalarDDSConversionKernels().m_unpack_11_11_10_float(source + texel * 4, destination + texel * 8, texel_count - texel);
+    }
+
+    void fillSSE41DDSConversionKernels(DDSConversionKernels& kernels)
+    {
+        kernels.m_expand_24_to_32 = expand24To32SSE41;
+        kernels.m_fill_alpha = fillAlphaSSE41;
+        kernels.m_unpack_10_10_10_2 = unpack10_10_10_2SSE41;
+        kernels.m_unpack_11_11_10_float = unpack11_11_10FloatSSE41;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // AVX2
+
+    ARIEO_TARGET_AVX2 static void expand24To32AVX2(const std::uint8_t* source, std::uint8_t* destination, size_t texel_count)
+    {
+        // pshufb works per 128 bit lane, so each lane gets its own 12 byte group.
+        const __m256i shuffle = _mm256_setr_epi8(
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1
+        );
+        const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+
+        size_t texel = 0;
+        for(; texel + 10 <= texel_count; texel += 8)
+        {
+            __m128i low = _mm_loadu_si128((const __m128i*)(source + texel * 3));
+            __m128i high = _mm_loadu_si128((const __m128i*)(source + texel * 3 + 12));
+            __m256i texels = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+            _mm256_storeu_si256((__m256i*)(destination + texel * 4), _mm256_or_si256(_mm256_shuffle_epi8(texels, shuffle), alpha));
+        }
+        expand24To32SSE41(source + texel * 3, destination + texel * 4, texel_count - texel);
+    }
+
+    ARIEO_TARGET_AVX2 static void fillAlphaAVX2(const std::uint8_t* source, std::uint8_t* destination, size_t byte_count, std::uint32_t alpha_pattern)
+    {
+        const __m256i alpha = _mm256_set1_epi32((int)alpha_pattern);
+        size_t offset = 0;
+        for(; offset + 32 <= byte_count; offset += 32)
+        {
+            __m256i texels = _mm256_loadu_si256((const __m256i*)(source + offset));
+            _mm256_storeu_si256((__m256i*)(destination + offset), _mm256_or_si256(texels, alpha));
+        }
+        fillAlphaSSE41(source + offset, destination + offset, byte_count - offset, alpha_pattern);
+    }
+
+    ARIEO_TARGET_AVX2 static inline __m256i expandUnorm10AVX2(__m256i value)
+    {
+        return _mm256_or_si256(_mm256_slli_epi32(value, 6), _mm256_srli_epi32(value, 4));
+    }
+
+    // The unpacks interleave per lane, the permutes put texels 0-3 and 4-7 back in order.
+    ARIEO_TARGET_AVX2 static inline void storeRGBA16AVX2(std::uint8_t* destination, __m256i red_green, __m256i blue_alpha)
+    {
+        __m256i low = _mm256_unpacklo_epi32(red_green, blue_alpha);
+        __m256i high = _mm256_unpackhi_epi32(red_green, blue_alpha);
+        _mm256_storeu_si256((__m256i*)destination, _mm256_permute2x128_si256(low, high, 0x20));
+        _mm256_storeu_si256((__m256i*)(destination + 32), _mm256_permute2x128_si256(low, high, 0x31));
+    }
+
+    ARIEO_TARGET_AVX2 static void unpack10_10_10_2AVX2(const std::uint8_t* source, std::uint8_t* destination, size_t texel_count, bool swap_red_blue)
+    {
+        const __m256i mask = _mm256_set1_epi32(0x3FF);
+        const __m256i alpha_scale = _mm256_set1_epi32(0x5555);
+
+        size_t texel = 0;
+        for(; texel + 8 <= texel_count; texel += 8)
+        {
+            __m256i texels = _mm256_loadu_si256((const __m256i*)(source + texel * 4));
+            __m256i low = _mm256_and_si256(texels, mask);
+            __m256i green = _mm256_and_si256(_mm256_srli_epi32(texels, 10), mask);
+            __m256i high = _mm256_and_si256(_mm256_srli_epi32(texels, 20), mask);
+            __m256i alpha = _mm256_mullo_epi32(_mm256_srli_epi32(texels, 30), alpha_scale);
+
+            __m256i red = expandUnorm10AVX2(swap_red_blue ? high : low);
+            __m256i blue = expandUnorm10AVX2(swap_red_blue ? low : high);
+            storeRGBA16AVX2(
+                destination + texel * 8,
+                _mm256_or_si256(red, _mm256_slli_epi32(expandUnorm10AVX2(green), 16)),
+                _mm256_or_si256(blue, _mm256_slli_epi32(alpha, 16))
+            );
+        }
+        unpack10_10_10_2SSE41(source + texel * 4, destination + texel * 8, texel_count - texel, swap_red_blue);
+    }
+
+    ARIEO_TARGET_AVX2 static void unpack11_11_10FloatAVX2(const std::uint8_t* source, std::uint8_t* destination, size_t texel_count)
+    {
+        const __m256i mask = _mm256_set1_epi32(0x7FF);
+        const __m256i alpha = _mm256_set1_epi32(0x3C00 << 16);
+
+        size_t texel = 0;
+        for(; texel + 8 <= texel_count; texel += 8)
+        {
+            __m256i texels = _mm256_loadu_si256((const __m256i*)(source + texel * 4));
+            __m256i red = _mm256_slli_epi32(_mm256_and_si256(texels, mask), 4);
+            __m256i green = _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(texels, 11), mask), 4);
+            __m256i blue = _mm256_slli_epi32(_mm256_srli_epi32(texels, 22), 5);
+            storeRGBA16AVX2(
+                destination + texel * 8,
+                _mm256_or_si256(red, _mm256_slli_epi32(green, 16)),
+                _mm256_or_si256(blue, alpha)
+            );
+        }
+        unpack11_11_10FloatSSE41(source + texel * 4, destination + texel * 8, texel_count - texel);
+    }
+
+    void fillAVX2DDSConversionKernels(DDSConversionKernels& kernels)
+    {
+        kernels.m_expand_24_to_32 = expand24To32AVX2;
+        kernels.m_fill_alpha = fillAlphaAVX2;
+        kernels.m_unpack_10_10_10_2 = unpack10_10_10_2AVX2;
+        kernels.m_unpack_11_11_10_float = unpack11_11_10FloatAVX2;
+    }
+}
+#endif
\ No newline at end of file
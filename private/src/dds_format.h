@@ -0,0 +1,60 @@
+#pragma once
+#include "interface/file_loader/image_loader.h"
+#include "image_layout.h"
+#include "dds_conversion.h"
+#include "supercompression.h"
+#include <cstdint>
+#include <vector>
+namespace Arieo
+{
+    // Everything loadDDS needs to know about a file, resolved from the
+    // DDS_HEADER and the optional DDS_HEADER_DXT10.
+    struct DDSImageDesc
+    {
+        Interface::RHI::Format m_format = Interface::RHI::Format::UNKNOWN;
+
+        // Conversion the file texels need to become m_format, see loadDDS with
+        // an allocator. The payload on disk is laid out in the source texel size.
+        DDSConversion m_conversion = DDSConversion::NONE;
+
+        // Set for files written by compressDDS. The texels behind the headers
+        // are then replaced by a DDSSupercompressedRange per subresource.
+        Supercompression m_supercompression = Supercompression::NONE;
+
+        ImageDimension m_dimension = ImageDimension::TEXTURE_2D;
+
+        std::uint32_t m_width = 1;
+        std::uint32_t m_height = 1;
+        std::uint32_t m_depth = 1;
+        std::uint32_t m_mip_map_count = 1;
+        std::uint32_t m_array_size = 1;
+
+        // Byte offset of the first texel from the start of the file.
+        size_t m_data_offset = 0;
+    };
+
+    // Where the compressed bytes of one subresource are, offsets are from the
+    // start of the file. The table follows the headers in layout order.
+    struct DDSSupercompressedRange
+    {
+        std::uint64_t m_offset;
+        std::uint64_t m_size;
+    };
+
+    // Largest header a DDS file can have: magic, DDS_HEADER and DDS_HEADER_DXT10.
+    static constexpr size_t g_dds_max_header_size = 4 + 124 + 20;
+
+    // Size of the header that starts buffer, g_dds_max_header_size at most;
+    // 0 while fewer bytes are present than it takes to tell.
+    size_t getDDSHeaderSize(const void* buffer, size_t size);
+
+    // Only the header bytes have to be present in buffer.
+    bool parseDDSHeader(const void* buffer, size_t size, DDSImageDesc& desc);
+
+    // Rewrites a DDS file with every subresource compressed on its own, so
+    // loading can decompress them in parallel. The headers are kept and
+    // marked in dwReserved1, which DDS writers leave zero; tools that do not
+    // know the mark see a file with a broken payload. Files that need a texel
+    // conversion have to be loaded and rewritten in their RHI format first.
+    bool compressDDS(const void* buffer, size_t size, Supercompression scheme, int level, std::vector<std::byte>& output);
+}
\ No newline at end of file
@@ -2,9 +2,14 @@
 #include "core/core.h"
 
 #include "image_loader.h"
+#include "dds_format.h"
+#include "image_format.h"
+#include "image_metrics.h"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cstring>
 
 namespace Arieo
 {
@@ -255,19 +260,19 @@ namespace Arieo
         { DXGI_FORMAT::DXGI_FORMAT_R9G9B9E5_SHAREDEXP , Arieo::Interface::RHI::Format::UNKNOWN  },
         { DXGI_FORMAT::DXGI_FORMAT_R8G8_B8G8_UNORM , Arieo::Interface::RHI::Format::UNKNOWN  },
         { DXGI_FORMAT::DXGI_FORMAT_G8R8_G8B8_UNORM , Arieo::Interface::RHI::Format::UNKNOWN  },
-        { DXGI_FORMAT::DXGI_FORMAT_BC1_TYPELESS , Arieo::Interface::RHI::Format::UNKNOWN  }, //TODO
-        { DXGI_FORMAT::DXGI_FORMAT_BC1_UNORM , Arieo::Interface::RHI::Format::BC1_RGB_UNORM_BLOCK  }, //TODO
-        { DXGI_FORMAT::DXGI_FORMAT_BC1_UNORM_SRGB , Arieo::Interface::RHI::Format::BC1_RGB_SRGB_BLOCK  }, //TODO
-        { DXGI_FORMAT::DXGI_FORMAT_BC2_TYPELESS , Arieo::Interface::RHI::Format::UNKNOWN  }, 
+        { DXGI_FORMAT::DXGI_FORMAT_BC1_TYPELESS , Arieo::Interface::RHI::Format::BC1_RGB_UNORM_BLOCK  },
+        { DXGI_FORMAT::DXGI_FORMAT_BC1_UNORM , Arieo::Interface::RHI::Format::BC1_RGB_UNORM_BLOCK  },
+        { DXGI_FORMAT::DXGI_FORMAT_BC1_UNORM_SRGB , Arieo::Interface::RHI::Format::BC1_RGB_SRGB_BLOCK  },
+        { DXGI_FORMAT::DXGI_FORMAT_BC2_TYPELESS , Arieo::Interface::RHI::Format::BC2_UNORM_BLOCK  }, 
         { DXGI_FORMAT::DXGI_FORMAT_BC2_UNORM , Arieo::Interface::RHI::Format::BC2_UNORM_BLOCK  }, 
         { DXGI_FORMAT::DXGI_FORMAT_BC2_UNORM_SRGB , Arieo::Interface::RHI::Format::BC2_SRGB_BLOCK  }, 
-        { DXGI_FORMAT::DXGI_FORMAT_BC3_TYPELESS , Arieo::Interface::RHI::Format::UNKNOWN  }, 
+        { DXGI_FORMAT::DXGI_FORMAT_BC3_TYPELESS , Arieo::Interface::RHI::Format::BC3_UNORM_BLOCK  }, 
         { DXGI_FORMAT::DXGI_FORMAT_BC3_UNORM , Arieo::Interface::RHI::Format::BC3_UNORM_BLOCK  }, 
         { DXGI_FORMAT::DXGI_FORMAT_BC3_UNORM_SRGB , Arieo::Interface::RHI::Format::BC3_SRGB_BLOCK  }, 
-        { DXGI_FORMAT::DXGI_FORMAT_BC4_TYPELESS , Arieo::Interface::RHI::Format::UNKNOWN  }, 
+        { DXGI_FORMAT::DXGI_FORMAT_BC4_TYPELESS , Arieo::Interface::RHI::Format::BC4_UNORM_BLOCK  }, 
         { DXGI_FORMAT::DXGI_FORMAT_BC4_UNORM , Arieo::Interface::RHI::Format::BC4_UNORM_BLOCK  }, 
         { DXGI_FORMAT::DXGI_FORMAT_BC4_SNORM , Arieo::Interface::RHI::Format::BC4_SNORM_BLOCK  }, 
-        { DXGI_FORMAT::DXGI_FORMAT_BC5_TYPELESS , Arieo::Interface::RHI::Format::UNKNOWN  }, 
+        { DXGI_FORMAT::DXGI_FORMAT_BC5_TYPELESS , Arieo::Interface::RHI::Format::BC5_UNORM_BLOCK  }, 
         { DXGI_FORMAT::DXGI_FORMAT_BC5_UNORM , Arieo::Interface::RHI::Format::BC5_UNORM_BLOCK  }, 
         { DXGI_FORMAT::DXGI_FORMAT_BC5_SNORM , Arieo::Interface::RHI::Format::BC5_SNORM_BLOCK  }, 
         { DXGI_FORMAT::DXGI_FORMAT_B5G6R5_UNORM , Arieo::Interface::RHI::Format::B5G6R5_UNORM_PACK16  },
@@ -279,10 +284,10 @@ namespace Arieo
         { DXGI_FORMAT::DXGI_FORMAT_B8G8R8A8_UNORM_SRGB , Arieo::Interface::RHI::Format::B8G8R8A8_SRGB  },
         { DXGI_FORMAT::DXGI_FORMAT_B8G8R8X8_TYPELESS , Arieo::Interface::RHI::Format::UNKNOWN  },
         { DXGI_FORMAT::DXGI_FORMAT_B8G8R8X8_UNORM_SRGB , Arieo::Interface::RHI::Format::UNKNOWN  },
-        { DXGI_FORMAT::DXGI_FORMAT_BC6H_TYPELESS , Arieo::Interface::RHI::Format::UNKNOWN  },
+        { DXGI_FORMAT::DXGI_FORMAT_BC6H_TYPELESS , Arieo::Interface::RHI::Format::BC6H_UFLOAT_BLOCK  },
         { DXGI_FORMAT::DXGI_FORMAT_BC6H_UF16 , Arieo::Interface::RHI::Format::BC6H_UFLOAT_BLOCK  },
         { DXGI_FORMAT::DXGI_FORMAT_BC6H_SF16 , Arieo::Interface::RHI::Format::BC6H_SFLOAT_BLOCK  },
-        { DXGI_FORMAT::DXGI_FORMAT_BC7_TYPELESS , Arieo::Interface::RHI::Format::UNKNOWN  },
+        { DXGI_FORMAT::DXGI_FORMAT_BC7_TYPELESS , Arieo::Interface::RHI::Format::BC7_UNORM_BLOCK  },
         { DXGI_FORMAT::DXGI_FORMAT_BC7_UNORM , Arieo::Interface::RHI::Format::BC7_UNORM_BLOCK  },
         { DXGI_FORMAT::DXGI_FORMAT_BC7_UNORM_SRGB , Arieo::Interface::RHI::Format::BC7_SRGB_BLOCK  },
         { DXGI_FORMAT::DXGI_FORMAT_AYUV, Arieo::Interface::RHI::Format::UNKNOWN  },
@@ -307,60 +312,714 @@ namespace Arieo
         // DXGI_FORMAT_FORCE_UINT = 0xffffffff
     };
 
-    Interface::FileLoader::ImageBuffer ImageLoader::loadDDS(void* buffer, size_t size)
+    static const std::uint32_t g_ddsd_depth = 0x00800000;
+    static const std::uint32_t g_ddscaps2_cubemap = 0x00000200;
+    static const std::uint32_t g_ddscaps2_cubemap_all_faces = 0x0000FC00;
+    static const std::uint32_t g_ddscaps2_volume = 0x00200000;
+    static const std::uint32_t g_dds_resource_misc_texturecube = 0x00000004;
+
+    // dwReserved1 slots compressDDS marks; NVTT uses 9 and 10, GIMP 1 to 3.
+    static const std::uint32_t g_dds_supercompression_mark_slot = 4;
+    static const std::uint32_t g_dds_supercompression_scheme_slot = 5;
+
+    // Texels per parallel work item when converting legacy formats.
+    static const size_t g_dds_conversion_chunk_texels = 64 * 1024;
+
+    static const std::uint32_t g_ddpf_alpha = 0x00000002;
+    static const std::uint32_t g_ddpf_fourcc = 0x00000004;
+    static const std::uint32_t g_ddpf_rgb = 0x00000040;
+    static const std::uint32_t g_ddpf_luminance = 0x00020000;
+    static const std::uint32_t g_ddpf_bumpdudv = 0x00080000;
+
+    static constexpr std::uint32_t makeDDSFourCC(char c0, char c1, char c2, char c3)
+    {
+        return (std::uint32_t)(std::uint8_t)c0
+            | ((std::uint32_t)(std::uint8_t)c1 << 8)
+            | ((std::uint32_t)(std::uint8_t)c2 << 16)
+            | ((std::uint32_t)(std::uint8_t)c3 << 24);
+    }
+
+    static const std::uint32_t g_dds_supercompression_mark = makeDDSFourCC('A', 'S', 'C', 'Z');
+
+    struct DDSLegacyFourCC
+    {
+        std::uint32_t m_fourcc;
+        Interface::RHI::Format m_format;
+    };
+
+    // DXT2 and DXT4 are premultiplied DXT3 and DXT5, the blocks are identical.
+    // Numeric codes are D3DFORMAT values written by D3DX.
+    static const DDSLegacyFourCC g_dds_legacy_fourccs[] =
+    {
+        { makeDDSFourCC('D', 'X', 'T', '1'), Interface::RHI::Format::BC1_RGB_UNORM_BLOCK },
+        { makeDDSFourCC('D', 'X', 'T', '2'), Interface::RHI::Format::BC2_UNORM_BLOCK },
+        { makeDDSFourCC('D', 'X', 'T', '3'), Interface::RHI::Format::BC2_UNORM_BLOCK },
+        { makeDDSFourCC('D', 'X', 'T', '4'), Interface::RHI::Format::BC3_UNORM_BLOCK },
+        { makeDDSFourCC('D', 'X', 'T', '5'), Interface::RHI::Format::BC3_UNORM_BLOCK },
+        { makeDDSFourCC('A', 'T', 'I', '1'), Interface::RHI::Format::BC4_UNORM_BLOCK },
+        { makeDDSFourCC('B', 'C', '4', 'U'), Interface::RHI::Format::BC4_UNORM_BLOCK },
+        { makeDDSFourCC('B', 'C', '4', 'S'), Interface::RHI::Format::BC4_SNORM_BLOCK },
+        { makeDDSFourCC('A', 'T', 'I', '2'), Interface::RHI::Format::BC5_UNORM_BLOCK },
+        { makeDDSFourCC('B', 'C', '5', 'U'), Interface::RHI::Format::BC5_UNORM_BLOCK },
+        { makeDDSFourCC('B', 'C', '5', 'S'), Interface::RHI::Format::BC5_SNORM_BLOCK },
+        { 36, Interface::RHI::Format::R16G16B16A16_UNORM },     // D3DFMT_A16B16G16R16
+        { 110, Interface::RHI::Format::R16G16B16A16_SNORM },    // D3DFMT_Q16W16V16U16
+        { 111, Interface::RHI::Format::R16_SFLOAT },            // D3DFMT_R16F
+        { 112, Interface::RHI::Format::R16G16_SFLOAT },         // D3DFMT_G16R16F
+        { 113, Interface::RHI::Format::R16G16B16A16_SFLOAT },   // D3DFMT_A16B16G16R16F
+        { 114, Interface::RHI::Format::R32_SFLOAT },            // D3DFMT_R32F
+        { 115, Interface::RHI::Format::R32G32_SFLOAT },         // D3DFMT_G32R32F
+        { 116, Interface::RHI::Format::R32G32B32A32_SFLOAT },   // D3DFMT_A32B32G32R32F
+    };
+
+    struct DDSLegacyPixelFormat
     {
-        int width = 0;
-        int height = 0; 
-        int channels = 0;
+        std::uint32_t m_flags;
+        std::uint32_t m_bit_count;
+        std::uint32_t m_r_mask;
+        std::uint32_t m_g_mask;
+        std::uint32_t m_b_mask;
+        std::uint32_t m_a_mask;
+        Interface::RHI::Format m_format;
+        DDSConversion m_conversion;
+    };
 
-        std::uint32_t* magic_number = (std::uint32_t*)buffer;
+    // Mask layouts written by D3DX, texconv and the NVIDIA exporters. 16 bit
+    // formats map the same way the DXGI mapper above maps their DXGI twins.
+    static const DDSLegacyPixelFormat g_dds_legacy_pixel_formats[] =
+    {
+        { g_ddpf_rgb, 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000, Interface::RHI::Format::R8G8B8A8_UNORM, DDSConversion::NONE },
+        { g_ddpf_rgb, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000, Interface::RHI::Format::B8G8R8A8_UNORM, DDSConversion::NONE },
+        { g_ddpf_rgb, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000, Interface::RHI::Format::B8G8R8A8_UNORM, DDSConversion::FILL_ALPHA_32 },
+        { g_ddpf_rgb, 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0x00000000, Interface::RHI::Format::R8G8B8A8_UNORM, DDSConversion::FILL_ALPHA_32 },
+        { g_ddpf_rgb, 32, 0x000003FF, 0x000FFC00, 0x3FF00000, 0xC0000000, Interface::RHI::Format::R16G16B16A16_UNORM, DDSConversion::UNPACK_R10G10B10A2 },
+        { g_ddpf_rgb, 32, 0x3FF00000, 0x000FFC00, 0x000003FF, 0xC0000000, Interface::RHI::Format::R16G16B16A16_UNORM, DDSConversion::UNPACK_B10G10R10A2 },
+        { g_ddpf_rgb, 32, 0x0000FFFF, 0xFFFF0000, 0x00000000, 0x00000000, Interface::RHI::Format::R16G16_UNORM, DDSConversion::NONE },
+        { g_ddpf_rgb, 32, 0xFFFFFFFF, 0x00000000, 0x00000000, 0x00000000, Interface::RHI::Format::R32_SFLOAT, DDSConversion::NONE },
+        { g_ddpf_rgb, 24, 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000, Interface::RHI::Format::B8G8R8A8_UNORM, DDSConversion::EXPAND_24_TO_32 },
+        { g_ddpf_rgb, 24, 0x000000FF, 0x0000FF00, 0x00FF0000, 0x00000000, Interface::RHI::Format::R8G8B8A8_UNORM, DDSConversion::EXPAND_24_TO_32 },
+        { g_ddpf_rgb, 16, 0x00007C00, 0x000003E0, 0x0000001F, 0x00008000, Interface::RHI::Format::B5G5R5A1_UNORM_PACK16, DDSConversion::NONE },
+        { g_ddpf_rgb, 16, 0x00007C00, 0x000003E0, 0x0000001F, 0x00000000, Interface::RHI::Format::B5G5R5A1_UNORM_PACK16, DDSConversion::FILL_ALPHA_X1R5G5B5 },
+        { g_ddpf_rgb, 16, 0x0000F800, 0x000007E0, 0x0000001F, 0x00000000, Interface::RHI::Format::B5G6R5_UNORM_PACK16, DDSConversion::NONE },
+        { g_ddpf_rgb, 16, 0x00000F00, 0x000000F0, 0x0000000F, 0x0000F000, Interface::RHI::Format::B4G4R4A4_UNORM_PACK16, DDSConversion::NONE },
+        { g_ddpf_rgb, 16, 0x00000F00, 0x000000F0, 0x0000000F, 0x00000000, Interface::RHI::Format::B4G4R4A4_UNORM_PACK16, DDSConversion::FILL_ALPHA_X4R4G4B4 },
+        { g_ddpf_luminance, 8, 0x000000FF, 0x00000000, 0x00000000, 0x00000000, Interface::RHI::Format::R8_UNORM, DDSConversion::NONE },
+        { g_ddpf_luminance, 16, 0x0000FFFF, 0x00000000, 0x00000000, 0x00000000, Interface::RHI::Format::R16_UNORM, DDSConversion::NONE },
+        { g_ddpf_luminance, 16, 0x000000FF, 0x00000000, 0x00000000, 0x0000FF00, Interface::RHI::Format::R8G8_UNORM, DDSConversion::NONE },
+        // Alpha only, sampled through the red channel.
+        { g_ddpf_alpha, 8, 0x00000000, 0x00000000, 0x00000000, 0x000000FF, Interface::RHI::Format::R8_UNORM, DDSConversion::NONE },
+        { g_ddpf_bumpdudv, 16, 0x000000FF, 0x0000FF00, 0x00000000, 0x00000000, Interface::RHI::Format::R8G8_SNORM, DDSConversion::NONE },
+        { g_ddpf_bumpdudv, 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000, Interface::RHI::Format::R8G8B8A8_SNORM, DDSConversion::NONE },
+        { g_ddpf_bumpdudv, 32, 0x0000FFFF, 0xFFFF0000, 0x00000000, 0x00000000, Interface::RHI::Format::R16G16_SNORM, DDSConversion::NONE },
+    };
+
+    static bool resolveLegacyDDSFormat(const DDS_PIXELFORMAT& pixel_format, DDSImageDesc& desc)
+    {
+        if((pixel_format.dwFlags & g_ddpf_fourcc) != 0)
+        {
+            for(const DDSLegacyFourCC& legacy_fourcc : g_dds_legacy_fourccs)
+            {
+                if(legacy_fourcc.m_fourcc == pixel_format.dwFourCC)
+                {
+                    desc.m_format = legacy_fourcc.m_format;
+                    return true;
+                }
+            }
+            Core::Logger::error("dds loaded failed: unsupported fourcc {}", pixel_format.dwFourCC);
+            return false;
+        }
+
+        for(const DDSLegacyPixelFormat& legacy_format : g_dds_legacy_pixel_formats)
+        {
+            if((pixel_format.dwFlags & legacy_format.m_flags) != 0
+                && pixel_format.dwRGBBitCount == legacy_format.m_bit_count
+                && pixel_format.dwRBitMask == legacy_format.m_r_mask
+                && pixel_format.dwGBitMask == legacy_format.m_g_mask
+                && pixel_format.dwBBitMask == legacy_format.m_b_mask
+                && pixel_format.dwABitMask == legacy_format.m_a_mask)
+            {
+                desc.m_format = legacy_format.m_format;
+                desc.m_conversion = legacy_format.m_conversion;
+                return true;
+            }
+        }
+        Core::Logger::error(
+            "dds loaded failed: unsupported pixel format, flags {} bits {} masks {} {} {} {}",
+            pixel_format.dwFlags,
+            pixel_format.dwRGBBitCount,
+            pixel_format.dwRBitMask,
+            pixel_format.dwGBitMask,
+            pixel_format.dwBBitMask,
+            pixel_format.dwABitMask
+        );
+        return false;
+    }
+
+    // DXGI formats without an RHI twin that convert to one.
+    static void resolveDXGIConversion(DXGI_FORMAT dxgi_format, DDSImageDesc& desc)
+    {
+        switch(dxgi_format)
+        {
+        case DXGI_FORMAT::DXGI_FORMAT_B8G8R8X8_TYPELESS:
+        case DXGI_FORMAT::DXGI_FORMAT_B8G8R8X8_UNORM:
+            desc.m_format = Interface::RHI::Format::B8G8R8A8_UNORM;
+            desc.m_conversion = DDSConversion::FILL_ALPHA_32;
+            break;
+        case DXGI_FORMAT::DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            desc.m_format = Interface::RHI::Format::B8G8R8A8_SRGB;
+            desc.m_conversion = DDSConversion::FILL_ALPHA_32;
+            break;
+        case DXGI_FORMAT::DXGI_FORMAT_R10G10B10A2_TYPELESS:
+        case DXGI_FORMAT::DXGI_FORMAT_R10G10B10A2_UNORM:
+            desc.m_format = Interface::RHI::Format::R16G16B16A16_UNORM;
+            desc.m_conversion = DDSConversion::UNPACK_R10G10B10A2;
+            break;
+        case DXGI_FORMAT::DXGI_FORMAT_R11G11B10_FLOAT:
+            desc.m_format = Interface::RHI::Format::R16G16B16A16_SFLOAT;
+            desc.m_conversion = DDSConversion::UNPACK_R11G11B10_FLOAT;
+            break;
+        default:
+            break;
+        }
+    }
+
+    size_t getDDSHeaderSize(const void* buffer, size_t size)
+    {
+        size_t legacy_header_size = sizeof(g_dds_magic_number) + sizeof(DDSHeader);
+        if(buffer == nullptr || size < legacy_header_size)
+        {
+            return 0;
+        }
+        const DDSHeader* dds_header = (const DDSHeader*)((const std::byte*)buffer + sizeof(g_dds_magic_number));
+        if((dds_header->ddspf.dwFlags & g_ddpf_fourcc) != 0
+            && dds_header->ddspf.dwFourCC == '01XD')
+        {
+            return legacy_header_size + sizeof(DDS_HEADER_DXT10);
+        }
+        return legacy_header_size;
+    }
+
+    bool parseDDSHeader(const void* buffer, size_t size, DDSImageDesc& desc)
+    {
+        if(buffer == nullptr || size < sizeof(g_dds_magic_number) + sizeof(DDSHeader))
+        {
+            Core::Logger::error("dds loaded failed: buffer too small for header");
+            return false;
+        }
+
+        const std::uint32_t* magic_number = (const std::uint32_t*)buffer;
         if(*magic_number != g_dds_magic_number)
         {
             Core::Logger::trace("dds loaded failed: magic number wrong");
+            return false;
+        }
+
+        const DDSHeader* dds_header = (const DDSHeader*)((const std::byte*)buffer + sizeof(g_dds_magic_number));
+        if(dds_header->dwSize != sizeof(DDSHeader))
+        {
+            Core::Logger::error("dds loaded failed: unexpected header size {}", dds_header->dwSize);
+            return false;
         }
 
-        DDSHeader* dds_header = (DDSHeader*)((std::byte*)buffer + sizeof(g_dds_magic_number));
-        DDS_HEADER_DXT10* dds_header_dxt10 = nullptr;
-        void* texture_buffer = nullptr;
-        size_t texture_buffer_size = 0;
-        Interface::RHI::Format texture_buffer_format = Interface::RHI::Format::UNKNOWN;
-        if((dds_header->ddspf.dwFlags & 0x000000004) != 0 //DDPF_FORCC
+        desc = DDSImageDesc{};
+        desc.m_width = std::max<std::uint32_t>(dds_header->dwWidth, 1);
+        desc.m_height = std::max<std::uint32_t>(dds_header->dwHeight, 1);
+        desc.m_mip_map_count = std::max<std::uint32_t>(dds_header->dwMipMapCount, 1);
+
+        if(dds_header->dwReserved1[g_dds_supercompression_mark_slot] == g_dds_supercompression_mark)
+        {
+            desc.m_supercompression = (Supercompression)dds_header->dwReserved1[g_dds_supercompression_scheme_slot];
+            if(desc.m_supercompression != Supercompression::LZ4 && desc.m_supercompression != Supercompression::ZSTD)
+            {
+                Core::Logger::error("dds loaded failed: unknown supercompression {}", dds_header->dwReserved1[g_dds_supercompression_scheme_slot]);
+                return false;
+            }
+        }
+
+        if((dds_header->ddspf.dwFlags & g_ddpf_fourcc) != 0
             && dds_header->ddspf.dwFourCC == '01XD')  // "DX10" as a FourCC
         {
-            dds_header_dxt10 = (DDS_HEADER_DXT10*)((std::byte*)buffer + sizeof(g_dds_magic_number) + dds_header->dwSize);
-            texture_buffer = ((std::byte*)buffer + sizeof(g_dds_magic_number) + dds_header->dwSize + sizeof(DDS_HEADER_DXT10));
-            texture_buffer_size = size - dds_header->dwSize - sizeof(g_dds_magic_number) - sizeof(DDS_HEADER_DXT10);
-            texture_buffer_format = Base::mapEnum<Interface::RHI::Format>(dds_header_dxt10->dxgiFormat);
+            if(size < sizeof(g_dds_magic_number) + sizeof(DDSHeader) + sizeof(DDS_HEADER_DXT10))
+            {
+                Core::Logger::error("dds loaded failed: buffer too small for dx10 header");
+                return false;
+            }
+
+            const DDS_HEADER_DXT10* dds_header_dxt10 = (const DDS_HEADER_DXT10*)((const std::byte*)buffer + sizeof(g_dds_magic_number) + dds_header->dwSize);
+            desc.m_data_offset = sizeof(g_dds_magic_number) + dds_header->dwSize + sizeof(DDS_HEADER_DXT10);
+            {
+                ImageStageTimer timer(ImageLoadStage::MAP_FORMAT);
+                desc.m_format = Base::mapEnum<Interface::RHI::Format>(dds_header_dxt10->dxgiFormat);
+                resolveDXGIConversion(dds_header_dxt10->dxgiFormat, desc);
+            }
+            desc.m_array_size = std::max<std::uint32_t>(dds_header_dxt10->arraySize, 1);
+
+            switch(dds_header_dxt10->resourceDimension)
+            {
+            case D3D10_RESOURCE_DIMENSION::D3D10_RESOURCE_DIMENSION_TEXTURE1D:
+                desc.m_dimension = ImageDimension::TEXTURE_1D;
+                desc.m_height = 1;
+                break;
+            case D3D10_RESOURCE_DIMENSION::D3D10_RESOURCE_DIMENSION_TEXTURE2D:
+                if((dds_header_dxt10->miscFlag & g_dds_resource_misc_texturecube) != 0)
+                {
+                    if(desc.m_array_size > g_max_image_array_size / 6)
+                    {
+                        Core::Logger::error("dds loaded failed: {} cubes exceed the layer limit", desc.m_array_size);
+                        return false;
+                    }
+                    desc.m_dimension = ImageDimension::TEXTURE_CUBE;
+                    desc.m_array_size *= 6;
+                }
+                break;
+            case D3D10_RESOURCE_DIMENSION::D3D10_RESOURCE_DIMENSION_TEXTURE3D:
+                if(desc.m_array_size != 1)
+                {
+                    Core::Logger::error("dds loaded failed: volume texture arrays are not supported");
+                    return false;
+                }
+                desc.m_dimension = ImageDimension::TEXTURE_3D;
+                desc.m_depth = std::max<std::uint32_t>(dds_header->dwDepth, 1);
+                break;
+            default:
+                Core::Logger::error("dds loaded failed: unsupported resource dimension");
+                return false;
+            }
         }
         else
         {
-            texture_buffer = ((std::byte*)buffer + sizeof(g_dds_magic_number) + dds_header->dwSize);
-            texture_buffer_size = size - dds_header->dwSize - sizeof(g_dds_magic_number);
+            desc.m_data_offset = sizeof(g_dds_magic_number) + dds_header->dwSize;
+
+            bool is_format_resolved = false;
+            {
+                ImageStageTimer timer(ImageLoadStage::MAP_FORMAT);
+                is_format_resolved = resolveLegacyDDSFormat(dds_header->ddspf, desc);
+            }
+            if(is_format_resolved == false)
+            {
+                return false;
+            }
+
+            if((dds_header->dwCaps2 & g_ddscaps2_cubemap) != 0)
+            {
+                // Legacy cube maps may omit faces; only the present ones are stored.
+                desc.m_dimension = ImageDimension::TEXTURE_CUBE;
+                desc.m_array_size = (std::uint32_t)std::bitset<32>(dds_header->dwCaps2 & g_ddscaps2_cubemap_all_faces).count();
+                if(desc.m_array_size == 0)
+                {
+                    desc.m_array_size = 6;
+                }
+            }
+            else if((dds_header->dwCaps2 & g_ddscaps2_volume) != 0
+                && (dds_header->dwFlags & g_ddsd_depth) != 0)
+            {
+                desc.m_dimension = ImageDimension::TEXTURE_3D;
+                desc.m_depth = std::max<std::uint32_t>(dds_header->dwDepth, 1);
+            }
+        }
+
+        if(isImageExtentSupported(desc.m_width, desc.m_height, desc.m_depth, desc.m_mip_map_count, desc.m_array_size) == false)
+        {
+            Core::Logger::error(
+                "dds loaded failed: {}x{}x{} with {} mips and {} layers is out of range",
+                desc.m_width,
+                desc.m_height,
+                desc.m_depth,
+                desc.m_mip_map_count,
+                desc.m_array_size
+            );
+            return false;
+        }
+
+        return true;
+    }
+
+    // Both layouts are tightly packed in the same order, so the whole payload
+    // converts as one run of texels, split into chunks. source and destination
+    // may be the same for conversions that keep the texel size.
+    static void convertDDSPayload(TaskPool& task_pool, DDSConversion conversion, const std::byte* source, std::byte* destination, size_t texel_count, size_t destination_texel_size)
+    {
+        size_t source_texel_size = getDDSConversionSourceTexelSize(conversion);
+        size_t chunk_count = (texel_count + g_dds_conversion_chunk_texels - 1) / g_dds_conversion_chunk_texels;
+        SimdLevel simd_level = getSimdLevel();
+        task_pool.parallelFor(chunk_count, 1, [&](size_t begin, size_t end)
+        {
+            for(size_t chunk = begin; chunk < end; ++chunk)
+            {
+                size_t first_texel = chunk * g_dds_conversion_chunk_texels;
+                convertDDSTexels(
+                    conversion,
+                    simd_level,
+                    source + first_texel * source_texel_size,
+                    destination + first_texel * destination_texel_size,
+                    std::min(g_dds_conversion_chunk_texels, texel_count - first_texel)
+                );
+            }
+        });
+    }
+
+    static bool readDDSSupercompressedRanges(const DDSImageDesc& desc, size_t size, const void* buffer, size_t subresource_count, DDSSupercompressedRange* ranges)
+    {
+        size_t table_size = subresource_count * sizeof(DDSSupercompressedRange);
+        if(desc.m_data_offset + table_size > size)
+        {
+            Core::Logger::error("dds loaded failed: supercompression table truncated");
+            return false;
+        }
+        // The table follows a 128 or 148 byte header, copy it out to read it aligned.
+        std::memcpy(ranges, (const std::byte*)buffer + desc.m_data_offset, table_size);
+        for(size_t index = 0; index < subresource_count; ++index)
+        {
+            const DDSSupercompressedRange& range = ranges[index];
+            if(range.m_offset > size || range.m_size > size - range.m_offset)
+            {
+                Core::Logger::error("dds loaded failed: supercompressed subresource outside the file");
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Every subresource is a block of its own, they decompress in parallel
+    // straight to their place in destination.
+    static bool decompressDDSSubresources(TaskPool& task_pool, const DDSImageDesc& desc, const void* buffer, size_t size, const ImageLayout& layout, void* destination)
+    {
+        // Workers only read the table, it can live in this thread's arena.
+        ScratchScope scratch;
+        size_t subresource_count = layout.m_subresources.size();
+        DDSSupercompressedRange* ranges = scratch.getArena().allocateArray<DDSSupercompressedRange>(subresource_count);
+        if(ranges == nullptr || readDDSSupercompressedRanges(desc, size, buffer, subresource_count, ranges) == false)
+        {
+            return false;
+        }
+
+        std::atomic<bool> failed{false};
+        task_pool.parallelFor(subresource_count, 1, [&](size_t begin, size_t end)
+        {
+            for(size_t index = begin; index < end && failed.load(std::memory_order_relaxed) == false; ++index)
+            {
+                const ImageSubresource& subresource = layout.m_subresources[index];
+                if(decompressBlock(
+                    desc.m_supercompression,
+                    (const std::byte*)buffer + ranges[index].m_offset,
+                    (size_t)ranges[index].m_size,
+                    (std::byte*)destination + subresource.m_offset,
+                    subresource.m_size) == false)
+                {
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+        });
+        return failed.load() == false;
+    }
+
+    bool compressDDS(const void* buffer, size_t size, Supercompression scheme, int level, std::vector<std::byte>& output)
+    {
+        DDSImageDesc desc;
+        if(parseDDSHeader(buffer, size, desc) == false)
+        {
+            return false;
+        }
+        if(desc.m_supercompression != Supercompression::NONE || desc.m_conversion != DDSConversion::NONE)
+        {
+            Core::Logger::error("dds compress failed: file is supercompressed already or needs a conversion");
+            return false;
+        }
+
+        ImageLayout layout;
+        size_t texture_buffer_size = buildImageLayout(
+            layout,
+            desc.m_format,
+            desc.m_dimension,
+            desc.m_width,
+            desc.m_height,
+            desc.m_depth,
+            desc.m_mip_map_count,
+            desc.m_array_size
+        );
+        if(texture_buffer_size == 0 || texture_buffer_size > size - desc.m_data_offset)
+        {
+            Core::Logger::error("dds compress failed: unsized format or truncated payload");
+            return false;
+        }
+
+        output.assign((const std::byte*)buffer, (const std::byte*)buffer + desc.m_data_offset);
+        DDSHeader* dds_header = (DDSHeader*)(output.data() + sizeof(g_dds_magic_number));
+        dds_header->dwReserved1[g_dds_supercompression_mark_slot] = g_dds_supercompression_mark;
+        dds_header->dwReserved1[g_dds_supercompression_scheme_slot] = (std::uint32_t)scheme;
 
-            if(dds_header->ddspf.dwRBitMask == 0x000000FF)
+        size_t table_offset = output.size();
+        std::vector<DDSSupercompressedRange> ranges(layout.m_subresources.size());
+        output.resize(table_offset + ranges.size() * sizeof(DDSSupercompressedRange));
+
+        const std::byte* payload = (const std::byte*)buffer + desc.m_data_offset;
+        for(size_t index = 0; index < ranges.size(); ++index)
+        {
+            const ImageSubresource& subresource = layout.m_subresources[index];
+            ranges[index].m_offset = output.size();
+            if(compressBlock(scheme, level, payload + subresource.m_offset, subresource.m_size, output) == false)
             {
-                texture_buffer_format = Interface::RHI::Format::R8G8B8A8_UNORM;
+                return false;
             }
-            else
+            ranges[index].m_size = output.size() - ranges[index].m_offset;
+        }
+        std::memcpy(output.data() + table_offset, ranges.data(), ranges.size() * sizeof(DDSSupercompressedRange));
+        return true;
+    }
+
+    Interface::FileLoader::ImageBuffer ImageLoader::loadDDS(void* buffer, size_t size)
+    {
+        logMetricsIfDue();
+        ImageLayout layout;
+        return loadDDSInBuffer(buffer, size, true, layout);
+    }
+
+    Interface::FileLoader::ImageBuffer ImageLoader::loadDDS(void* buffer, size_t size, ImageLayout& layout)
+    {
+        return loadDDSInBuffer(buffer, size, false, layout);
+    }
+
+    Interface::FileLoader::ImageBuffer ImageLoader::loadDDSInBuffer(void* buffer, size_t size, bool is_buffer_writable, ImageLayout& layout)
+    {
+        ImageLoadRecord record(ImageContainer::DDS, size);
+        DDSImageDesc desc;
+        bool is_header_valid = false;
+        {
+            ImageStageTimer timer(ImageLoadStage::PARSE_HEADER);
+            is_header_valid = parseDDSHeader(buffer, size, desc);
+        }
+        if(is_header_valid == false)
+        {
+            layout = ImageLayout{};
+            return Interface::FileLoader::ImageBuffer{};
+        }
+        if(desc.m_conversion != DDSConversion::NONE && is_buffer_writable == false)
+        {
+            // The buffer may be a read only mapping, conversions need memory of their own.
+            Core::Logger::error("dds loaded failed: texels need conversion, load the file with an allocator");
+            layout = ImageLayout{};
+            return Interface::FileLoader::ImageBuffer{};
+        }
+        if(desc.m_conversion != DDSConversion::NONE && isDDSConversionInPlace(desc.m_conversion) == false)
+        {
+            Core::Logger::error("dds loaded failed: texels change size in conversion, load the file with an allocator");
+            layout = ImageLayout{};
+            return Interface::FileLoader::ImageBuffer{};
+        }
+        if(desc.m_supercompression != Supercompression::NONE)
+        {
+            Core::Logger::error("dds loaded failed: payload is supercompressed, load the file with an allocator");
+            layout = ImageLayout{};
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        size_t texture_buffer_size = buildImageLayout(
+            layout,
+            desc.m_format,
+            desc.m_dimension,
+            desc.m_width,
+            desc.m_height,
+            desc.m_depth,
+            desc.m_mip_map_count,
+            desc.m_array_size
+        );
+
+        size_t payload_size = size - desc.m_data_offset;
+        if(texture_buffer_size == 0 && getImageFormatInfo(desc.m_format).m_bytes_per_block != 0)
+        {
+            // Sized format whose layout overflowed, buildImageLayout logged why.
+            layout = ImageLayout{};
+            return Interface::FileLoader::ImageBuffer{};
+        }
+        if(texture_buffer_size == 0)
+        {
+            // Format without a known texel size, hand out the raw payload without a layout.
+            Core::Logger::trace("dds loaded without subresource layout: unsized format");
+            texture_buffer_size = payload_size;
+        }
+        else if(texture_buffer_size > payload_size)
+        {
+            Core::Logger::error("dds loaded failed: payload truncated, expected {} bytes, got {}", texture_buffer_size, payload_size);
+            layout = ImageLayout{};
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        if(desc.m_conversion != DDSConversion::NONE)
+        {
+            ImageStageTimer timer(ImageLoadStage::CONVERT);
+            std::byte* texels = (std::byte*)buffer + desc.m_data_offset;
+            size_t texel_size = getDDSConversionSourceTexelSize(desc.m_conversion);
+            convertDDSPayload(m_task_pool, desc.m_conversion, texels, texels, texture_buffer_size / texel_size, texel_size);
+        }
+
+        Interface::FileLoader::ImageBuffer image_buffer{};
+        {
+            image_buffer.m_buffer = (std::byte*)buffer + desc.m_data_offset;
+            image_buffer.m_size = texture_buffer_size;
+
+            image_buffer.m_format = desc.m_format;
+
+            image_buffer.m_width = desc.m_width;
+            image_buffer.m_height = desc.m_height;
+            image_buffer.m_depth = desc.m_depth;
+            image_buffer.m_mip_map_count = desc.m_mip_map_count;
+        }
+
+        record.setResult(image_buffer);
+        return image_buffer;
+    }
+
+    Interface::FileLoader::ImageBuffer ImageLoader::loadDDS(const void* buffer, size_t size, const ImageAllocator& allocator, ImageLayout& layout)
+    {
+        ImageLoadRecord record(ImageContainer::DDS, size);
+        DDSImageDesc desc;
+        bool is_header_valid = false;
+        {
+            ImageStageTimer timer(ImageLoadStage::PARSE_HEADER);
+            is_header_valid = parseDDSHeader(buffer, size, desc);
+        }
+        if(is_header_valid == false)
+        {
+            layout = ImageLayout{};
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        size_t texture_buffer_size = buildImageLayout(
+            layout,
+            desc.m_format,
+            desc.m_dimension,
+            desc.m_width,
+            desc.m_height,
+            desc.m_depth,
+            desc.m_mip_map_count,
+            desc.m_array_size
+        );
+
+        if(desc.m_supercompression != Supercompression::NONE)
+        {
+            if(desc.m_conversion != DDSConversion::NONE || texture_buffer_size == 0)
+            {
+                Core::Logger::error("dds loaded failed: supercompressed payload of format {} without a layout", (std::uint32_t)desc.m_format);
+                layout = ImageLayout{};
+                return Interface::FileLoader::ImageBuffer{};
+            }
+
+            void* destination = nullptr;
+            {
+                ImageStageTimer timer(ImageLoadStage::ALLOCATE);
+                destination = allocator(texture_buffer_size);
+            }
+            if(destination == nullptr)
+            {
+                Core::Logger::error("dds loaded failed: allocator returned null for {} bytes", texture_buffer_size);
+                layout = ImageLayout{};
+                return Interface::FileLoader::ImageBuffer{};
+            }
+            bool is_decompressed = false;
+            {
+                ImageStageTimer timer(ImageLoadStage::DECOMPRESS);
+                is_decompressed = decompressDDSSubresources(m_task_pool, desc, buffer, size, layout, destination);
+            }
+            if(is_decompressed == false)
+            {
+                layout = ImageLayout{};
+                return Interface::FileLoader::ImageBuffer{};
+            }
+
+            Interface::FileLoader::ImageBuffer image_buffer{};
             {
-                texture_buffer_format = Interface::RHI::Format::B8G8R8A8_UNORM;
+                image_buffer.m_buffer = destination;
+                image_buffer.m_size = texture_buffer_size;
+
+                image_buffer.m_format = desc.m_format;
+
+                image_buffer.m_width = desc.m_width;
+                image_buffer.m_height = desc.m_height;
+                image_buffer.m_depth = desc.m_depth;
+                image_buffer.m_mip_map_count = desc.m_mip_map_count;
             }
-            
+            record.setResult(image_buffer);
+            return image_buffer;
+        }
+
+        // On disk the subresources are laid out in the source texel size.
+        size_t source_size = texture_buffer_size;
+        std::uint32_t source_texel_size = getDDSConversionSourceTexelSize(desc.m_conversion);
+        if(desc.m_conversion != DDSConversion::NONE)
+        {
+            ImageLayout source_layout;
+            ImageFormatInfo source_format_info;
+            source_format_info.m_bytes_per_block = source_texel_size;
+            source_size = buildImageLayout(
+                source_layout,
+                source_format_info,
+                desc.m_dimension,
+                desc.m_width,
+                desc.m_height,
+                desc.m_depth,
+                desc.m_mip_map_count,
+                desc.m_array_size
+            );
+        }
+
+        size_t payload_size = size - desc.m_data_offset;
+        if(texture_buffer_size == 0 && getImageFormatInfo(desc.m_format).m_bytes_per_block != 0)
+        {
+            // Sized format whose layout overflowed, buildImageLayout logged why.
+            layout = ImageLayout{};
+            return Interface::FileLoader::ImageBuffer{};
+        }
+        if(texture_buffer_size == 0)
+        {
+            Core::Logger::trace("dds loaded without subresource layout: unsized format");
+            texture_buffer_size = source_size = payload_size;
+        }
+        else if(source_size > payload_size)
+        {
+            Core::Logger::error("dds loaded failed: payload truncated, expected {} bytes, got {}", source_size, payload_size);
+            layout = ImageLayout{};
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        void* destination = nullptr;
+        {
+            ImageStageTimer timer(ImageLoadStage::ALLOCATE);
+            destination = allocator(texture_buffer_size);
+        }
+        if(destination == nullptr)
+        {
+            Core::Logger::error("dds loaded failed: allocator returned null for {} bytes", texture_buffer_size);
+            layout = ImageLayout{};
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        const std::byte* source = (const std::byte*)buffer + desc.m_data_offset;
+        if(desc.m_conversion == DDSConversion::NONE)
+        {
+            ImageStageTimer timer(ImageLoadStage::COPY);
+            std::memcpy(destination, source, texture_buffer_size);
+        }
+        else
+        {
+            ImageStageTimer timer(ImageLoadStage::CONVERT);
+            size_t destination_texel_size = getImageFormatInfo(desc.m_format).m_bytes_per_block;
+            convertDDSPayload(m_task_pool, desc.m_conversion, source, (std::byte*)destination, source_size / source_texel_size, destination_texel_size);
         }
 
         Interface::FileLoader::ImageBuffer image_buffer{};
         {
-            image_buffer.m_buffer = texture_buffer;
+            image_buffer.m_buffer = destination;
             image_buffer.m_size = texture_buffer_size;
 
-            image_buffer.m_format = texture_buffer_format;
+            image_buffer.m_format = desc.m_format;
 
-            image_buffer.m_width = dds_header->dwWidth;
-            image_buffer.m_height = dds_header->dwHeight;
-            image_buffer.m_depth = dds_header->dwDepth;
-            image_buffer.m_mip_map_count = dds_header->dwMipMapCount;
+            image_buffer.m_width = desc.m_width;
+            image_buffer.m_height = desc.m_height;
+            image_buffer.m_depth = desc.m_depth;
+            image_buffer.m_mip_map_count = desc.m_mip_map_count;
         }
 
+        record.setResult(image_buffer);
         return image_buffer;
     }
 }
\ No newline at end of file
@@ -0,0 +1,320 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "dds_stream_loader.h"
+#include "image_format.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace Arieo
+{
+    DDSStreamLoader::DDSStreamLoader(DDSStreamOrder order, ImageAllocator allocator, MipCallback on_mip_ready)
+        : m_order(order),
+          m_allocator(std::move(allocator)),
+          m_on_mip_ready(std::move(on_mip_ready))
+    {
+    }
+
+    bool DDSStreamLoader::fail()
+    {
+        m_failed = true;
+        return false;
+    }
+
+    bool DDSStreamLoader::append(const void* data, size_t size)
+    {
+        size_t file_offset = hasHeader() ? m_desc.m_data_offset : m_header_bytes.size();
+        if(hasHeader())
+        {
+            // Sequential feeding continues behind the highest byte received so far.
+            file_offset += m_received.empty() ? 0 : std::prev(m_received.end())->second;
+        }
+        return write(file_offset, data, size);
+    }
+
+    bool DDSStreamLoader::write(size_t file_offset, const void* data, size_t size)
+    {
+        if(m_failed)
+        {
+            return false;
+        }
+        if(data == nullptr || size == 0 || isComplete())
+        {
+            return true;
+        }
+
+        if(hasHeader() == false)
+        {
+            if(file_offset > m_header_bytes.size())
+            {
+                Core::Logger::error("dds stream failed: chunk at {} arrived before the header", file_offset);
+                return fail();
+            }
+            m_header_bytes.resize(std::max(m_header_bytes.size(), file_offset + size));
+            std::memcpy(m_header_bytes.data() + file_offset, data, size);
+            return parseHeader();
+        }
+
+        // Drop whatever part of the chunk belongs to the header.
+        if(file_offset + size <= m_desc.m_data_offset)
+        {
+            return true;
+        }
+        if(file_offset < m_desc.m_data_offset)
+        {
+            size_t header_part = m_desc.m_data_offset - file_offset;
+            data = (const std::byte*)data + header_part;
+            size -= header_part;
+            file_offset = m_desc.m_data_offset;
+        }
+
+        size_t payload_size = m_file_size - m_desc.m_data_offset;
+        size_t begin = file_offset - m_desc.m_data_offset;
+        size_t end = std::min(begin + size, payload_size);
+        if(begin >= end)
+        {
+            return true;
+        }
+
+        std::byte* target = m_desc.m_conversion != DDSConversion::NONE ? m_staging.data() : (std::byte*)m_image_buffer.m_buffer;
+        std::memcpy(target + begin, data, end - begin);
+        markReceived(begin, end);
+        completeSubresources(begin, end);
+        return true;
+    }
+
+    bool DDSStreamLoader::parseHeader()
+    {
+        size_t header_size = getDDSHeaderSize(m_header_bytes.data(), m_header_bytes.size());
+        if(header_size == 0 || m_header_bytes.size() < header_size)
+        {
+            return true;
+        }
+        if(parseDDSHeader(m_header_bytes.data(), m_header_bytes.size(), m_desc) == false)
+        {
+            return fail();
+        }
+        if(m_desc.m_supercompression != Supercompression::NONE)
+        {
+            // Blocks only decode whole, there is nothing to report per chunk.
+            Core::Logger::error("dds stream failed: supercompressed files have to be loaded whole");
+            return fail();
+        }
+
+        size_t image_size = buildImageLayout(
+            m_layout,
+            m_desc.m_format,
+            m_desc.m_dimension,
+            m_desc.m_width,
+            m_desc.m_height,
+            m_desc.m_depth,
+            m_desc.m_mip_map_count,
+            m_desc.m_array_size
+        );
+        if(image_size == 0)
+        {
+            // Without a layout there are no mips to report.
+            Core::Logger::error("dds stream failed: unsized format {}", (std::uint32_t)m_desc.m_format);
+            return fail();
+        }
+
+        ImageFormatInfo source_format_info = getImageFormatInfo(m_desc.m_format);
+        if(m_desc.m_conversion != DDSConversion::NONE)
+        {
+            source_format_info = ImageFormatInfo{};
+            source_format_info.m_bytes_per_block = getDDSConversionSourceTexelSize(m_desc.m_conversion);
+        }
+        size_t source_size = buildImageLayout(
+            m_source_layout,
+            source_format_info,
+            m_desc.m_dimension,
+            m_desc.m_width,
+            m_desc.m_height,
+            m_desc.m_depth,
+            m_desc.m_mip_map_count,
+            m_desc.m_array_size
+        );
+
+        void* destination = m_allocator(image_size);
+        if(destination == nullptr)
+        {
+            Core::Logger::error("dds stream failed: allocator returned null for {} bytes", image_size);
+            return fail();
+        }
+        if(m_desc.m_conversion != DDSConversion::NONE)
+        {
+            m_staging.resize(source_size);
+        }
+
+        m_file_size = m_desc.m_data_offset + source_size;
+        {
+            m_image_buffer.m_buffer = destination;
+            m_image_buffer.m_size = image_size;
+
+            m_image_buffer.m_format = m_desc.m_format;
+
+            m_image_buffer.m_width = m_desc.m_width;
+            m_image_buffer.m_height = m_desc.m_height;
+            m_image_buffer.m_depth = m_desc.m_depth;
+            m_image_buffer.m_mip_map_count = m_layout.m_mip_map_count;
+        }
+
+        m_subresource_ready.assign(m_layout.m_subresources.size(), false);
+        m_mip_ready_layer_count.assign(m_layout.m_mip_map_count, 0);
+
+        if(m_order == DDSStreamOrder::BACK_TO_FRONT)
+        {
+            for(std::uint32_t mip_level = m_layout.m_mip_map_count; mip_level-- > 0;)
+            {
+                for(std::uint32_t array_layer = 0; array_layer < m_layout.m_array_size; ++array_layer)
+                {
+                    const ImageSubresource* subresource = m_source_layout.getSubresource(mip_level, array_layer);
+                    m_read_plan.emplace_back(subresource->m_offset, subresource->m_offset + subresource->m_size);
+                }
+            }
+        }
+        else
+        {
+            m_read_plan.emplace_back(0, source_size);
+        }
+
+        // The chunks that carried the header may already hold texels.
+        std::vector<std::byte> header_bytes = std::move(m_header_bytes);
+        m_header_bytes.clear();
+        if(header_bytes.size() > m_desc.m_data_offset)
+        {
+            return write(m_desc.m_data_offset, header_bytes.data() + m_desc.m_data_offset, header_bytes.size() - m_desc.m_data_offset);
+        }
+        return true;
+    }
+
+    void DDSStreamLoader::markReceived(size_t begin, size_t end)
+    {
+        auto next = m_received.upper_bound(begin);
+        if(next != m_received.begin())
+        {
+            auto previous = std::prev(next);
+            if(previous->second >= begin)
+            {
+                begin = previous->first;
+                end = std::max(end, previous->second);
+                m_received.erase(previous);
+            }
+        }
+        while(next != m_received.end() && next->first <= end)
+        {
+            end = std::max(end, next->second);
+            next = m_received.erase(next);
+        }
+        m_received.emplace(begin, end);
+    }
+
+    bool DDSStreamLoader::isReceived(size_t begin, size_t end) const
+    {
+        auto range = m_received.upper_bound(begin);
+        if(range == m_received.begin())
+        {
+            return false;
+        }
+        return std::prev(range)->second >= end;
+    }
+
+    void DDSStreamLoader::completeSubresources(size_t begin, size_t end)
+    {
+        SimdLevel simd_level = getSimdLevel();
+        for(size_t subresource_index = 0; subresource_index < m_source_layout.m_subresources.size(); ++subresource_index)
+        {
+            const ImageSubresource& source = m_source_layout.m_subresources[subresource_index];
+            if(m_subresource_ready[subresource_index]
+                || source.m_offset >= end
+                || source.m_offset + source.m_size <= begin
+                || isReceived(source.m_offset, source.m_offset + source.m_size) == false)
+            {
+                continue;
+            }
+
+            m_subresource_ready[subresource_index] = true;
+            if(m_desc.m_conversion != DDSConversion::NONE)
+            {
+                const ImageSubresource& target = m_layout.m_subresources[subresource_index];
+                convertDDSTexels(
+                    m_desc.m_conversion,
+                    simd_level,
+                    m_staging.data() + source.m_offset,
+                    (std::byte*)m_image_buffer.m_buffer + target.m_offset,
+                    (size_t)source.m_width * source.m_height * source.m_depth
+                );
+            }
+
+            if(++m_mip_ready_layer_count[source.m_mip_level] == m_layout.m_array_size)
+            {
+                ++m_ready_mip_count;
+                if(m_on_mip_ready)
+                {
+                    m_on_mip_ready(source.m_mip_level, m_image_buffer, m_layout);
+                }
+            }
+        }
+
+        if(isComplete())
+        {
+            m_staging = std::vector<std::byte>();
+            m_received.clear();
+        }
+    }
+
+    bool DDSStreamLoader::getNextReadRange(size_t max_size, size_t& file_offset, size_t& size)
+    {
+        if(m_failed || max_size == 0)
+        {
+            return false;
+        }
+
+        if(hasHeader() == false)
+        {
+            // The request is outstanding until bytes arrive at its offset. A
+            // short read leaves the header unparsed, the rest is asked for again.
+            if(m_header_requested && m_header_bytes.size() == m_header_request_offset)
+            {
+                return false;
+            }
+            m_header_requested = true;
+            m_header_request_offset = m_header_bytes.size();
+            file_offset = m_header_request_offset;
+            size = g_dds_max_header_size - m_header_request_offset;
+            return true;
+        }
+
+        while(m_read_plan_index < m_read_plan.size())
+        {
+            const std::pair<size_t, size_t>& range = m_read_plan[m_read_plan_index];
+            size_t begin = range.first + m_read_plan_offset;
+            if(begin >= range.second)
+            {
+                ++m_read_plan_index;
+                m_read_plan_offset = 0;
+                continue;
+            }
+
+            size_t end = std::min(range.second, begin + max_size);
+            m_read_plan_offset += end - begin;
+            if(isComplete() || isReceived(begin, end))
+            {
+                continue;
+            }
+            file_offset = m_desc.m_data_offset + begin;
+            size = end - begin;
+            return true;
+        }
+        return false;
+    }
+
+    bool DDSStreamLoader::isMipReady(std::uint32_t mip_level) const
+    {
+        return hasHeader()
+            && mip_level < m_layout.m_mip_map_count
+            && m_mip_ready_layer_count[mip_level] == m_layout.m_array_size;
+    }
+}
\ No newline at end of file
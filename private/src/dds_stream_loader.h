@@ -0,0 +1,115 @@
+#pragma once
+#include "interface/file_loader/image_loader.h"
+#include "dds_format.h"
+#include "image_layout.h"
+#include "image_loader.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <vector>
+namespace Arieo
+{
+    enum class DDSStreamOrder : std::uint32_t
+    {
+        // Read the file in storage order, mip 0 completes first.
+        FRONT_TO_BACK,
+        // After the header read the smallest mip first and end with mip 0, so
+        // a low resolution version is ready after a fraction of the file.
+        BACK_TO_FRONT
+    };
+
+    // Builds a DDS image from chunks of the file as they arrive, e.g. from
+    // asynchronous reads of slow storage. The header is parsed as soon as its
+    // first 128 - 148 bytes are in, and every mip level is reported once the
+    // bytes of all its array layers are complete, legacy formats converted.
+    // Chunks may come in any order and overlap; getNextReadRange plans reads
+    // for the order given at construction. Not thread safe, feed it from one
+    // thread at a time.
+    class DDSStreamLoader
+    {
+    public:
+        // image_buffer and layout describe the whole image, only the mips
+        // reported so far hold valid texels.
+        using MipCallback = std::function<void(
+            std::uint32_t mip_level,
+            const Interface::FileLoader::ImageBuffer& image_buffer,
+            const ImageLayout& layout
+        )>;
+
+        DDSStreamLoader(DDSStreamOrder order, ImageAllocator allocator, MipCallback on_mip_ready);
+
+        DDSStreamLoader(const DDSStreamLoader&) = delete;
+        DDSStreamLoader& operator=(const DDSStreamLoader&) = delete;
+
+        // Feeds the next chunk of a sequential read.
+        bool append(const void* data, size_t size);
+
+        // Feeds a chunk read at file_offset. Until the header is parsed the
+        // chunks have to continue the file from its start. Returns false once
+        // the stream failed; the error is logged.
+        bool write(size_t file_offset, const void* data, size_t size);
+
+        // Next range to read, at most max_size bytes. Before the header is in
+        // this is the largest possible header, or its remainder after a short
+        // read; returns false while waiting for it and once every byte was
+        // requested.
+        bool getNextReadRange(size_t max_size, size_t& file_offset, size_t& size);
+
+        bool hasHeader() const { return m_image_buffer.m_buffer != nullptr; }
+        bool hasFailed() const { return m_failed; }
+        bool isComplete() const { return hasHeader() && m_ready_mip_count == m_layout.m_mip_map_count; }
+
+        // Size of the whole file, 0 until the header is parsed.
+        size_t getFileSize() const { return m_file_size; }
+
+        const Interface::FileLoader::ImageBuffer& getImageBuffer() const { return m_image_buffer; }
+        const ImageLayout& getLayout() const { return m_layout; }
+        bool isMipReady(std::uint32_t mip_level) const;
+
+    private:
+        bool parseHeader();
+        bool fail();
+
+        // Adds [begin, end) of the payload to m_received, merging neighbours.
+        void markReceived(size_t begin, size_t end);
+        bool isReceived(size_t begin, size_t end) const;
+
+        // Completes every subresource that overlaps [begin, end) of the payload
+        // and has all its bytes now.
+        void completeSubresources(size_t begin, size_t end);
+
+        DDSStreamOrder m_order;
+        ImageAllocator m_allocator;
+        MipCallback m_on_mip_ready;
+        bool m_failed = false;
+
+        // File bytes from offset 0 until the header is parsed.
+        std::vector<std::byte> m_header_bytes;
+        bool m_header_requested = false;
+        size_t m_header_request_offset = 0;
+
+        DDSImageDesc m_desc;
+        size_t m_file_size = 0;
+        Interface::FileLoader::ImageBuffer m_image_buffer{};
+        ImageLayout m_layout;
+
+        // Layout of the payload on disk, differs from m_layout for conversions.
+        ImageLayout m_source_layout;
+        std::uint32_t m_source_texel_size = 0;
+        // Converted formats are staged in their disk layout, others are
+        // written straight into the image buffer.
+        std::vector<std::byte> m_staging;
+
+        // Disjoint received payload ranges, begin to end.
+        std::map<size_t, size_t> m_received;
+        std::vector<bool> m_subresource_ready;
+        std::vector<std::uint32_t> m_mip_ready_layer_count;
+        std::uint32_t m_ready_mip_count = 0;
+
+        // Payload ranges in read order, see DDSStreamOrder.
+        std::vector<std::pair<size_t, size_t>> m_read_plan;
+        size_t m_read_plan_index = 0;
+        size_t m_read_plan_offset = 0;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,318 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "image_buffer_pool.h"
+
+#include <algorithm>
+#include <new>
+
+namespace Arieo
+{
+    static const size_t g_buffer_alignment = 64;
+    static const std::uint32_t g_min_class_exponent = 8;
+    static const std::uint32_t g_oversize_class = (std::uint32_t)ImageBufferPool::g_size_class_count;
+
+    static_assert(((size_t)1 << g_min_class_exponent) == g_image_buffer_pool_min_class_size, "size class table out of sync");
+
+    // Class 0 holds everything up to the minimum size, above it every power of
+    // two range (2^e, 2^(e+1)] is split into four classes.
+    static std::uint32_t getSizeClass(size_t size)
+    {
+        if(size <= g_image_buffer_pool_min_class_size)
+        {
+            return 0;
+        }
+        if(size > g_image_buffer_pool_max_class_size)
+        {
+            return g_oversize_class;
+        }
+        std::uint32_t exponent = g_min_class_exponent;
+        while(((size_t)2 << exponent) < size)
+        {
+            ++exponent;
+        }
+        size_t step = (size_t)1 << (exponent - 2);
+        size_t quarter = (size - 1 - ((size_t)1 << exponent)) / step;
+        return (exponent - g_min_class_exponent) * 4 + (std::uint32_t)quarter + 1;
+    }
+
+    static size_t getSizeClassSize(std::uint32_t size_class)
+    {
+        if(size_class == 0)
+        {
+            return g_image_buffer_pool_min_class_size;
+        }
+        std::uint32_t exponent = (size_class - 1) / 4 + g_min_class_exponent;
+        size_t quarter = (size_class - 1) % 4 + 1;
+        return ((size_t)1 << exponent) + quarter * ((size_t)1 << (exponent - 2));
+    }
+
+    static void* allocateAligned(size_t size)
+    {
+        return ::operator new(size, std::align_val_t(g_buffer_alignment), std::nothrow);
+    }
+
+    static void freeAligned(void* data)
+    {
+        ::operator delete(data, std::align_val_t(g_buffer_alignment));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // PooledBuffer
+
+    PooledBuffer::PooledBuffer(PooledBuffer&& other) noexcept
+        : m_pool(other.m_pool),
+          m_data(other.m_data),
+          m_size(other.m_size),
+          m_size_class(other.m_size_class)
+    {
+        other.m_pool = nullptr;
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+
+    PooledBuffer& PooledBuffer::operator=(PooledBuffer&& other) noexcept
+    {
+        if(this != &other)
+        {
+            reset();
+            m_pool = other.m_pool;
+            m_data = other.m_data;
+            m_size = other.m_size;
+            m_size_class = other.m_size_class;
+            other.m_pool = nullptr;
+            other.m_data = nullptr;
+            other.m_size = 0;
+        }
+        return *this;
+    }
+
+    void PooledBuffer::reset()
+    {
+        if(m_data != nullptr)
+        {
+            m_pool->release(m_data, m_size, m_size_class);
+        }
+        m_pool = nullptr;
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // ImageBufferPool
+
+    ImageBufferPool::ImageBufferPool(size_t max_cached_bytes)
+        : m_max_cached_bytes(max_cached_bytes)
+    {
+    }
+
+    ImageBufferPool::~ImageBufferPool()
+    {
+        trim();
+    }
+
+    void ImageBufferPool::addPoolBytes(size_t size)
+    {
+        size_t pool_bytes = m_reserved_bytes.fetch_add(size, std::memory_order_relaxed) + size
+            + m_cached_bytes.load(std::memory_order_relaxed);
+        size_t high_water = m_high_water_bytes.load(std::memory_order_relaxed);
+        while(pool_bytes > high_water
+            && m_high_water_bytes.compare_exchange_weak(high_water, pool_bytes, std::memory_order_relaxed) == false)
+        {
+        }
+    }
+
+    PooledBuffer ImageBufferPool::allocate(size_t size)
+    {
+        PooledBuffer buffer;
+        std::uint32_t size_class = getSizeClass(std::max<size_t>(size, 1));
+        size_t class_size = size_class == g_oversize_class ? size : getSizeClassSize(size_class);
+
+        void* data = nullptr;
+        if(size_class != g_oversize_class)
+        {
+            SizeClass& free_list = m_size_classes[size_class];
+            std::lock_guard<std::mutex> lock(free_list.m_mutex);
+            if(free_list.m_free_buffers.empty() == false)
+            {
+                data = free_list.m_free_buffers.back();
+                free_list.m_free_buffers.pop_back();
+            }
+        }
+        else
+        {
+            m_oversize_count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if(data != nullptr)
+        {
+            m_cached_bytes.fetch_sub(class_size, std::memory_order_relaxed);
+            m_reuse_count.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            data = allocateAligned(class_size);
+            if(data == nullptr)
+            {
+                Core::Logger::error("image buffer pool: allocation of {} bytes failed", class_size);
+                return buffer;
+            }
+        }
+        addPoolBytes(class_size);
+        m_in_use_bytes.fetch_add(size, std::memory_order_relaxed);
+        m_allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+        buffer.m_pool = this;
+        buffer.m_data = data;
+        buffer.m_size = size;
+        buffer.m_size_class = size_class;
+        return buffer;
+    }
+
+    bool ImageBufferPool::reserveCachedBytes(size_t size)
+    {
+        // Charged before the buffer is pushed, so concurrent releases cannot
+        // all pass the budget check and overshoot it together.
+        size_t cached_bytes = m_cached_bytes.load(std::memory_order_relaxed);
+        do
+        {
+            if(cached_bytes + size > m_max_cached_bytes)
+            {
+                return false;
+            }
+        }
+        while(m_cached_bytes.compare_exchange_weak(cached_bytes, cached_bytes + size, std::memory_order_relaxed) == false);
+        return true;
+    }
+
+    void ImageBufferPool::release(void* data, size_t size, std::uint32_t size_class)
+    {
+        size_t class_size = size_class == g_oversize_class ? size : getSizeClassSize(size_class);
+        m_in_use_bytes.fetch_sub(size, std::memory_order_relaxed);
+        m_reserved_bytes.fetch_sub(class_size, std::memory_order_relaxed);
+
+        if(size_class != g_oversize_class && reserveCachedBytes(class_size))
+        {
+            SizeClass& free_list = m_size_classes[size_class];
+            std::lock_guard<std::mutex> lock(free_list.m_mutex);
+            free_list.m_free_buffers.emplace_back(data);
+            return;
+        }
+        freeAligned(data);
+    }
+
+    void ImageBufferPool::trim()
+    {
+        for(std::uint32_t size_class = 0; size_class < g_size_class_count; ++size_class)
+        {
+            std::vector<void*> free_buffers;
+            {
+                std::lock_guard<std::mutex> lock(m_size_classes[size_class].m_mutex);
+                free_buffers.swap(m_size_classes[size_class].m_free_buffers);
+            }
+            for(void* data : free_buffers)
+            {
+                freeAligned(data);
+            }
+            m_cached_bytes.fetch_sub(free_buffers.size() * getSizeClassSize(size_class), std::memory_order_relaxed);
+        }
+    }
+
+    ImageBufferPoolStats ImageBufferPool::getStats() const
+    {
+        ImageBufferPoolStats stats;
+        {
+            stats.m_in_use_bytes = m_in_use_bytes.load(std::memory_order_relaxed);
+            stats.m_reserved_bytes = m_reserved_bytes.load(std::memory_order_relaxed);
+            stats.m_cached_bytes = m_cached_bytes.load(std::memory_order_relaxed);
+            stats.m_high_water_bytes = m_high_water_bytes.load(std::memory_order_relaxed);
+            stats.m_allocation_count = m_allocation_count.load(std::memory_order_relaxed);
+            stats.m_reuse_count = m_reuse_count.load(std::memory_order_relaxed);
+            stats.m_oversize_count = m_oversize_count.load(std::memory_order_relaxed);
+        }
+        if(stats.m_reserved_bytes > 0)
+        {
+            stats.m_internal_fragmentation = 1.0f - (float)stats.m_in_use_bytes / (float)stats.m_reserved_bytes;
+        }
+        if(stats.m_reserved_bytes + stats.m_cached_bytes > 0)
+        {
+            stats.m_external_fragmentation = (float)stats.m_cached_bytes / (float)(stats.m_reserved_bytes + stats.m_cached_bytes);
+        }
+        return stats;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // ScratchArena
+
+    static const size_t g_scratch_first_block_size = 256 * 1024;
+    static std::atomic<size_t> g_scratch_reserved_bytes{0};
+
+    ScratchArena::~ScratchArena()
+    {
+        for(const Block& block : m_blocks)
+        {
+            freeAligned(block.m_data);
+            g_scratch_reserved_bytes.fetch_sub(block.m_size, std::memory_order_relaxed);
+        }
+    }
+
+    void* ScratchArena::allocate(size_t size, size_t alignment)
+    {
+        size = std::max<size_t>(size, 1);
+        while(m_block_index < m_blocks.size())
+        {
+            const Block& block = m_blocks[m_block_index];
+            size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+            if(offset + size <= block.m_size)
+            {
+                m_offset = offset + size;
+                return block.m_data + offset;
+            }
+            // Too small for this request, later blocks are larger.
+            ++m_block_index;
+            m_offset = 0;
+        }
+
+        // Blocks start 64 byte aligned, larger alignments pad inside the block.
+        size_t block_size = std::max(m_blocks.empty() ? g_scratch_first_block_size : m_blocks.back().m_size * 2, size + alignment);
+        Block block;
+        block.m_data = (std::byte*)allocateAligned(block_size);
+        if(block.m_data == nullptr)
+        {
+            Core::Logger::error("scratch arena: allocation of {} bytes failed", block_size);
+            return nullptr;
+        }
+        block.m_size = block_size;
+        m_blocks.emplace_back(block);
+        g_scratch_reserved_bytes.fetch_add(block_size, std::memory_order_relaxed);
+
+        m_block_index = m_blocks.size() - 1;
+        size_t offset = (alignment - ((uintptr_t)block.m_data & (alignment - 1))) & (alignment - 1);
+        m_offset = offset + size;
+        return block.m_data + offset;
+    }
+
+    ScratchArena& ScratchArena::getThreadArena()
+    {
+        thread_local ScratchArena arena;
+        return arena;
+    }
+
+    size_t ScratchArena::getReservedBytesOfAllThreads()
+    {
+        return g_scratch_reserved_bytes.load(std::memory_order_relaxed);
+    }
+
+    ScratchScope::ScratchScope(ScratchArena& arena)
+        : m_arena(arena),
+          m_block_index(arena.m_block_index),
+          m_offset(arena.m_offset)
+    {
+    }
+
+    ScratchScope::~ScratchScope()
+    {
+        m_arena.m_block_index = m_block_index;
+        m_arena.m_offset = m_offset;
+    }
+}
\ No newline at end of file
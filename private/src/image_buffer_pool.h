@@ -0,0 +1,172 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+namespace Arieo
+{
+    class ImageBufferPool;
+
+    // Buffers above the largest size class are allocated and freed directly.
+    inline constexpr size_t g_image_buffer_pool_min_class_size = 256;
+    inline constexpr size_t g_image_buffer_pool_max_class_size = 64ull * 1024 * 1024;
+    inline constexpr size_t g_default_image_buffer_pool_cache = 256ull * 1024 * 1024;
+
+    // Owns one buffer of an ImageBufferPool and gives it back on destruction.
+    class PooledBuffer
+    {
+    public:
+        PooledBuffer() = default;
+        ~PooledBuffer() { reset(); }
+
+        PooledBuffer(PooledBuffer&& other) noexcept;
+        PooledBuffer& operator=(PooledBuffer&& other) noexcept;
+        PooledBuffer(const PooledBuffer&) = delete;
+        PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+        void* getData() const { return m_data; }
+        size_t getSize() const { return m_size; }
+        explicit operator bool() const { return m_data != nullptr; }
+
+        void reset();
+
+    private:
+        friend class ImageBufferPool;
+
+        ImageBufferPool* m_pool = nullptr;
+        void* m_data = nullptr;
+        size_t m_size = 0;
+        std::uint32_t m_size_class = 0;
+    };
+
+    struct ImageBufferPoolStats
+    {
+        // Requested bytes of live buffers.
+        size_t m_in_use_bytes = 0;
+        // Size class bytes of live buffers.
+        size_t m_reserved_bytes = 0;
+        // Free buffers kept for reuse.
+        size_t m_cached_bytes = 0;
+        // Peak of reserved plus cached bytes.
+        size_t m_high_water_bytes = 0;
+
+        std::uint64_t m_allocation_count = 0;
+        std::uint64_t m_reuse_count = 0;
+        std::uint64_t m_oversize_count = 0;
+
+        // Share of reserved bytes lost to size class rounding.
+        float m_internal_fragmentation = 0.0f;
+        // Share of the pool's memory idle in free lists.
+        float m_external_fragmentation = 0.0f;
+    };
+
+    // Size class pool for image memory. Classes grow in quarter steps between
+    // powers of two, so rounding wastes at most 20% of a buffer, and released
+    // buffers stay on a free list per class for the next image of similar
+    // size instead of going back to the heap. Every class has its own lock;
+    // loaders on different threads only meet when they ask for the same size.
+    // The pool has to outlive every buffer it handed out.
+    class ImageBufferPool
+    {
+    public:
+        explicit ImageBufferPool(size_t max_cached_bytes = g_default_image_buffer_pool_cache);
+        ~ImageBufferPool();
+
+        ImageBufferPool(const ImageBufferPool&) = delete;
+        ImageBufferPool& operator=(const ImageBufferPool&) = delete;
+
+        // Returns an empty buffer if the allocation failed. Buffers are 64 byte aligned.
+        PooledBuffer allocate(size_t size);
+
+        // Frees every cached buffer.
+        void trim();
+
+        ImageBufferPoolStats getStats() const;
+
+        static constexpr size_t g_size_class_count = 4 * 18 + 1;
+
+    private:
+        friend class PooledBuffer;
+
+        struct SizeClass
+        {
+            std::mutex m_mutex;
+            std::vector<void*> m_free_buffers;
+        };
+
+        void release(void* data, size_t size, std::uint32_t size_class);
+        void addPoolBytes(size_t size);
+        // Charges size to the cache budget, false if it does not fit.
+        bool reserveCachedBytes(size_t size);
+
+        size_t m_max_cached_bytes;
+        std::array<SizeClass, g_size_class_count> m_size_classes;
+
+        std::atomic<size_t> m_in_use_bytes{0};
+        std::atomic<size_t> m_reserved_bytes{0};
+        std::atomic<size_t> m_cached_bytes{0};
+        std::atomic<size_t> m_high_water_bytes{0};
+        std::atomic<std::uint64_t> m_allocation_count{0};
+        std::atomic<std::uint64_t> m_reuse_count{0};
+        std::atomic<std::uint64_t> m_oversize_count{0};
+    };
+
+    // Bump allocator for transient buffers of one thread, such as the row
+    // buffers of mip filtering. Memory is only given back by rewinding a
+    // ScratchScope, and blocks stay with the thread for the next job.
+    class ScratchArena
+    {
+    public:
+        ScratchArena() = default;
+        ~ScratchArena();
+
+        ScratchArena(const ScratchArena&) = delete;
+        ScratchArena& operator=(const ScratchArena&) = delete;
+
+        void* allocate(size_t size, size_t alignment = 64);
+
+        template<typename T>
+        T* allocateArray(size_t count)
+        {
+            return (T*)allocate(count * sizeof(T), alignof(T) > 64 ? alignof(T) : 64);
+        }
+
+        static ScratchArena& getThreadArena();
+
+        // Bytes every thread arena holds together.
+        static size_t getReservedBytesOfAllThreads();
+
+    private:
+        friend class ScratchScope;
+
+        struct Block
+        {
+            std::byte* m_data = nullptr;
+            size_t m_size = 0;
+        };
+
+        std::vector<Block> m_blocks;
+        size_t m_block_index = 0;
+        size_t m_offset = 0;
+    };
+
+    // Everything allocated from the arena while the scope lives is released with it.
+    class ScratchScope
+    {
+    public:
+        explicit ScratchScope(ScratchArena& arena = ScratchArena::getThreadArena());
+        ~ScratchScope();
+
+        ScratchScope(const ScratchScope&) = delete;
+        ScratchScope& operator=(const ScratchScope&) = delete;
+
+        ScratchArena& getArena() const { return m_arena; }
+
+    private:
+        ScratchArena& m_arena;
+        size_t m_block_index;
+        size_t m_offset;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "image_cache.h"
+
+#include <algorithm>
+
+namespace Arieo
+{
+    ImageCache::ImageCache(size_t byte_budget, size_t shard_count)
+        : m_byte_budget(byte_budget)
+    {
+        m_shards.resize(std::max<size_t>(shard_count, 1));
+        for(std::unique_ptr<Shard>& shard : m_shards)
+        {
+            shard = std::make_unique<Shard>();
+        }
+    }
+
+    size_t ImageCache::getShardIndex(const ImageCacheKey& key) const
+    {
+        // The low bits feed the bucket index of the shard map, pick the shard from the high ones.
+        return (size_t)((key.m_content_hash >> 40) % m_shards.size());
+    }
+
+    ImageHandle ImageCache::find(const ImageCacheKey& key)
+    {
+        Shard& shard = *m_shards[getShardIndex(key)];
+        std::lock_guard<std::mutex> lock(shard.m_mutex);
+        auto found = shard.m_index.find(key);
+        if(found == shard.m_index.end())
+        {
+            m_miss_count.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        shard.m_entries.splice(shard.m_entries.begin(), shard.m_entries, found->second);
+        m_hit_count.fetch_add(1, std::memory_order_relaxed);
+        return found->second->m_image;
+    }
+
+    ImageHandle ImageCache::insert(const ImageCacheKey& key, ImageHandle image)
+    {
+        if(image == nullptr)
+        {
+            return nullptr;
+        }
+
+        size_t shard_index = getShardIndex(key);
+        Shard& shard = *m_shards[shard_index];
+        {
+            std::lock_guard<std::mutex> lock(shard.m_mutex);
+            auto found = shard.m_index.find(key);
+            if(found != shard.m_index.end())
+            {
+                shard.m_entries.splice(shard.m_entries.begin(), shard.m_entries, found->second);
+                return found->second->m_image;
+            }
+
+            size_t size = image->getMemorySize();
+            shard.m_entries.emplace_front(Entry{key, image, size});
+            shard.m_index.emplace(key, shard.m_entries.begin());
+            m_resident_bytes.fetch_add(size, std::memory_order_relaxed);
+            m_entry_count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // The new entry is pinned by image, so it is never its own eviction victim.
+        evict(shard_index, getByteBudget());
+        return image;
+    }
+
+    void ImageCache::evict(size_t first_shard, size_t byte_budget)
+    {
+        // Images are released after the shard lock is dropped, freeing a large
+        // buffer should not stall lookups in the same shard.
+        std::vector<ImageHandle> evicted;
+        for(size_t step = 0; step < m_shards.size(); ++step)
+        {
+            if(m_resident_bytes.load(std::memory_order_relaxed) <= byte_budget)
+            {
+                break;
+            }
+
+            Shard& shard = *m_shards[(first_shard + step) % m_shards.size()];
+            std::lock_guard<std::mutex> lock(shard.m_mutex);
+            auto entry = shard.m_entries.end();
+            while(entry != shard.m_entries.begin() && m_resident_bytes.load(std::memory_order_relaxed) > byte_budget)
+            {
+                --entry;
+                // Handles are only copied out under this lock, a count of one
+                // means the cache holds the last reference and it stays that way.
+                if(entry->m_image.use_count() > 1)
+                {
+                    continue;
+                }
+                m_resident_bytes.fetch_sub(entry->m_size, std::memory_order_relaxed);
+                m_entry_count.fetch_sub(1, std::memory_order_relaxed);
+                m_eviction_count.fetch_add(1, std::memory_order_relaxed);
+                evicted.emplace_back(std::move(entry->m_image));
+                shard.m_index.erase(entry->m_key);
+                entry = shard.m_entries.erase(entry);
+            }
+        }
+    }
+
+    void ImageCache::setByteBudget(size_t byte_budget)
+    {
+        m_byte_budget.store(byte_budget, std::memory_order_relaxed);
+        evict(0, byte_budget);
+    }
+
+    void ImageCache::trim()
+    {
+        evict(0, 0);
+    }
+
+    ImageCacheStats ImageCache::getStats() const
+    {
+        ImageCacheStats stats;
+        {
+            stats.m_hit_count = m_hit_count.load(std::memory_order_relaxed);
+            stats.m_miss_count = m_miss_count.load(std::memory_order_relaxed);
+            stats.m_eviction_count = m_eviction_count.load(std::memory_order_relaxed);
+            stats.m_entry_count = m_entry_count.load(std::memory_order_relaxed);
+            stats.m_resident_bytes = m_resident_bytes.load(std::memory_order_relaxed);
+            stats.m_byte_budget = getByteBudget();
+        }
+        return stats;
+    }
+}
\ No newline at end of file
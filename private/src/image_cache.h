@@ -0,0 +1,107 @@
+#pragma once
+#include "interface/file_loader/image_loader.h"
+#include "loaded_image.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+namespace Arieo
+{
+    inline constexpr size_t g_default_image_cache_budget = 256ull * 1024 * 1024;
+    inline constexpr size_t g_default_image_cache_shard_count = 16;
+
+    // Identifies one decoded result: what went in and what was asked of it.
+    struct ImageCacheKey
+    {
+        std::uint64_t m_content_hash = 0;
+        size_t m_content_size = 0;
+        std::uint64_t m_options_hash = 0;
+
+        bool operator==(const ImageCacheKey& other) const
+        {
+            return m_content_hash == other.m_content_hash
+                && m_content_size == other.m_content_size
+                && m_options_hash == other.m_options_hash;
+        }
+    };
+
+    struct ImageCacheStats
+    {
+        std::uint64_t m_hit_count = 0;
+        std::uint64_t m_miss_count = 0;
+        std::uint64_t m_eviction_count = 0;
+        size_t m_entry_count = 0;
+        size_t m_resident_bytes = 0;
+        size_t m_byte_budget = 0;
+    };
+
+    // Least recently used cache of decoded images under a byte budget. Keys are
+    // spread over shards with a mutex each, so concurrent loaders only contend
+    // when their keys land in the same shard. Recency is tracked per shard and
+    // eviction walks the shards one at a time, which makes the global order an
+    // approximation of LRU; the budget itself is enforced across all shards.
+    // Entries with a live handle are never evicted, so the resident size may
+    // exceed the budget while callers hold on to more than it allows.
+    class ImageCache
+    {
+    public:
+        explicit ImageCache(size_t byte_budget = g_default_image_cache_budget, size_t shard_count = g_default_image_cache_shard_count);
+
+        ImageCache(const ImageCache&) = delete;
+        ImageCache& operator=(const ImageCache&) = delete;
+
+        // Returns nullptr on a miss.
+        ImageHandle find(const ImageCacheKey& key);
+
+        // Keeps the first image inserted for a key: if another thread got there
+        // first the resident entry is returned and image is dropped.
+        ImageHandle insert(const ImageCacheKey& key, ImageHandle image);
+
+        // Shrinking the budget evicts right away.
+        void setByteBudget(size_t byte_budget);
+        size_t getByteBudget() const { return m_byte_budget.load(std::memory_order_relaxed); }
+
+        // Drops every entry that has no live handle.
+        void trim();
+
+        ImageCacheStats getStats() const;
+
+    private:
+        struct KeyHasher
+        {
+            size_t operator()(const ImageCacheKey& key) const { return (size_t)(key.m_content_hash ^ key.m_options_hash); }
+        };
+
+        struct Entry
+        {
+            ImageCacheKey m_key;
+            ImageHandle m_image;
+            size_t m_size = 0;
+        };
+
+        // Front is the most recently used entry.
+        struct Shard
+        {
+            std::mutex m_mutex;
+            std::list<Entry> m_entries;
+            std::unordered_map<ImageCacheKey, std::list<Entry>::iterator, KeyHasher> m_index;
+        };
+
+        size_t getShardIndex(const ImageCacheKey& key) const;
+
+        // Evicts from first_shard onwards until the resident size fits byte_budget.
+        void evict(size_t first_shard, size_t byte_budget);
+
+        std::vector<std::unique_ptr<Shard>> m_shards;
+        std::atomic<size_t> m_byte_budget;
+        std::atomic<size_t> m_resident_bytes{0};
+        std::atomic<size_t> m_entry_count{0};
+        std::atomic<std::uint64_t> m_hit_count{0};
+        std::atomic<std::uint64_t> m_miss_count{0};
+        std::atomic<std::uint64_t> m_eviction_count{0};
+    };
+}
\ No newline at end of file
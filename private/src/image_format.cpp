@@ -0,0 +1,99 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "image_format.h"
+
+namespace Arieo
+{
+    ImageFormatInfo getImageFormatInfo(Interface::RHI::Format format)
+    {
+        switch(format)
+        {
+        case Interface::RHI::Format::R8_UNORM:
+        case Interface::RHI::Format::R8_SNORM:
+        case Interface::RHI::Format::R8_UINT:
+        case Interface::RHI::Format::R8_SINT:
+            return {1, 1, 1};
+
+        case Interface::RHI::Format::R8G8_UNORM:
+        case Interface::RHI::Format::R8G8_SNORM:
+        case Interface::RHI::Format::R8G8_UINT:
+        case Interface::RHI::Format::R8G8_SINT:
+        case Interface::RHI::Format::R16_UNORM:
+        case Interface::RHI::Format::R16_SNORM:
+        case Interface::RHI::Format::R16_UINT:
+        case Interface::RHI::Format::R16_SINT:
+        case Interface::RHI::Format::R16_SFLOAT:
+        case Interface::RHI::Format::D16_UNORM:
+        case Interface::RHI::Format::B5G6R5_UNORM_PACK16:
+        case Interface::RHI::Format::B5G5R5A1_UNORM_PACK16:
+        case Interface::RHI::Format::B4G4R4A4_UNORM_PACK16:
+            return {1, 1, 2};
+
+        case Interface::RHI::Format::R8G8B8A8_UNORM:
+        case Interface::RHI::Format::R8G8B8A8_SNORM:
+        case Interface::RHI::Format::R8G8B8A8_UINT:
+        case Interface::RHI::Format::R8G8B8A8_SINT:
+        case Interface::RHI::Format::B8G8R8A8_UNORM:
+        case Interface::RHI::Format::B8G8R8A8_UINT:
+        case Interface::RHI::Format::B8G8R8A8_SRGB:
+        case Interface::RHI::Format::R16G16_UNORM:
+        case Interface::RHI::Format::R16G16_SNORM:
+        case Interface::RHI::Format::R16G16_UINT:
+        case Interface::RHI::Format::R16G16_SINT:
+        case Interface::RHI::Format::R16G16_SFLOAT:
+        case Interface::RHI::Format::R32_UINT:
+        case Interface::RHI::Format::R32_SINT:
+        case Interface::RHI::Format::R32_SFLOAT:
+        case Interface::RHI::Format::D32_SFLOAT:
+        case Interface::RHI::Format::D24_UNORM_S8_UINT:
+            return {1, 1, 4};
+
+        case Interface::RHI::Format::R16G16B16A16_UNORM:
+        case Interface::RHI::Format::R16G16B16A16_SNORM:
+        case Interface::RHI::Format::R16G16B16A16_UINT:
+        case Interface::RHI::Format::R16G16B16A16_SINT:
+        case Interface::RHI::Format::R16G16B16A16_SFLOAT:
+        case Interface::RHI::Format::R32G32_UINT:
+        case Interface::RHI::Format::R32G32_SINT:
+        case Interface::RHI::Format::R32G32_SFLOAT:
+            return {1, 1, 8};
+
+        case Interface::RHI::Format::R32G32B32_UINT:
+        case Interface::RHI::Format::R32G32B32_SINT:
+        case Interface::RHI::Format::R32G32B32_SFLOAT:
+            return {1, 1, 12};
+
+        case Interface::RHI::Format::R32G32B32A32_UINT:
+        case Interface::RHI::Format::R32G32B32A32_SINT:
+        case Interface::RHI::Format::R32G32B32A32_SFLOAT:
+            return {1, 1, 16};
+
+        case Interface::RHI::Format::BC1_RGB_UNORM_BLOCK:
+        case Interface::RHI::Format::BC1_RGB_SRGB_BLOCK:
+        case Interface::RHI::Format::BC4_UNORM_BLOCK:
+        case Interface::RHI::Format::BC4_SNORM_BLOCK:
+            return {4, 4, 8};
+
+        case Interface::RHI::Format::BC2_UNORM_BLOCK:
+        case Interface::RHI::Format::BC2_SRGB_BLOCK:
+        case Interface::RHI::Format::BC3_UNORM_BLOCK:
+        case Interface::RHI::Format::BC3_SRGB_BLOCK:
+        case Interface::RHI::Format::BC5_UNORM_BLOCK:
+        case Interface::RHI::Format::BC5_SNORM_BLOCK:
+        case Interface::RHI::Format::BC6H_UFLOAT_BLOCK:
+        case Interface::RHI::Format::BC6H_SFLOAT_BLOCK:
+        case Interface::RHI::Format::BC7_UNORM_BLOCK:
+        case Interface::RHI::Format::BC7_SRGB_BLOCK:
+            return {4, 4, 16};
+
+        default:
+            return {1, 1, 0};
+        }
+    }
+
+    bool isBlockCompressedFormat(Interface::RHI::Format format)
+    {
+        return getImageFormatInfo(format).m_block_width > 1;
+    }
+}
\ No newline at end of file
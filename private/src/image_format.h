@@ -0,0 +1,18 @@
+#pragma once
+#include "interface/file_loader/image_loader.h"
+#include <cstdint>
+namespace Arieo
+{
+    // Texel storage description of an RHI format. Uncompressed formats are
+    // described as 1x1 blocks so that pitch math is the same for every format.
+    struct ImageFormatInfo
+    {
+        std::uint32_t m_block_width = 1;
+        std::uint32_t m_block_height = 1;
+        std::uint32_t m_bytes_per_block = 0;
+    };
+
+    ImageFormatInfo getImageFormatInfo(Interface::RHI::Format format);
+
+    bool isBlockCompressedFormat(Interface::RHI::Format format);
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "image_hash.h"
+
+#include <cstring>
+
+namespace Arieo
+{
+    static const std::uint64_t g_hash_prime_1 = 0x9E3779B185EBCA87ull;
+    static const std::uint64_t g_hash_prime_2 = 0xC2B2AE3D27D4EB4Full;
+    static const std::uint64_t g_hash_prime_3 = 0x165667B19E3779F9ull;
+    static const std::uint64_t g_hash_prime_4 = 0x85EBCA77C2B2AE63ull;
+    static const std::uint64_t g_hash_prime_5 = 0x27D4EB2F165667C5ull;
+
+    static inline std::uint64_t rotateLeft(std::uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    static inline std::uint64_t read64(const std::uint8_t* data)
+    {
+        std::uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    static inline std::uint32_t read32(const std::uint8_t* data)
+    {
+        std::uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    static inline std::uint64_t hashRound(std::uint64_t accumulator, std::uint64_t input)
+    {
+        accumulator += input * g_hash_prime_2;
+        accumulator = rotateLeft(accumulator, 31);
+        return accumulator * g_hash_prime_1;
+    }
+
+    static inline std::uint64_t mergeRound(std::uint64_t accumulator, std::uint64_t lane)
+    {
+        accumulator ^= hashRound(0, lane);
+        return accumulator * g_hash_prime_1 + g_hash_prime_4;
+    }
+
+    static inline std::uint64_t avalanche(std::uint64_t hash)
+    {
+        hash ^= hash >> 33;
+        hash *= g_hash_prime_2;
+        hash ^= hash >> 29;
+        hash *= g_hash_prime_3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    std::uint64_t hashImageData(const void* data, size_t size, std::uint64_t seed)
+    {
+        const std::uint8_t* bytes = (const std::uint8_t*)data;
+        const std::uint8_t* end = bytes + size;
+        std::uint64_t hash;
+
+        if(size >= 32)
+        {
+            std::uint64_t lanes[4] =
+            {
+                seed + g_hash_prime_1 + g_hash_prime_2,
+                seed + g_hash_prime_2,
+                seed,
+                seed - g_hash_prime_1,
+            };
+            // The lanes do not depend on each other, the loop is limited by loads only.
+            for(; bytes + 32 <= end; bytes += 32)
+            {
+                lanes[0] = hashRound(lanes[0], read64(bytes));
+                lanes[1] = hashRound(lanes[1], read64(bytes + 8));
+                lanes[2] = hashRound(lanes[2], read64(bytes + 16));
+                lanes[3] = hashRound(lanes[3], read64(bytes + 24));
+            }
+            hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+            for(std::uint64_t lane : lanes)
+            {
+                hash = mergeRound(hash, lane);
+            }
+        }
+        else
+        {
+            hash = seed + g_hash_prime_5;
+        }
+
+        hash += (std::uint64_t)size;
+        for(; bytes + 8 <= end; bytes += 8)
+        {
+            hash ^= hashRound(0, read64(bytes));
+            hash = rotateLeft(hash, 27) * g_hash_prime_1 + g_hash_prime_4;
+        }
+        if(bytes + 4 <= end)
+        {
+            hash ^= (std::uint64_t)read32(bytes) * g_hash_prime_1;
+            hash = rotateLeft(hash, 23) * g_hash_prime_2 + g_hash_prime_3;
+            bytes += 4;
+        }
+        for(; bytes < end; ++bytes)
+        {
+            hash ^= (*bytes) * g_hash_prime_5;
+            hash = rotateLeft(hash, 11) * g_hash_prime_1;
+        }
+        return avalanche(hash);
+    }
+
+    std::uint64_t combineImageHash(std::uint64_t seed, std::uint64_t value)
+    {
+        return avalanche(seed ^ hashRound(g_hash_prime_5, value));
+    }
+}
\ No newline at end of file
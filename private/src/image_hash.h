@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+namespace Arieo
+{
+    // Non cryptographic 64 bit hash with the xxHash64 structure: four
+    // independent lanes over 32 byte stripes, so it runs at memory bandwidth
+    // on texture sized inputs. Only used to key in-process caches, the values
+    // are not stable across versions of the module.
+    std::uint64_t hashImageData(const void* data, size_t size, std::uint64_t seed = 0);
+
+    // Folds value into seed, for hashing small option structs field by field.
+    std::uint64_t combineImageHash(std::uint64_t seed, std::uint64_t value);
+}
\ No newline at end of file
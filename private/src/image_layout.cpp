@@ -0,0 +1,135 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "image_layout.h"
+#include "image_format.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace Arieo
+{
+    static bool multiplySize(size_t lhs, size_t rhs, size_t& result)
+    {
+        if(lhs != 0 && rhs > SIZE_MAX / lhs)
+        {
+            return false;
+        }
+        result = lhs * rhs;
+        return true;
+    }
+
+    size_t buildImageLayout(
+        ImageLayout& layout,
+        Interface::RHI::Format format,
+        ImageDimension dimension,
+        std::uint32_t width,
+        std::uint32_t height,
+        std::uint32_t depth,
+        std::uint32_t mip_map_count,
+        std::uint32_t array_size)
+    {
+        return buildImageLayout(layout, getImageFormatInfo(format), dimension, width, height, depth, mip_map_count, array_size);
+    }
+
+    size_t buildImageLayout(
+        ImageLayout& layout,
+        const ImageFormatInfo& format_info,
+        ImageDimension dimension,
+        std::uint32_t width,
+        std::uint32_t height,
+        std::uint32_t depth,
+        std::uint32_t mip_map_count,
+        std::uint32_t array_size)
+    {
+        layout.m_dimension = dimension;
+        layout.m_array_size = 0;
+        layout.m_mip_map_count = 0;
+        layout.m_subresources.clear();
+
+        if(format_info.m_bytes_per_block == 0)
+        {
+            return 0;
+        }
+        if(isImageExtentSupported(width, height, depth, mip_map_count, array_size) == false)
+        {
+            Core::Logger::error("image layout failed: {}x{}x{} with {} mips and {} layers is out of range", width, height, depth, mip_map_count, array_size);
+            return 0;
+        }
+        layout.m_array_size = std::max<std::uint32_t>(array_size, 1);
+        layout.m_mip_map_count = std::max<std::uint32_t>(mip_map_count, 1);
+
+        layout.m_subresources.reserve(size_t(layout.m_array_size) * layout.m_mip_map_count);
+
+        size_t offset = 0;
+        for(std::uint32_t array_layer = 0; array_layer < layout.m_array_size; ++array_layer)
+        {
+            std::uint32_t mip_width = std::max<std::uint32_t>(width, 1);
+            std::uint32_t mip_height = std::max<std::uint32_t>(height, 1);
+            std::uint32_t mip_depth = std::max<std::uint32_t>(depth, 1);
+            for(std::uint32_t mip_level = 0; mip_level < layout.m_mip_map_count; ++mip_level)
+            {
+                size_t blocks_x = (size_t(mip_width) + format_info.m_block_width - 1) / format_info.m_block_width;
+                size_t blocks_y = (size_t(mip_height) + format_info.m_block_height - 1) / format_info.m_block_height;
+
+                ImageSubresource subresource{};
+                {
+                    subresource.m_mip_level = mip_level;
+                    subresource.m_array_layer = array_layer;
+                    subresource.m_width = mip_width;
+                    subresource.m_height = mip_height;
+                    subresource.m_depth = mip_depth;
+                    subresource.m_offset = offset;
+                }
+                // Only reachable with a 32 bit size_t under the extent limits.
+                if(multiplySize(blocks_x, format_info.m_bytes_per_block, subresource.m_row_pitch) == false
+                    || multiplySize(subresource.m_row_pitch, blocks_y, subresource.m_slice_pitch) == false
+                    || multiplySize(subresource.m_slice_pitch, mip_depth, subresource.m_size) == false
+                    || subresource.m_size > SIZE_MAX - offset)
+                {
+                    Core::Logger::error("image layout failed: size of {}x{}x{} with {} mips and {} layers overflows", width, height, depth, mip_map_count, array_size);
+                    layout.m_array_size = 0;
+                    layout.m_mip_map_count = 0;
+                    layout.m_subresources.clear();
+                    return 0;
+                }
+                layout.m_subresources.emplace_back(subresource);
+                offset += subresource.m_size;
+
+                mip_width = std::max<std::uint32_t>(mip_width >> 1, 1);
+                mip_height = std::max<std::uint32_t>(mip_height >> 1, 1);
+                mip_depth = std::max<std::uint32_t>(mip_depth >> 1, 1);
+            }
+        }
+        return offset;
+    }
+
+    std::uint32_t computeFullMipMapCount(std::uint32_t width, std::uint32_t height, std::uint32_t depth)
+    {
+        std::uint32_t largest = std::max({width, height, depth, 1u});
+        std::uint32_t count = 1;
+        while(largest > 1)
+        {
+            largest >>= 1;
+            ++count;
+        }
+        return count;
+    }
+
+    bool isImageExtentSupported(
+        std::uint32_t width,
+        std::uint32_t height,
+        std::uint32_t depth,
+        std::uint32_t mip_map_count,
+        std::uint32_t array_size)
+    {
+        width = std::max<std::uint32_t>(width, 1);
+        height = std::max<std::uint32_t>(height, 1);
+        depth = std::max<std::uint32_t>(depth, 1);
+        return width <= g_max_image_extent
+            && height <= g_max_image_extent
+            && depth <= g_max_image_extent
+            && std::max<std::uint32_t>(array_size, 1) <= g_max_image_array_size
+            && std::max<std::uint32_t>(mip_map_count, 1) <= computeFullMipMapCount(width, height, depth);
+    }
+}
\ No newline at end of file
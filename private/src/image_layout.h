@@ -0,0 +1,101 @@
+#pragma once
+#include "interface/file_loader/image_loader.h"
+#include "image_format.h"
+#include <cstdint>
+#include <vector>
+namespace Arieo
+{
+    // Largest extent per axis and layer count an image may have. Headers are
+    // checked against them, which keeps every layout size far from overflowing.
+    inline constexpr std::uint32_t g_max_image_extent = 16384;
+    inline constexpr std::uint32_t g_max_image_array_size = 2048;
+
+    enum class ImageDimension : std::uint32_t
+    {
+        TEXTURE_1D,
+        TEXTURE_2D,
+        TEXTURE_3D,
+        TEXTURE_CUBE
+    };
+
+    // One copyable region of an image. Offsets are relative to
+    // ImageBuffer::m_buffer, pitches are in bytes and extents in texels.
+    struct ImageSubresource
+    {
+        std::uint32_t m_mip_level = 0;
+        std::uint32_t m_array_layer = 0;
+
+        std::uint32_t m_width = 1;
+        std::uint32_t m_height = 1;
+        std::uint32_t m_depth = 1;
+
+        size_t m_offset = 0;
+        size_t m_size = 0;
+        size_t m_row_pitch = 0;
+        size_t m_slice_pitch = 0;
+    };
+
+    // Subresources are stored layer-major (every mip of layer 0, then every
+    // mip of layer 1, ...), which is the order DDS files use on disk. Cube
+    // maps report six layers per cube in +X, -X, +Y, -Y, +Z, -Z order.
+    struct ImageLayout
+    {
+        ImageDimension m_dimension = ImageDimension::TEXTURE_2D;
+        std::uint32_t m_array_size = 1;
+        std::uint32_t m_mip_map_count = 1;
+        std::vector<ImageSubresource> m_subresources;
+
+        const ImageSubresource* getSubresource(std::uint32_t mip_level, std::uint32_t array_layer) const
+        {
+            if(mip_level >= m_mip_map_count || array_layer >= m_array_size)
+            {
+                return nullptr;
+            }
+            size_t index = size_t(array_layer) * m_mip_map_count + mip_level;
+            if(index >= m_subresources.size())
+            {
+                return nullptr;
+            }
+            return &m_subresources[index];
+        }
+    };
+
+    // Fills the layout for a tightly packed image starting at offset 0 and
+    // returns its total size in bytes. Returns 0 with an empty layout, no mips
+    // and no layers, if the format is not sizeable or the extent is rejected
+    // by isImageExtentSupported.
+    size_t buildImageLayout(
+        ImageLayout& layout,
+        Interface::RHI::Format format,
+        ImageDimension dimension,
+        std::uint32_t width,
+        std::uint32_t height,
+        std::uint32_t depth,
+        std::uint32_t mip_map_count,
+        std::uint32_t array_size
+    );
+
+    // Same for texel layouts without an RHI format, such as 24 bit RGB.
+    size_t buildImageLayout(
+        ImageLayout& layout,
+        const ImageFormatInfo& format_info,
+        ImageDimension dimension,
+        std::uint32_t width,
+        std::uint32_t height,
+        std::uint32_t depth,
+        std::uint32_t mip_map_count,
+        std::uint32_t array_size
+    );
+
+    std::uint32_t computeFullMipMapCount(std::uint32_t width, std::uint32_t height, std::uint32_t depth);
+
+    // Extents and layer count within the limits above and no more mips than
+    // the full chain of the extent has; zeros count as 1.
+    bool isImageExtentSupported(
+        std::uint32_t width,
+        std::uint32_t height,
+        std::uint32_t depth,
+        std::uint32_t mip_map_count,
+        std::uint32_t array_size
+    );
+}
\ No newline at end of file
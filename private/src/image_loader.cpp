@@ -0,0 +1,579 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "image_loader.h"
+#include "bc_decoder.h"
+#include "bc_encoder.h"
+#include "dds_format.h"
+#include "image_format.h"
+#include "image_hash.h"
+#include "ktx2_format.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace Arieo
+{
+    static const std::uint32_t g_dds_file_magic_number = 0x20534444;
+
+    // Block rows per parallel work item of BC decoding and encoding, 64 texel
+    // rows per band; mip generation uses bands of as many texel rows.
+    static const std::uint32_t g_block_band_rows = 16;
+
+    static bool isDDSFile(const ImageSource& source)
+    {
+        return source.m_size >= sizeof(g_dds_file_magic_number)
+            && *(const std::uint32_t*)source.m_buffer == g_dds_file_magic_number;
+    }
+
+    // One parallel work item of BC decoding or encoding.
+    struct BlockBand
+    {
+        size_t m_subresource_index;
+        std::uint32_t m_slice;
+        std::uint32_t m_first_block_row;
+        std::uint32_t m_block_row_count;
+    };
+
+    static std::vector<BlockBand> buildBlockBands(const ImageLayout& layout)
+    {
+        std::vector<BlockBand> bands;
+        for(size_t subresource_index = 0; subresource_index < layout.m_subresources.size(); ++subresource_index)
+        {
+            const ImageSubresource& subresource = layout.m_subresources[subresource_index];
+            std::uint32_t block_row_count = (subresource.m_height + 3) / 4;
+            for(std::uint32_t slice = 0; slice < subresource.m_depth; ++slice)
+            {
+                for(std::uint32_t block_row = 0; block_row < block_row_count; block_row += g_block_band_rows)
+                {
+                    bands.emplace_back(BlockBand{
+                        subresource_index,
+                        slice,
+                        block_row,
+                        std::min(g_block_band_rows, block_row_count - block_row)
+                    });
+                }
+            }
+        }
+        return bands;
+    }
+
+    // Options that do not change the result, such as the mip filter without
+    // mip generation, are left out so they do not split cache entries.
+    static std::uint64_t hashImageLoadOptions(const ImageLoadOptions& options)
+    {
+        std::uint64_t hash = combineImageHash(0, options.m_decode_block_compressed);
+        hash = combineImageHash(hash, options.m_generate_mip_maps);
+        if(options.m_generate_mip_maps)
+        {
+            hash = combineImageHash(hash, (std::uint64_t)options.m_mip_generation.m_filter);
+            hash = combineImageHash(hash, options.m_mip_generation.m_linearize_srgb);
+            hash = combineImageHash(hash, options.m_mip_generation.m_premultiply_alpha);
+        }
+        hash = combineImageHash(hash, (std::uint64_t)options.m_encode_format);
+        if(options.m_encode_format != Interface::RHI::Format::UNKNOWN)
+        {
+            hash = combineImageHash(hash, (std::uint64_t)options.m_encode_quality);
+        }
+        return hash;
+    }
+
+    ImageLoader::ImageLoader(TaskPool& task_pool, size_t cache_byte_budget)
+        : m_task_pool(task_pool),
+          m_image_cache(cache_byte_budget)
+    {
+    }
+
+    ImageHandle ImageLoader::loadPooled(const void* buffer, size_t size, const ImageLoadOptions& options, const CancellationToken& cancellation)
+    {
+        logMetricsIfDue();
+        if(buffer == nullptr || size == 0)
+        {
+            Core::Logger::error("pooled image load failed: empty buffer");
+            return nullptr;
+        }
+        if(cancellation.isCancelled())
+        {
+            return nullptr;
+        }
+
+        // Every stage reads storage and allocates its result into next_storage,
+        // which then replaces storage as the input of the following stage.
+        PooledBuffer storage;
+        PooledBuffer next_storage;
+        ImageAllocator allocator = [this, &next_storage](size_t allocation_size) -> void*
+        {
+            next_storage = m_buffer_pool.allocate(allocation_size);
+            return next_storage.getData();
+        };
+
+        ImageLayout layout;
+        Interface::FileLoader::ImageBuffer image_buffer{};
+        if(isDDSFile(ImageSource{buffer, size}))
+        {
+            image_buffer = loadDDS(buffer, size, allocator, layout);
+        }
+        else if(isKTX2File(buffer, size))
+        {
+            image_buffer = loadKTX2(buffer, size, allocator, layout);
+        }
+        else
+        {
+            image_buffer = loadImage(buffer, size, allocator);
+            if(image_buffer.m_buffer != nullptr)
+            {
+                buildImageLayout(layout, image_buffer.m_format, ImageDimension::TEXTURE_2D, image_buffer.m_width, image_buffer.m_height, 1, 1, 1);
+            }
+        }
+        if(image_buffer.m_buffer == nullptr)
+        {
+            return nullptr;
+        }
+        storage = std::move(next_storage);
+
+        // Mip generation and encoding check the token per band, the stages in
+        // between only get checked here.
+        if(cancellation.isCancelled())
+        {
+            return nullptr;
+        }
+
+        if(options.m_decode_block_compressed && isBlockCompressedFormat(image_buffer.m_format))
+        {
+            ImageLayout decoded_layout;
+            image_buffer = decodeBlockCompressed(image_buffer, layout, allocator, decoded_layout);
+            if(image_buffer.m_buffer == nullptr)
+            {
+                return nullptr;
+            }
+            storage = std::move(next_storage);
+            layout = std::move(decoded_layout);
+            if(cancellation.isCancelled())
+            {
+                return nullptr;
+            }
+        }
+
+        if(options.m_generate_mip_maps)
+        {
+            ImageLayout mip_layout;
+            image_buffer = generateMipMaps(image_buffer, layout, options.m_mip_generation, allocator, mip_layout, cancellation);
+            if(image_buffer.m_buffer == nullptr)
+            {
+                return nullptr;
+            }
+            // Images that already have mips come back unchanged without allocating.
+            if(next_storage)
+            {
+                storage = std::move(next_storage);
+            }
+            layout = std::move(mip_layout);
+        }
+
+        if(options.m_encode_format != Interface::RHI::Format::UNKNOWN && options.m_encode_format != image_buffer.m_format)
+        {
+            ImageLayout encoded_layout;
+            image_buffer = encodeBlockCompressed(image_buffer, layout, options.m_encode_format, options.m_encode_quality, allocator, encoded_layout, cancellation);
+            if(image_buffer.m_buffer == nullptr)
+            {
+                return nullptr;
+            }
+            storage = std::move(next_storage);
+            layout = std::move(encoded_layout);
+        }
+
+        return std::make_shared<const LoadedImage>(std::move(storage), image_buffer, std::move(layout));
+    }
+
+    ImageHandle ImageLoader::loadCached(const void* buffer, size_t size, const ImageLoadOptions& options, const CancellationToken& cancellation)
+    {
+        logMetricsIfDue();
+        if(buffer == nullptr || size == 0)
+        {
+            Core::Logger::error("cached image load failed: empty buffer");
+            return nullptr;
+        }
+
+        ImageCacheKey key{hashImageData(buffer, size), size, hashImageLoadOptions(options)};
+        ImageHandle cached_image = m_image_cache.find(key);
+        if(cached_image != nullptr)
+        {
+            return cached_image;
+        }
+
+        ImageHandle loaded_image = loadPooled(buffer, size, options, cancellation);
+        if(loaded_image == nullptr)
+        {
+            return nullptr;
+        }
+        // Two threads missing the same key both get here; the first insert wins
+        // and the other result is dropped in favour of it.
+        return m_image_cache.insert(key, std::move(loaded_image));
+    }
+
+    std::vector<Interface::FileLoader::ImageBuffer> ImageLoader::loadBatch(
+        const std::vector<ImageSource>& sources,
+        const ImageAllocator& allocator,
+        std::vector<ImageLayout>& layouts)
+    {
+        logMetricsIfDue();
+        std::vector<Interface::FileLoader::ImageBuffer> image_buffers(sources.size());
+        layouts.assign(sources.size(), ImageLayout{});
+
+        // Largest first, so a big texture never starts last and holds up the batch tail.
+        std::vector<size_t> order(sources.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&sources](size_t lhs, size_t rhs)
+        {
+            return sources[lhs].m_size > sources[rhs].m_size;
+        });
+
+        TaskGroup task_group(m_task_pool);
+        for(size_t index : order)
+        {
+            task_group.run([this, index, &sources, &allocator, &image_buffers, &layouts]()
+            {
+                const ImageSource& source = sources[index];
+                if(source.m_buffer == nullptr || source.m_size == 0)
+                {
+                    return;
+                }
+
+                if(isDDSFile(source))
+                {
+                    DDSImageDesc desc;
+                    if(parseDDSHeader(source.m_buffer, source.m_size, desc)
+                        && (desc.m_conversion != DDSConversion::NONE || desc.m_supercompression != Supercompression::NONE))
+                    {
+                        image_buffers[index] = loadDDS(source.m_buffer, source.m_size, allocator, layouts[index]);
+                        return;
+                    }
+                    image_buffers[index] = loadDDS(const_cast<void*>(source.m_buffer), source.m_size, layouts[index]);
+                    return;
+                }
+
+                if(isKTX2File(source.m_buffer, source.m_size))
+                {
+                    image_buffers[index] = loadKTX2(source.m_buffer, source.m_size, allocator, layouts[index]);
+                    return;
+                }
+
+                Interface::FileLoader::ImageBuffer image_buffer = loadImage(source.m_buffer, source.m_size, allocator);
+                if(image_buffer.m_buffer != nullptr)
+                {
+                    buildImageLayout(
+                        layouts[index],
+                        image_buffer.m_format,
+                        ImageDimension::TEXTURE_2D,
+                        image_buffer.m_width,
+                        image_buffer.m_height,
+                        1,
+                        1,
+                        1
+                    );
+                }
+                image_buffers[index] = image_buffer;
+            });
+        }
+        task_group.wait();
+
+        return image_buffers;
+    }
+
+    Interface::FileLoader::ImageBuffer ImageLoader::decodeBlockCompressed(
+        const Interface::FileLoader::ImageBuffer& image_buffer,
+        const ImageLayout& layout,
+        const ImageAllocator& allocator,
+        ImageLayout& decoded_layout)
+    {
+        Interface::RHI::Format decoded_format = getBCDecodedFormat(image_buffer.m_format);
+        if(decoded_format == Interface::RHI::Format::UNKNOWN || layout.m_subresources.empty())
+        {
+            Core::Logger::error("bc decode failed: not a block compressed image");
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        const ImageSubresource& top_level = layout.m_subresources.front();
+        size_t decoded_size = buildImageLayout(
+            decoded_layout,
+            decoded_format,
+            layout.m_dimension,
+            top_level.m_width,
+            top_level.m_height,
+            top_level.m_depth,
+            layout.m_mip_map_count,
+            layout.m_array_size
+        );
+        if(decoded_size == 0)
+        {
+            // Extents past the layout limits or a size that overflowed.
+            Core::Logger::error("bc decode failed: no layout for the decoded image");
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        void* destination = nullptr;
+        {
+            ImageStageTimer timer(ImageLoadStage::ALLOCATE);
+            destination = allocator(decoded_size);
+        }
+        if(destination == nullptr)
+        {
+            Core::Logger::error("bc decode failed: allocator returned null for {} bytes", decoded_size);
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        ImageStageTimer timer(ImageLoadStage::BC_DECODE);
+
+        std::vector<BlockBand> bands = buildBlockBands(layout);
+        SimdLevel simd_level = getSimdLevel();
+        m_task_pool.parallelFor(bands.size(), 1, [&](size_t begin, size_t end)
+        {
+            for(size_t band_index = begin; band_index < end; ++band_index)
+            {
+                const BlockBand& band = bands[band_index];
+                const ImageSubresource& source = layout.m_subresources[band.m_subresource_index];
+                const ImageSubresource& target = decoded_layout.m_subresources[band.m_subresource_index];
+                decodeBCBlockRows(
+                    image_buffer.m_format,
+                    simd_level,
+                    (const std::byte*)image_buffer.m_buffer + source.m_offset + band.m_slice * source.m_slice_pitch,
+                    source.m_row_pitch,
+                    (std::byte*)destination + target.m_offset + band.m_slice * target.m_slice_pitch,
+                    target.m_row_pitch,
+                    source.m_width,
+                    source.m_height,
+                    band.m_first_block_row,
+                    band.m_block_row_count
+                );
+            }
+        });
+
+        Interface::FileLoader::ImageBuffer decoded_buffer = image_buffer;
+        {
+            decoded_buffer.m_buffer = destination;
+            decoded_buffer.m_size = decoded_size;
+            decoded_buffer.m_format = decoded_format;
+            decoded_buffer.m_mip_map_count = decoded_layout.m_mip_map_count;
+        }
+        return decoded_buffer;
+    }
+
+    Interface::FileLoader::ImageBuffer ImageLoader::encodeBlockCompressed(
+        const Interface::FileLoader::ImageBuffer& image_buffer,
+        const ImageLayout& layout,
+        Interface::RHI::Format target_format,
+        BCEncodeQuality quality,
+        const ImageAllocator& allocator,
+        ImageLayout& encoded_layout,
+        const CancellationToken& cancellation)
+    {
+        if(isBCEncodeSource(image_buffer.m_format) == false || isBCEncodeTarget(target_format) == false || layout.m_subresources.empty())
+        {
+            Core::Logger::error("bc encode failed: unsupported source or target format");
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        const ImageSubresource& top_level = layout.m_subresources.front();
+        size_t encoded_size = buildImageLayout(
+            encoded_layout,
+            target_format,
+            layout.m_dimension,
+            top_level.m_width,
+            top_level.m_height,
+            top_level.m_depth,
+            layout.m_mip_map_count,
+            layout.m_array_size
+        );
+        if(encoded_size == 0)
+        {
+            // Extents past the layout limits or a size that overflowed.
+            Core::Logger::error("bc encode failed: no layout for the encoded image");
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        void* destination = nullptr;
+        {
+            ImageStageTimer timer(ImageLoadStage::ALLOCATE);
+            destination = allocator(encoded_size);
+        }
+        if(destination == nullptr)
+        {
+            Core::Logger::error("bc encode failed: allocator returned null for {} bytes", encoded_size);
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        ImageStageTimer timer(ImageLoadStage::BC_ENCODE);
+
+        std::vector<BlockBand> bands = buildBlockBands(layout);
+        SimdLevel simd_level = getSimdLevel();
+        m_task_pool.parallelFor(bands.size(), 1, [&](size_t begin, size_t end)
+        {
+            for(size_t band_index = begin; band_index < end && cancellation.isCancelled() == false; ++band_index)
+            {
+                const BlockBand& band = bands[band_index];
+                const ImageSubresource& source = layout.m_subresources[band.m_subresource_index];
+                const ImageSubresource& target = encoded_layout.m_subresources[band.m_subresource_index];
+                encodeBCBlockRows(
+                    image_buffer.m_format,
+                    target_format,
+                    quality,
+                    simd_level,
+                    (const std::byte*)image_buffer.m_buffer + source.m_offset + band.m_slice * source.m_slice_pitch,
+                    source.m_row_pitch,
+                    (std::byte*)destination + target.m_offset + band.m_slice * target.m_slice_pitch,
+                    target.m_row_pitch,
+                    source.m_width,
+                    source.m_height,
+                    band.m_first_block_row,
+                    band.m_block_row_count
+                );
+            }
+        });
+        if(cancellation.isCancelled())
+        {
+            Core::Logger::trace("bc encode cancelled");
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        Interface::FileLoader::ImageBuffer encoded_buffer = image_buffer;
+        {
+            encoded_buffer.m_buffer = destination;
+            encoded_buffer.m_size = encoded_size;
+            encoded_buffer.m_format = target_format;
+            encoded_buffer.m_mip_map_count = encoded_layout.m_mip_map_count;
+        }
+        return encoded_buffer;
+    }
+
+    Interface::FileLoader::ImageBuffer ImageLoader::generateMipMaps(
+        const Interface::FileLoader::ImageBuffer& image_buffer,
+        const ImageLayout& layout,
+        const MipGenerationOptions& options,
+        const ImageAllocator& allocator,
+        ImageLayout& mip_layout,
+        const CancellationToken& cancellation)
+    {
+        if(layout.m_subresources.empty())
+        {
+            Core::Logger::error("mip generation failed: empty layout");
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        const ImageSubresource& top_level = layout.m_subresources.front();
+        std::uint32_t mip_map_count = computeFullMipMapCount(top_level.m_width, top_level.m_height, top_level.m_depth);
+        if(layout.m_mip_map_count > 1 || mip_map_count == 1)
+        {
+            mip_layout = layout;
+            return image_buffer;
+        }
+        if(isMipGenerationSupported(image_buffer.m_format) == false)
+        {
+            Core::Logger::error("mip generation failed: unsupported format {}", (std::uint32_t)image_buffer.m_format);
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        size_t mip_size = buildImageLayout(
+            mip_layout,
+            image_buffer.m_format,
+            layout.m_dimension,
+            top_level.m_width,
+            top_level.m_height,
+            top_level.m_depth,
+            mip_map_count,
+            layout.m_array_size
+        );
+        if(mip_size == 0)
+        {
+            // Extents past the layout limits or a size that overflowed.
+            Core::Logger::error("mip generation failed: no layout for the mip chain");
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        void* destination = nullptr;
+        {
+            ImageStageTimer timer(ImageLoadStage::ALLOCATE);
+            destination = allocator(mip_size);
+        }
+        if(destination == nullptr)
+        {
+            Core::Logger::error("mip generation failed: allocator returned null for {} bytes", mip_size);
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        ImageStageTimer timer(ImageLoadStage::MIP_GENERATION);
+
+        // Both layouts are tightly packed, level 0 of each layer copies as is.
+        for(std::uint32_t layer = 0; layer < layout.m_array_size; ++layer)
+        {
+            const ImageSubresource* source = layout.getSubresource(0, layer);
+            const ImageSubresource* target = mip_layout.getSubresource(0, layer);
+            std::memcpy((std::byte*)destination + target->m_offset, (const std::byte*)image_buffer.m_buffer + source->m_offset, target->m_size);
+        }
+
+        // Every level is filtered from the one above it, so levels run in order
+        // and the rows of all layers of one level run in parallel.
+        SimdLevel simd_level = getSimdLevel();
+        for(std::uint32_t mip_level = 1; mip_level < mip_map_count; ++mip_level)
+        {
+            if(cancellation.isCancelled())
+            {
+                Core::Logger::trace("mip generation cancelled at level {}", mip_level);
+                return Interface::FileLoader::ImageBuffer{};
+            }
+
+            const ImageSubresource& source_level = *mip_layout.getSubresource(mip_level - 1, 0);
+            const ImageSubresource& target_level = *mip_layout.getSubresource(mip_level, 0);
+            MipAxisFilter filter_x = buildMipAxisFilter(options.m_filter, source_level.m_width, target_level.m_width);
+            MipAxisFilter filter_y = buildMipAxisFilter(options.m_filter, source_level.m_height, target_level.m_height);
+            MipAxisFilter filter_z = buildMipAxisFilter(options.m_filter, source_level.m_depth, target_level.m_depth);
+
+            std::uint32_t band_count = (target_level.m_height + g_block_band_rows - 1) / g_block_band_rows;
+            std::uint32_t bands_per_layer = band_count * target_level.m_depth;
+            m_task_pool.parallelFor(bands_per_layer * layout.m_array_size, 1, [&](size_t begin, size_t end)
+            {
+                for(size_t band_index = begin; band_index < end && cancellation.isCancelled() == false; ++band_index)
+                {
+                    std::uint32_t layer = (std::uint32_t)(band_index / bands_per_layer);
+                    std::uint32_t slice = (std::uint32_t)(band_index % bands_per_layer) / band_count;
+                    std::uint32_t first_row = (std::uint32_t)(band_index % band_count) * g_block_band_rows;
+
+                    const ImageSubresource* source = mip_layout.getSubresource(mip_level - 1, layer);
+                    const ImageSubresource* target = mip_layout.getSubresource(mip_level, layer);
+                    generateMipRows(
+                        image_buffer.m_format,
+                        options,
+                        simd_level,
+                        filter_x,
+                        filter_y,
+                        filter_z,
+                        (const std::byte*)destination + source->m_offset,
+                        source->m_row_pitch,
+                        source->m_slice_pitch,
+                        source->m_width,
+                        (std::byte*)destination + target->m_offset,
+                        target->m_row_pitch,
+                        target->m_slice_pitch,
+                        target->m_width,
+                        slice,
+                        first_row,
+                        std::min(g_block_band_rows, target->m_height - first_row)
+                    );
+                }
+            });
+        }
+        if(cancellation.isCancelled())
+        {
+            Core::Logger::trace("mip generation cancelled");
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        Interface::FileLoader::ImageBuffer mip_buffer = image_buffer;
+        {
+            mip_buffer.m_buffer = destination;
+            mip_buffer.m_size = mip_size;
+            mip_buffer.m_mip_map_count = mip_map_count;
+        }
+        return mip_buffer;
+    }
+}
\ No newline at end of file
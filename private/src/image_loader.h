@@ -1,12 +1,200 @@
 #pragma once
 #include "interface/file_loader/image_loader.h"
+#include "bc_encoder.h"
+#include "cancellation_token.h"
+#include "image_buffer_pool.h"
+#include "image_cache.h"
+#include "image_layout.h"
+#include "image_metrics.h"
+#include "mip_generator.h"
+#include "mapped_image.h"
+#include "task_pool.h"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <vector>
 namespace Arieo
 {
+    class AsyncImageLoader;
+
+    // Returns memory for a decoded image; the caller keeps ownership of it.
+    using ImageAllocator = std::function<void*(size_t size)>;
+
+    // Header-only description of an stb supported image (PNG, JPEG, TGA, BMP, HDR).
+    struct ImageInfo
+    {
+        Interface::RHI::Format m_format = Interface::RHI::Format::UNKNOWN;
+        std::uint32_t m_width = 0;
+        std::uint32_t m_height = 0;
+        std::uint32_t m_channels = 0;
+
+        // Bytes the decoded image occupies in m_format.
+        size_t m_size = 0;
+    };
+
+    // One encoded file in memory, either DDS or any format loadImage accepts.
+    struct ImageSource
+    {
+        const void* m_buffer = nullptr;
+        size_t m_size = 0;
+    };
+
+    // Post-processing loadPooled and loadCached apply after loading. Every stage is optional
+    // and they run in member order: decode, mip generation, encode.
+    struct ImageLoadOptions
+    {
+        // Decompress BC images to getBCDecodedFormat.
+        bool m_decode_block_compressed = false;
+
+        // Build a full mip chain for images that come with a single mip.
+        bool m_generate_mip_maps = false;
+        MipGenerationOptions m_mip_generation;
+
+        // Compress to this BC format, UNKNOWN keeps the loaded format.
+        Interface::RHI::Format m_encode_format = Interface::RHI::Format::UNKNOWN;
+        BCEncodeQuality m_encode_quality = BCEncodeQuality::FAST;
+    };
+
     class ImageLoader
         : public Interface::FileLoader::IImageLoader
     {
     public:
+        explicit ImageLoader(TaskPool& task_pool, size_t cache_byte_budget = g_default_image_cache_budget);
+
+        // Zero-copy like the overload below, except that legacy formats whose
+        // conversion keeps the texel size (X8, X1 and X4 padding) are converted
+        // in place, the interface hands over a writable buffer.
         Interface::FileLoader::ImageBuffer loadDDS(void* buffer, size_t size) override;
+
+        // Zero-copy: image buffer and every subresource in layout point into buffer,
+        // which may be a read only mapping. Fails for legacy formats that need a
+        // texel conversion, see below.
+        Interface::FileLoader::ImageBuffer loadDDS(void* buffer, size_t size, ImageLayout& layout);
+
+        // Copies the texels into memory from allocator. Legacy formats the RHI
+        // cannot sample (24 bit RGB, X8 / X1 / X4 padding, 10:10:10:2, 11:11:10
+        // float) are converted on the way, see DDSImageDesc::m_conversion.
+        Interface::FileLoader::ImageBuffer loadDDS(const void* buffer, size_t size, const ImageAllocator& allocator, ImageLayout& layout);
+
+        // KTX2 with no or zstd supercompression. Mip levels are decompressed in
+        // parallel straight into memory from allocator, the result has the
+        // same shape loadDDS gives.
+        Interface::FileLoader::ImageBuffer loadKTX2(const void* buffer, size_t size, const ImageAllocator& allocator, ImageLayout& layout);
+
+        // Maps the file instead of reading it; nothing but the header is paged in
+        // until mips are touched or MappedImage::prefetchMipLevels is called.
+        std::shared_ptr<MappedImage> loadDDSFile(const std::filesystem::path& path);
+
+        // Reads only the file header, use it to size the destination of loadImage.
+        bool queryImageInfo(const void* buffer, size_t size, ImageInfo& info);
+
+        // Decodes straight into destination, which must hold at least ImageInfo::m_size bytes.
+        Interface::FileLoader::ImageBuffer loadImage(const void* buffer, size_t size, void* destination, size_t destination_size);
+        Interface::FileLoader::ImageBuffer loadImage(const void* buffer, size_t size, const ImageAllocator& allocator);
+
+        // Loads every source on the module task pool; results keep the order of sources.
+        // DDS stays zero-copy unless it needs a conversion or is supercompressed
+        // (see compressDDS); KTX2 and everything else is decoded
+        // into memory from allocator, which therefore has to be callable from several
+        // threads at once.
+        std::vector<Interface::FileLoader::ImageBuffer> loadBatch(
+            const std::vector<ImageSource>& sources,
+            const ImageAllocator& allocator,
+            std::vector<ImageLayout>& layouts
+        );
+
+        // Decompresses every subresource of a BC1 - BC7 image into getBCDecodedFormat,
+        // block row bands of all subresources are decoded in parallel.
+        Interface::FileLoader::ImageBuffer decodeBlockCompressed(
+            const Interface::FileLoader::ImageBuffer& image_buffer,
+            const ImageLayout& layout,
+            const ImageAllocator& allocator,
+            ImageLayout& decoded_layout
+        );
+
+        // Compresses every subresource of an R8G8B8A8 / B8G8R8A8 image to target_format,
+        // one of BC1, BC3, BC5 UNORM or BC7; block row bands are encoded in parallel.
+        // Cancellation is checked per band and fails the call; memory taken from
+        // allocator is left to the caller as on any failure.
+        Interface::FileLoader::ImageBuffer encodeBlockCompressed(
+            const Interface::FileLoader::ImageBuffer& image_buffer,
+            const ImageLayout& layout,
+            Interface::RHI::Format target_format,
+            BCEncodeQuality quality,
+            const ImageAllocator& allocator,
+            ImageLayout& encoded_layout,
+            const CancellationToken& cancellation = CancellationToken{}
+        );
+
+        // Builds a full mip chain below level 0 of every layer when layout has a
+        // single mip. Images that already have mips are returned unchanged with
+        // mip_layout = layout; block compressed images have to be decoded first.
+        // Cancellation is checked per level and band, like encodeBlockCompressed.
+        Interface::FileLoader::ImageBuffer generateMipMaps(
+            const Interface::FileLoader::ImageBuffer& image_buffer,
+            const ImageLayout& layout,
+            const MipGenerationOptions& options,
+            const ImageAllocator& allocator,
+            ImageLayout& mip_layout,
+            const CancellationToken& cancellation = CancellationToken{}
+        );
+
+        // Loads a DDS or KTX2 file or anything loadImage accepts and applies
+        // options. Every stage allocates from the buffer pool and hands its input
+        // back as soon as it is done, and the returned image releases its buffer
+        // to the pool with its last handle. Returns nullptr on failure or once
+        // cancellation is requested.
+        ImageHandle loadPooled(
+            const void* buffer,
+            size_t size,
+            const ImageLoadOptions& options = ImageLoadOptions{},
+            const CancellationToken& cancellation = CancellationToken{}
+        );
+
+        // loadPooled with the result cached under a hash of the file bytes and
+        // options, so loading the same texture again returns the resident image
+        // without decoding.
+        ImageHandle loadCached(
+            const void* buffer,
+            size_t size,
+            const ImageLoadOptions& options = ImageLoadOptions{},
+            const CancellationToken& cancellation = CancellationToken{}
+        );
+
+        ImageCache& getImageCache() { return m_image_cache; }
+        ImageBufferPool& getBufferPool() { return m_buffer_pool; }
+
+        // The module's async front end over this loader and its task pool,
+        // nullptr for loaders the module does not own.
+        AsyncImageLoader* getAsyncLoader() const { return m_async_loader; }
+        void setAsyncLoader(AsyncImageLoader* async_loader) { m_async_loader = async_loader; }
+
+        // Writes getImageLoadMetrics, which covers every loader in the process,
+        // and the cache and buffer pool stats of this loader to the info log.
+        void logMetrics() const;
+
+        // Calls logMetrics from the first load that starts once interval has
+        // passed since the last dump; zero, the default, turns it off.
+        void setMetricsLogInterval(std::chrono::milliseconds interval);
+
+    private:
+        void logMetricsIfDue();
+
+        // Both zero-copy loadDDS overloads; in place conversions only run when
+        // is_buffer_writable is set.
+        Interface::FileLoader::ImageBuffer loadDDSInBuffer(void* buffer, size_t size, bool is_buffer_writable, ImageLayout& layout);
+
+        TaskPool& m_task_pool;
+        // Declared before the cache, cached images return their buffers on destruction.
+        ImageBufferPool m_buffer_pool;
+        ImageCache m_image_cache;
+        AsyncImageLoader* m_async_loader = nullptr;
+
+        // Both in steady clock nanoseconds.
+        std::atomic<std::int64_t> m_metrics_log_interval{0};
+        std::atomic<std::int64_t> m_next_metrics_log_time{0};
     };
 }
\ No newline at end of file
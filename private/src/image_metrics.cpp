@@ -0,0 +1,317 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "image_metrics.h"
+#include "image_buffer_pool.h"
+#include "image_loader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <numeric>
+#include <vector>
+
+namespace Arieo
+{
+    static std::atomic<bool> g_image_metrics_enabled{true};
+
+    struct StageCounters
+    {
+        std::atomic<std::uint64_t> m_count{0};
+        std::atomic<std::uint64_t> m_total_nanoseconds{0};
+        std::atomic<std::uint64_t> m_max_nanoseconds{0};
+    };
+
+    // Written by its own thread only, read by snapshots.
+    struct ThreadCounters
+    {
+        std::array<StageCounters, g_image_load_stage_count> m_stages;
+        std::array<std::atomic<std::uint64_t>, g_image_container_count> m_load_counts{};
+        std::atomic<std::uint64_t> m_failure_count{0};
+        std::atomic<std::uint64_t> m_bytes_in{0};
+        std::atomic<std::uint64_t> m_bytes_out{0};
+        std::array<std::atomic<std::uint64_t>, g_image_metrics_format_count> m_format_counts{};
+    };
+
+    // Single writer, so a plain load and store is enough and avoids the
+    // locked instruction of fetch_add.
+    static void addCounter(std::atomic<std::uint64_t>& counter, std::uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static void maxCounter(std::atomic<std::uint64_t>& counter, std::uint64_t value)
+    {
+        if(value > counter.load(std::memory_order_relaxed))
+        {
+            counter.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    // Live thread blocks and the totals of exited threads. The mutex is
+    // taken when a thread records for the first time, when it exits and
+    // by snapshots, never on the recording path itself.
+    struct CounterRegistry
+    {
+        std::mutex m_mutex;
+        std::vector<const ThreadCounters*> m_threads;
+        ImageLoadMetrics m_retired;
+    };
+
+    // Never destroyed: pool workers joined from static destructors, such as
+    // the module's, still fold their counters in when they exit.
+    static CounterRegistry& getCounterRegistry()
+    {
+        static CounterRegistry& registry = *new CounterRegistry;
+        return registry;
+    }
+
+    static void accumulate(ImageLoadMetrics& metrics, const ThreadCounters& counters)
+    {
+        for(size_t stage = 0; stage < g_image_load_stage_count; ++stage)
+        {
+            ImageStageMetrics& stage_metrics = metrics.m_stages[stage];
+            stage_metrics.m_count += counters.m_stages[stage].m_count.load(std::memory_order_relaxed);
+            stage_metrics.m_total_nanoseconds += counters.m_stages[stage].m_total_nanoseconds.load(std::memory_order_relaxed);
+            stage_metrics.m_max_nanoseconds = std::max(stage_metrics.m_max_nanoseconds, counters.m_stages[stage].m_max_nanoseconds.load(std::memory_order_relaxed));
+        }
+        for(size_t container = 0; container < g_image_container_count; ++container)
+        {
+            metrics.m_load_counts[container] += counters.m_load_counts[container].load(std::memory_order_relaxed);
+        }
+        metrics.m_failure_count += counters.m_failure_count.load(std::memory_order_relaxed);
+        metrics.m_bytes_in += counters.m_bytes_in.load(std::memory_order_relaxed);
+        metrics.m_bytes_out += counters.m_bytes_out.load(std::memory_order_relaxed);
+        for(size_t format = 0; format < g_image_metrics_format_count; ++format)
+        {
+            metrics.m_format_counts[format] += counters.m_format_counts[format].load(std::memory_order_relaxed);
+        }
+    }
+
+    static void accumulate(ImageLoadMetrics& metrics, const ImageLoadMetrics& other)
+    {
+        for(size_t stage = 0; stage < g_image_load_stage_count; ++stage)
+        {
+            metrics.m_stages[stage].m_count += other.m_stages[stage].m_count;
+            metrics.m_stages[stage].m_total_nanoseconds += other.m_stages[stage].m_total_nanoseconds;
+            metrics.m_stages[stage].m_max_nanoseconds = std::max(metrics.m_stages[stage].m_max_nanoseconds, other.m_stages[stage].m_max_nanoseconds);
+        }
+        for(size_t container = 0; container < g_image_container_count; ++container)
+        {
+            metrics.m_load_counts[container] += other.m_load_counts[container];
+        }
+        metrics.m_failure_count += other.m_failure_count;
+        metrics.m_bytes_in += other.m_bytes_in;
+        metrics.m_bytes_out += other.m_bytes_out;
+        for(size_t format = 0; format < g_image_metrics_format_count; ++format)
+        {
+            metrics.m_format_counts[format] += other.m_format_counts[format];
+        }
+    }
+
+    class ThreadCountersHolder
+    {
+    public:
+        ThreadCountersHolder()
+        {
+            CounterRegistry& registry = getCounterRegistry();
+            std::lock_guard<std::mutex> lock(registry.m_mutex);
+            registry.m_threads.emplace_back(&m_counters);
+        }
+
+        ~ThreadCountersHolder()
+        {
+            CounterRegistry& registry = getCounterRegistry();
+            std::lock_guard<std::mutex> lock(registry.m_mutex);
+            accumulate(registry.m_retired, m_counters);
+            registry.m_threads.erase(std::find(registry.m_threads.begin(), registry.m_threads.end(), &m_counters));
+        }
+
+        ThreadCounters m_counters;
+    };
+
+    static ThreadCounters& getThreadCounters()
+    {
+        thread_local ThreadCountersHolder holder;
+        return holder.m_counters;
+    }
+
+    const char* getImageLoadStageName(ImageLoadStage stage)
+    {
+        switch(stage)
+        {
+        case ImageLoadStage::PARSE_HEADER: return "parse_header";
+        case ImageLoadStage::MAP_FORMAT: return "map_format";
+        case ImageLoadStage::ALLOCATE: return "allocate";
+        case ImageLoadStage::COPY: return "copy";
+        case ImageLoadStage::CONVERT: return "convert";
+        case ImageLoadStage::DECOMPRESS: return "decompress";
+        case ImageLoadStage::DECODE: return "decode";
+        case ImageLoadStage::BC_DECODE: return "bc_decode";
+        case ImageLoadStage::BC_ENCODE: return "bc_encode";
+        case ImageLoadStage::MIP_GENERATION: return "mip_generation";
+        default: return "unknown";
+        }
+    }
+
+    const char* getImageContainerName(ImageContainer container)
+    {
+        switch(container)
+        {
+        case ImageContainer::DDS: return "dds";
+        case ImageContainer::KTX2: return "ktx2";
+        case ImageContainer::STB: return "stb";
+        default: return "unknown";
+        }
+    }
+
+    void setImageMetricsEnabled(bool enabled)
+    {
+        g_image_metrics_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool isImageMetricsEnabled()
+    {
+        return g_image_metrics_enabled.load(std::memory_order_relaxed);
+    }
+
+    void recordImageStage(ImageLoadStage stage, std::chrono::nanoseconds duration)
+    {
+        StageCounters& counters = getThreadCounters().m_stages[(size_t)stage];
+        std::uint64_t nanoseconds = (std::uint64_t)std::max<std::int64_t>(duration.count(), 0);
+        addCounter(counters.m_count, 1);
+        addCounter(counters.m_total_nanoseconds, nanoseconds);
+        maxCounter(counters.m_max_nanoseconds, nanoseconds);
+    }
+
+    void recordImageLoad(ImageContainer container, Interface::RHI::Format format, size_t bytes_in, size_t bytes_out)
+    {
+        ThreadCounters& counters = getThreadCounters();
+        addCounter(counters.m_load_counts[(size_t)container], 1);
+        addCounter(counters.m_bytes_in, bytes_in);
+        addCounter(counters.m_bytes_out, bytes_out);
+        addCounter(counters.m_format_counts[std::min<size_t>((size_t)format, g_image_metrics_format_count - 1)], 1);
+    }
+
+    void recordImageLoadFailure()
+    {
+        addCounter(getThreadCounters().m_failure_count, 1);
+    }
+
+    ImageLoadMetrics getImageLoadMetrics()
+    {
+        ImageLoadMetrics metrics;
+        CounterRegistry& registry = getCounterRegistry();
+        {
+            std::lock_guard<std::mutex> lock(registry.m_mutex);
+            metrics = registry.m_retired;
+            for(const ThreadCounters* thread_counters : registry.m_threads)
+            {
+                accumulate(metrics, *thread_counters);
+            }
+        }
+        metrics.m_scratch_reserved_bytes = ScratchArena::getReservedBytesOfAllThreads();
+        return metrics;
+    }
+
+    static std::int64_t getSteadyClockNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void ImageLoader::logMetrics() const
+    {
+        static const std::uint64_t g_bytes_per_kilobyte = 1024;
+        static const std::uint64_t g_nanoseconds_per_microsecond = 1000;
+        static const size_t g_logged_format_count = 8;
+
+        ImageLoadMetrics metrics = getImageLoadMetrics();
+        ImageCacheStats cache_stats = m_image_cache.getStats();
+        ImageBufferPoolStats buffer_pool_stats = m_buffer_pool.getStats();
+        Core::Logger::info(
+            "image metrics: loads dds {} ktx2 {} stb {} failed {}, read {} KB, produced {} KB, scratch {} KB",
+            metrics.m_load_counts[(size_t)ImageContainer::DDS],
+            metrics.m_load_counts[(size_t)ImageContainer::KTX2],
+            metrics.m_load_counts[(size_t)ImageContainer::STB],
+            metrics.m_failure_count,
+            metrics.m_bytes_in / g_bytes_per_kilobyte,
+            metrics.m_bytes_out / g_bytes_per_kilobyte,
+            metrics.m_scratch_reserved_bytes / g_bytes_per_kilobyte
+        );
+
+        for(size_t stage = 0; stage < g_image_load_stage_count; ++stage)
+        {
+            const ImageStageMetrics& stage_metrics = metrics.m_stages[stage];
+            if(stage_metrics.m_count == 0)
+            {
+                continue;
+            }
+            Core::Logger::info(
+                "image metrics: {} count {} total {} us mean {} us max {} us",
+                getImageLoadStageName((ImageLoadStage)stage),
+                stage_metrics.m_count,
+                stage_metrics.m_total_nanoseconds / g_nanoseconds_per_microsecond,
+                stage_metrics.m_total_nanoseconds / stage_metrics.m_count / g_nanoseconds_per_microsecond,
+                stage_metrics.m_max_nanoseconds / g_nanoseconds_per_microsecond
+            );
+        }
+
+        // Most loaded formats first.
+        std::array<size_t, g_image_metrics_format_count> formats;
+        std::iota(formats.begin(), formats.end(), 0);
+        size_t logged_format_count = std::min(g_logged_format_count, formats.size());
+        std::partial_sort(formats.begin(), formats.begin() + logged_format_count, formats.end(), [&](size_t lhs, size_t rhs)
+        {
+            return metrics.m_format_counts[lhs] > metrics.m_format_counts[rhs];
+        });
+        for(size_t index = 0; index < logged_format_count && metrics.m_format_counts[formats[index]] != 0; ++index)
+        {
+            Core::Logger::info("image metrics: format {} loaded {} times", formats[index], metrics.m_format_counts[formats[index]]);
+        }
+
+        // Everything above counts every loader in the process, the rest is this loader's.
+        std::uint64_t lookup_count = cache_stats.m_hit_count + cache_stats.m_miss_count;
+        Core::Logger::info(
+            "image metrics: cache hits {} misses {} hit rate {}% resident {} KB of {} KB",
+            cache_stats.m_hit_count,
+            cache_stats.m_miss_count,
+            lookup_count == 0 ? 0 : cache_stats.m_hit_count * 100 / lookup_count,
+            cache_stats.m_resident_bytes / g_bytes_per_kilobyte,
+            cache_stats.m_byte_budget / g_bytes_per_kilobyte
+        );
+        Core::Logger::info(
+            "image metrics: pool in use {} KB cached {} KB peak {} KB",
+            buffer_pool_stats.m_in_use_bytes / g_bytes_per_kilobyte,
+            buffer_pool_stats.m_cached_bytes / g_bytes_per_kilobyte,
+            buffer_pool_stats.m_high_water_bytes / g_bytes_per_kilobyte
+        );
+    }
+
+    void ImageLoader::setMetricsLogInterval(std::chrono::milliseconds interval)
+    {
+        std::int64_t interval_nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count();
+        std::int64_t now = getSteadyClockNanoseconds();
+        m_next_metrics_log_time.store(now + interval_nanoseconds, std::memory_order_relaxed);
+        m_metrics_log_interval.store(interval_nanoseconds, std::memory_order_relaxed);
+    }
+
+    void ImageLoader::logMetricsIfDue()
+    {
+        std::int64_t interval = m_metrics_log_interval.load(std::memory_order_relaxed);
+        if(interval <= 0)
+        {
+            return;
+        }
+
+        // Of the loads that find the deadline passed only the one that moves
+        // it forward logs.
+        std::int64_t now = getSteadyClockNanoseconds();
+        std::int64_t next_log_time = m_next_metrics_log_time.load(std::memory_order_relaxed);
+        if(now < next_log_time
+            || m_next_metrics_log_time.compare_exchange_strong(next_log_time, now + interval, std::memory_order_relaxed) == false)
+        {
+            return;
+        }
+        logMetrics();
+    }
+}
\ No newline at end of file
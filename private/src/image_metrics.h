@@ -0,0 +1,168 @@
+#pragma once
+#include "interface/file_loader/image_loader.h"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+namespace Arieo
+{
+    enum class ImageLoadStage : std::uint32_t
+    {
+        // Header validation, includes MAP_FORMAT.
+        PARSE_HEADER,
+        // DXGI, legacy DDS and VkFormat to RHI format.
+        MAP_FORMAT,
+        // Time spent inside allocator callbacks.
+        ALLOCATE,
+        // Texels copied out unchanged.
+        COPY,
+        // Legacy DDS texel conversions.
+        CONVERT,
+        // LZ4 / zstd supercompression.
+        DECOMPRESS,
+        // PNG, JPEG and the other stb_image formats.
+        DECODE,
+        BC_DECODE,
+        BC_ENCODE,
+        MIP_GENERATION,
+        COUNT
+    };
+
+    enum class ImageContainer : std::uint32_t
+    {
+        DDS,
+        KTX2,
+        // Everything loadImage reads through stb_image.
+        STB,
+        COUNT
+    };
+
+    inline constexpr size_t g_image_load_stage_count = (size_t)ImageLoadStage::COUNT;
+    inline constexpr size_t g_image_container_count = (size_t)ImageContainer::COUNT;
+
+    // RHI formats at or above the last bucket are counted in it.
+    inline constexpr size_t g_image_metrics_format_count = 256;
+
+    // Interval the module dumps the metrics of its loader at.
+    inline constexpr std::chrono::milliseconds g_default_image_metrics_log_interval{60 * 1000};
+
+    const char* getImageLoadStageName(ImageLoadStage stage);
+    const char* getImageContainerName(ImageContainer container);
+
+    struct ImageStageMetrics
+    {
+        std::uint64_t m_count = 0;
+        std::uint64_t m_total_nanoseconds = 0;
+        std::uint64_t m_max_nanoseconds = 0;
+    };
+
+    // Process wide: covers the loads of every ImageLoader.
+    struct ImageLoadMetrics
+    {
+        std::array<ImageStageMetrics, g_image_load_stage_count> m_stages{};
+
+        // Successful loads per container, failed loads of every container.
+        std::array<std::uint64_t, g_image_container_count> m_load_counts{};
+        std::uint64_t m_failure_count = 0;
+
+        // File bytes read and image bytes produced by successful loads.
+        std::uint64_t m_bytes_in = 0;
+        std::uint64_t m_bytes_out = 0;
+
+        // Successful loads per resulting RHI format.
+        std::array<std::uint64_t, g_image_metrics_format_count> m_format_counts{};
+
+        // Scratch arenas of all threads, see ScratchArena.
+        size_t m_scratch_reserved_bytes = 0;
+    };
+
+    // Counters live in a block per thread that only its own thread writes,
+    // with relaxed loads and stores and no read-modify-write, so recording
+    // never contends and never locks. A snapshot sums the blocks of every
+    // live thread plus what exited threads left behind; it may miss updates
+    // that race with it but never tears a counter. Recording is on by default.
+    void setImageMetricsEnabled(bool enabled);
+    bool isImageMetricsEnabled();
+
+    void recordImageStage(ImageLoadStage stage, std::chrono::nanoseconds duration);
+    void recordImageLoad(ImageContainer container, Interface::RHI::Format format, size_t bytes_in, size_t bytes_out);
+    void recordImageLoadFailure();
+
+    // Counters only grow, diff two snapshots to measure an interval. Cache
+    // and buffer pool stats belong to a loader, see ImageLoader::logMetrics.
+    ImageLoadMetrics getImageLoadMetrics();
+
+    // Times its scope as one run of a stage.
+    class ImageStageTimer
+    {
+    public:
+        explicit ImageStageTimer(ImageLoadStage stage)
+            : m_stage(stage),
+              m_is_enabled(isImageMetricsEnabled())
+        {
+            if(m_is_enabled)
+            {
+                m_start_time = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~ImageStageTimer()
+        {
+            if(m_is_enabled)
+            {
+                recordImageStage(m_stage, std::chrono::steady_clock::now() - m_start_time);
+            }
+        }
+
+        ImageStageTimer(const ImageStageTimer&) = delete;
+        ImageStageTimer& operator=(const ImageStageTimer&) = delete;
+
+    private:
+        ImageLoadStage m_stage;
+        bool m_is_enabled;
+        std::chrono::steady_clock::time_point m_start_time;
+    };
+
+    // Records one load of a file: a success if setResult was called with a
+    // loaded image before the scope ends, a failure otherwise.
+    class ImageLoadRecord
+    {
+    public:
+        ImageLoadRecord(ImageContainer container, size_t bytes_in)
+            : m_container(container),
+              m_bytes_in(bytes_in)
+        {
+        }
+
+        ~ImageLoadRecord()
+        {
+            if(isImageMetricsEnabled() == false)
+            {
+                return;
+            }
+            if(m_has_result)
+            {
+                recordImageLoad(m_container, m_format, m_bytes_in, m_bytes_out);
+                return;
+            }
+            recordImageLoadFailure();
+        }
+
+        ImageLoadRecord(const ImageLoadRecord&) = delete;
+        ImageLoadRecord& operator=(const ImageLoadRecord&) = delete;
+
+        void setResult(const Interface::FileLoader::ImageBuffer& image_buffer)
+        {
+            m_has_result = image_buffer.m_buffer != nullptr;
+            m_format = image_buffer.m_format;
+            m_bytes_out = image_buffer.m_size;
+        }
+
+    private:
+        ImageContainer m_container;
+        size_t m_bytes_in;
+        size_t m_bytes_out = 0;
+        Interface::RHI::Format m_format = Interface::RHI::Format::UNKNOWN;
+        bool m_has_result = false;
+    };
+}
\ No newline at end of file
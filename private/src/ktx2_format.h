@@ -0,0 +1,41 @@
+#pragma once
+#include "interface/file_loader/image_loader.h"
+#include "image_layout.h"
+#include "supercompression.h"
+#include <cstdint>
+#include <vector>
+namespace Arieo
+{
+    // Byte range of one mip level in a KTX2 file. A level holds every array
+    // layer, face and depth slice of that mip back to back.
+    struct KTX2Level
+    {
+        std::uint64_t m_offset = 0;
+        std::uint64_t m_size = 0;
+        std::uint64_t m_uncompressed_size = 0;
+    };
+
+    // Everything loadKTX2 needs from the KTX2 header and level index.
+    struct KTX2ImageDesc
+    {
+        Interface::RHI::Format m_format = Interface::RHI::Format::UNKNOWN;
+        Supercompression m_supercompression = Supercompression::NONE;
+        ImageDimension m_dimension = ImageDimension::TEXTURE_2D;
+
+        std::uint32_t m_width = 1;
+        std::uint32_t m_height = 1;
+        std::uint32_t m_depth = 1;
+        std::uint32_t m_mip_map_count = 1;
+        // Layers times faces, cube maps report six layers per cube like DDS.
+        std::uint32_t m_array_size = 1;
+
+        // Mip 0 first.
+        std::vector<KTX2Level> m_levels;
+    };
+
+    bool isKTX2File(const void* buffer, size_t size);
+
+    // Only the header and level index have to be present in buffer. Fails for
+    // BasisLZ and zlib supercompression and for formats the RHI lacks.
+    bool parseKTX2Header(const void* buffer, size_t size, KTX2ImageDesc& desc);
+}
\ No newline at end of file
@@ -0,0 +1,429 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "image_loader.h"
+#include "image_metrics.h"
+#include "ktx2_format.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace Arieo
+{
+    static const std::uint8_t g_ktx2_identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+    struct KTX2Header
+    {
+        std::uint8_t identifier[12];
+        std::uint32_t vkFormat;
+        std::uint32_t typeSize;
+        std::uint32_t pixelWidth;
+        std::uint32_t pixelHeight;
+        std::uint32_t pixelDepth;
+        std::uint32_t layerCount;
+        std::uint32_t faceCount;
+        std::uint32_t levelCount;
+        std::uint32_t supercompressionScheme;
+        std::uint32_t dfdByteOffset;
+        std::uint32_t dfdByteLength;
+        std::uint32_t kvdByteOffset;
+        std::uint32_t kvdByteLength;
+        std::uint64_t sgdByteOffset;
+        std::uint64_t sgdByteLength;
+    };
+
+    struct KTX2LevelIndex
+    {
+        std::uint64_t byteOffset;
+        std::uint64_t byteLength;
+        std::uint64_t uncompressedByteLength;
+    };
+
+    static_assert(sizeof(KTX2Header) == 80, "ktx2 header layout");
+
+    enum class KTX2SupercompressionScheme : std::uint32_t
+    {
+        NONE = 0,
+        BASIS_LZ = 1,
+        ZSTANDARD = 2,
+        ZLIB = 3
+    };
+
+    // The VkFormat values KTX2 files store for formats the RHI has.
+    enum class VkFormat : std::uint32_t
+    {
+        VK_FORMAT_UNDEFINED = 0,
+        VK_FORMAT_B4G4R4A4_UNORM_PACK16 = 3,
+        VK_FORMAT_B5G6R5_UNORM_PACK16 = 5,
+        VK_FORMAT_B5G5R5A1_UNORM_PACK16 = 7,
+        VK_FORMAT_R8_UNORM = 9,
+        VK_FORMAT_R8_SNORM = 10,
+        VK_FORMAT_R8_UINT = 13,
+        VK_FORMAT_R8_SINT = 14,
+        VK_FORMAT_R8G8_UNORM = 16,
+        VK_FORMAT_R8G8_SNORM = 17,
+        VK_FORMAT_R8G8_UINT = 20,
+        VK_FORMAT_R8G8_SINT = 21,
+        VK_FORMAT_R8G8B8A8_UNORM = 37,
+        VK_FORMAT_R8G8B8A8_SNORM = 38,
+        VK_FORMAT_R8G8B8A8_UINT = 41,
+        VK_FORMAT_R8G8B8A8_SINT = 42,
+        VK_FORMAT_B8G8R8A8_UNORM = 44,
+        VK_FORMAT_B8G8R8A8_UINT = 48,
+        VK_FORMAT_B8G8R8A8_SRGB = 50,
+        VK_FORMAT_R16_UNORM = 70,
+        VK_FORMAT_R16_SNORM = 71,
+        VK_FORMAT_R16_UINT = 74,
+        VK_FORMAT_R16_SINT = 75,
+        VK_FORMAT_R16_SFLOAT = 76,
+        VK_FORMAT_R16G16_UNORM = 77,
+        VK_FORMAT_R16G16_SNORM = 78,
+        VK_FORMAT_R16G16_UINT = 81,
+        VK_FORMAT_R16G16_SINT = 82,
+        VK_FORMAT_R16G16_SFLOAT = 83,
+        VK_FORMAT_R16G16B16A16_UNORM = 91,
+        VK_FORMAT_R16G16B16A16_SNORM = 92,
+        VK_FORMAT_R16G16B16A16_UINT = 95,
+        VK_FORMAT_R16G16B16A16_SINT = 96,
+        VK_FORMAT_R16G16B16A16_SFLOAT = 97,
+        VK_FORMAT_R32_UINT = 98,
+        VK_FORMAT_R32_SINT = 99,
+        VK_FORMAT_R32_SFLOAT = 100,
+        VK_FORMAT_R32G32_UINT = 101,
+        VK_FORMAT_R32G32_SINT = 102,
+        VK_FORMAT_R32G32_SFLOAT = 103,
+        VK_FORMAT_R32G32B32_UINT = 104,
+        VK_FORMAT_R32G32B32_SINT = 105,
+        VK_FORMAT_R32G32B32_SFLOAT = 106,
+        VK_FORMAT_R32G32B32A32_UINT = 107,
+        VK_FORMAT_R32G32B32A32_SINT = 108,
+        VK_FORMAT_R32G32B32A32_SFLOAT = 109,
+        VK_FORMAT_D16_UNORM = 124,
+        VK_FORMAT_D32_SFLOAT = 126,
+        VK_FORMAT_D24_UNORM_S8_UINT = 129,
+        VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131,
+        VK_FORMAT_BC1_RGB_SRGB_BLOCK = 132,
+        VK_FORMAT_BC1_RGBA_UNORM_BLOCK = 133,
+        VK_FORMAT_BC1_RGBA_SRGB_BLOCK = 134,
+        VK_FORMAT_BC2_UNORM_BLOCK = 135,
+        VK_FORMAT_BC2_SRGB_BLOCK = 136,
+        VK_FORMAT_BC3_UNORM_BLOCK = 137,
+        VK_FORMAT_BC3_SRGB_BLOCK = 138,
+        VK_FORMAT_BC4_UNORM_BLOCK = 139,
+        VK_FORMAT_BC4_SNORM_BLOCK = 140,
+        VK_FORMAT_BC5_UNORM_BLOCK = 141,
+        VK_FORMAT_BC5_SNORM_BLOCK = 142,
+        VK_FORMAT_BC6H_UFLOAT_BLOCK = 143,
+        VK_FORMAT_BC6H_SFLOAT_BLOCK = 144,
+        VK_FORMAT_BC7_UNORM_BLOCK = 145,
+        VK_FORMAT_BC7_SRGB_BLOCK = 146
+    };
+
+    // BC1 with and without alpha share one RHI format, as DXGI_FORMAT_BC1 does in the DDS mapper.
+    ARIEO_ENUM_MAPPER(VkFormat, Interface::RHI::Format)
+    {
+        { VkFormat::VK_FORMAT_UNDEFINED, Interface::RHI::Format::UNKNOWN },
+        { VkFormat::VK_FORMAT_B4G4R4A4_UNORM_PACK16, Interface::RHI::Format::B4G4R4A4_UNORM_PACK16 },
+        { VkFormat::VK_FORMAT_B5G6R5_UNORM_PACK16, Interface::RHI::Format::B5G6R5_UNORM_PACK16 },
+        { VkFormat::VK_FORMAT_B5G5R5A1_UNORM_PACK16, Interface::RHI::Format::B5G5R5A1_UNORM_PACK16 },
+        { VkFormat::VK_FORMAT_R8_UNORM, Interface::RHI::Format::R8_UNORM },
+        { VkFormat::VK_FORMAT_R8_SNORM, Interface::RHI::Format::R8_SNORM },
+        { VkFormat::VK_FORMAT_R8_UINT, Interface::RHI::Format::R8_UINT },
+        { VkFormat::VK_FORMAT_R8_SINT, Interface::RHI::Format::R8_SINT },
+        { VkFormat::VK_FORMAT_R8G8_UNORM, Interface::RHI::Format::R8G8_UNORM },
+        { VkFormat::VK_FORMAT_R8G8_SNORM, Interface::RHI::Format::R8G8_SNORM },
+        { VkFormat::VK_FORMAT_R8G8_UINT, Interface::RHI::Format::R8G8_UINT },
+        { VkFormat::VK_FORMAT_R8G8_SINT, Interface::RHI::Format::R8G8_SINT },
+        { VkFormat::VK_FORMAT_R8G8B8A8_UNORM, Interface::RHI::Format::R8G8B8A8_UNORM },
+        { VkFormat::VK_FORMAT_R8G8B8A8_SNORM, Interface::RHI::Format::R8G8B8A8_SNORM },
+        { VkFormat::VK_FORMAT_R8G8B8A8_UINT, Interface::RHI::Format::R8G8B8A8_UINT },
+        { VkFormat::VK_FORMAT_R8G8B8A8_SINT, Interface::RHI::Format::R8G8B8A8_SINT },
+        { VkFormat::VK_FORMAT_B8G8R8A8_UNORM, Interface::RHI::Format::B8G8R8A8_UNORM },
+        { VkFormat::VK_FORMAT_B8G8R8A8_UINT, Interface::RHI::Format::B8G8R8A8_UINT },
+        { VkFormat::VK_FORMAT_B8G8R8A8_SRGB, Interface::RHI::Format::B8G8R8A8_SRGB },
+        { VkFormat::VK_FORMAT_R16_UNORM, Interface::RHI::Format::R16_UNORM },
+        { VkFormat::VK_FORMAT_R16_SNORM, Interface::RHI::Format::R16_SNORM },
+        { VkFormat::VK_FORMAT_R16_UINT, Interface::RHI::Format::R16_UINT },
+        { VkFormat::VK_FORMAT_R16_SINT, Interface::RHI::Format::R16_SINT },
+        { VkFormat::VK_FORMAT_R16_SFLOAT, Interface::RHI::Format::R16_SFLOAT },
+        { VkFormat::VK_FORMAT_R16G16_UNORM, Interface::RHI::Format::R16G16_UNORM },
+        { VkFormat::VK_FORMAT_R16G16_SNORM, Interface::RHI::Format::R16G16_SNORM },
+        { VkFormat::VK_FORMAT_R16G16_UINT, Interface::RHI::Format::R16G16_UINT },
+        { VkFormat::VK_FORMAT_R16G16_SINT, Interface::RHI::Format::R16G16_SINT },
+        { VkFormat::VK_FORMAT_R16G16_SFLOAT, Interface::RHI::Format::R16G16_SFLOAT },
+        { VkFormat::VK_FORMAT_R16G16B16A16_UNORM, Interface::RHI::Format::R16G16B16A16_UNORM },
+        { VkFormat::VK_FORMAT_R16G16B16A16_SNORM, Interface::RHI::Format::R16G16B16A16_SNORM },
+        { VkFormat::VK_FORMAT_R16G16B16A16_UINT, Interface::RHI::Format::R16G16B16A16_UINT },
+        { VkFormat::VK_FORMAT_R16G16B16A16_SINT, Interface::RHI::Format::R16G16B16A16_SINT },
+        { VkFormat::VK_FORMAT_R16G16B16A16_SFLOAT, Interface::RHI::Format::R16G16B16A16_SFLOAT },
+        { VkFormat::VK_FORMAT_R32_UINT, Interface::RHI::Format::R32_UINT },
+        { VkFormat::VK_FORMAT_R32_SINT, Interface::RHI::Format::R32_SINT },
+        { VkFormat::VK_FORMAT_R32_SFLOAT, Interface::RHI::Format::R32_SFLOAT },
+        { VkFormat::VK_FORMAT_R32G32_UINT, Interface::RHI::Format::R32G32_UINT },
+        { VkFormat::VK_FORMAT_R32G32_SINT, Interface::RHI::Format::R32G32_SINT },
+        { VkFormat::VK_FORMAT_R32G32_SFLOAT, Interface::RHI::Format::R32G32_SFLOAT },
+        { VkFormat::VK_FORMAT_R32G32B32_UINT, Interface::RHI::Format::R32G32B32_UINT },
+        { VkFormat::VK_FORMAT_R32G32B32_SINT, Interface::RHI::Format::R32G32B32_SINT },
+        { VkFormat::VK_FORMAT_R32G32B32_SFLOAT, Interface::RHI::Format::R32G32B32_SFLOAT },
+        { VkFormat::VK_FORMAT_R32G32B32A32_UINT, Interface::RHI::Format::R32G32B32A32_UINT },
+        { VkFormat::VK_FORMAT_R32G32B32A32_SINT, Interface::RHI::Format::R32G32B32A32_SINT },
+        { VkFormat::VK_FORMAT_R32G32B32A32_SFLOAT, Interface::RHI::Format::R32G32B32A32_SFLOAT },
+        { VkFormat::VK_FORMAT_D16_UNORM, Interface::RHI::Format::D16_UNORM },
+        { VkFormat::VK_FORMAT_D32_SFLOAT, Interface::RHI::Format::D32_SFLOAT },
+        { VkFormat::VK_FORMAT_D24_UNORM_S8_UINT, Interface::RHI::Format::D24_UNORM_S8_UINT },
+        { VkFormat::VK_FORMAT_BC1_RGB_UNORM_BLOCK, Interface::RHI::Format::BC1_RGB_UNORM_BLOCK },
+        { VkFormat::VK_FORMAT_BC1_RGB_SRGB_BLOCK, Interface::RHI::Format::BC1_RGB_SRGB_BLOCK },
+        { VkFormat::VK_FORMAT_BC1_RGBA_UNORM_BLOCK, Interface::RHI::Format::BC1_RGB_UNORM_BLOCK },
+        { VkFormat::VK_FORMAT_BC1_RGBA_SRGB_BLOCK, Interface::RHI::Format::BC1_RGB_SRGB_BLOCK },
+        { VkFormat::VK_FORMAT_BC2_UNORM_BLOCK, Interface::RHI::Format::BC2_UNORM_BLOCK },
+        { VkFormat::VK_FORMAT_BC2_SRGB_BLOCK, Interface::RHI::Format::BC2_SRGB_BLOCK },
+        { VkFormat::VK_FORMAT_BC3_UNORM_BLOCK, Interface::RHI::Format::BC3_UNORM_BLOCK },
+        { VkFormat::VK_FORMAT_BC3_SRGB_BLOCK, Interface::RHI::Format::BC3_SRGB_BLOCK },
+        { VkFormat::VK_FORMAT_BC4_UNORM_BLOCK, Interface::RHI::Format::BC4_UNORM_BLOCK },
+        { VkFormat::VK_FORMAT_BC4_SNORM_BLOCK, Interface::RHI::Format::BC4_SNORM_BLOCK },
+        { VkFormat::VK_FORMAT_BC5_UNORM_BLOCK, Interface::RHI::Format::BC5_UNORM_BLOCK },
+        { VkFormat::VK_FORMAT_BC5_SNORM_BLOCK, Interface::RHI::Format::BC5_SNORM_BLOCK },
+        { VkFormat::VK_FORMAT_BC6H_UFLOAT_BLOCK, Interface::RHI::Format::BC6H_UFLOAT_BLOCK },
+        { VkFormat::VK_FORMAT_BC6H_SFLOAT_BLOCK, Interface::RHI::Format::BC6H_SFLOAT_BLOCK },
+        { VkFormat::VK_FORMAT_BC7_UNORM_BLOCK, Interface::RHI::Format::BC7_UNORM_BLOCK },
+        { VkFormat::VK_FORMAT_BC7_SRGB_BLOCK, Interface::RHI::Format::BC7_SRGB_BLOCK },
+    };
+
+    bool isKTX2File(const void* buffer, size_t size)
+    {
+        return buffer != nullptr
+            && size >= sizeof(g_ktx2_identifier)
+            && std::memcmp(buffer, g_ktx2_identifier, sizeof(g_ktx2_identifier)) == 0;
+    }
+
+    bool parseKTX2Header(const void* buffer, size_t size, KTX2ImageDesc& desc)
+    {
+        if(isKTX2File(buffer, size) == false || size < sizeof(KTX2Header))
+        {
+            Core::Logger::error("ktx2 load failed: not a ktx2 file or header truncated");
+            return false;
+        }
+
+        // KTX2 only aligns the level data, read the header through a copy.
+        KTX2Header header;
+        std::memcpy(&header, buffer, sizeof(header));
+
+        desc = KTX2ImageDesc{};
+        {
+            ImageStageTimer timer(ImageLoadStage::MAP_FORMAT);
+            desc.m_format = Base::mapEnum<Interface::RHI::Format>((VkFormat)header.vkFormat);
+        }
+        if(desc.m_format == Interface::RHI::Format::UNKNOWN)
+        {
+            Core::Logger::error("ktx2 load failed: unsupported vkFormat {}", header.vkFormat);
+            return false;
+        }
+
+        switch((KTX2SupercompressionScheme)header.supercompressionScheme)
+        {
+        case KTX2SupercompressionScheme::NONE:
+            desc.m_supercompression = Supercompression::NONE;
+            break;
+        case KTX2SupercompressionScheme::ZSTANDARD:
+            desc.m_supercompression = Supercompression::ZSTD;
+            break;
+        default:
+            Core::Logger::error("ktx2 load failed: unsupported supercompression scheme {}", header.supercompressionScheme);
+            return false;
+        }
+
+        desc.m_width = std::max<std::uint32_t>(header.pixelWidth, 1);
+        desc.m_height = std::max<std::uint32_t>(header.pixelHeight, 1);
+        desc.m_depth = std::max<std::uint32_t>(header.pixelDepth, 1);
+        desc.m_array_size = std::max<std::uint32_t>(header.layerCount, 1);
+        if(header.faceCount != 1 && header.faceCount != 6)
+        {
+            Core::Logger::error("ktx2 load failed: face count {} is neither 1 nor 6", header.faceCount);
+            return false;
+        }
+        if(desc.m_array_size > g_max_image_array_size / header.faceCount)
+        {
+            Core::Logger::error("ktx2 load failed: {} layers of {} faces exceed the layer limit", desc.m_array_size, header.faceCount);
+            return false;
+        }
+        if(header.pixelDepth > 0)
+        {
+            if(header.layerCount > 1 || header.faceCount != 1)
+            {
+                Core::Logger::error("ktx2 load failed: volume texture arrays are not supported");
+                return false;
+            }
+            desc.m_dimension = ImageDimension::TEXTURE_3D;
+        }
+        else if(header.faceCount == 6)
+        {
+            desc.m_dimension = ImageDimension::TEXTURE_CUBE;
+            desc.m_array_size *= 6;
+        }
+        else if(header.pixelHeight == 0)
+        {
+            desc.m_dimension = ImageDimension::TEXTURE_1D;
+        }
+
+        // A level count of 0 asks the loader to generate mips, which generateMipMaps does on request.
+        desc.m_mip_map_count = std::max<std::uint32_t>(header.levelCount, 1);
+        if(isImageExtentSupported(desc.m_width, desc.m_height, desc.m_depth, desc.m_mip_map_count, desc.m_array_size) == false)
+        {
+            Core::Logger::error(
+                "ktx2 load failed: {}x{}x{} with {} mips and {} layers is out of range",
+                desc.m_width,
+                desc.m_height,
+                desc.m_depth,
+                desc.m_mip_map_count,
+                desc.m_array_size
+            );
+            return false;
+        }
+        size_t level_index_size = (size_t)desc.m_mip_map_count * sizeof(KTX2LevelIndex);
+        if(desc.m_mip_map_count > 32 || size - sizeof(KTX2Header) < level_index_size)
+        {
+            Core::Logger::error("ktx2 load failed: level index truncated");
+            return false;
+        }
+
+        desc.m_levels.resize(desc.m_mip_map_count);
+        for(std::uint32_t level = 0; level < desc.m_mip_map_count; ++level)
+        {
+            KTX2LevelIndex level_index;
+            std::memcpy(&level_index, (const std::byte*)buffer + sizeof(KTX2Header) + level * sizeof(KTX2LevelIndex), sizeof(level_index));
+            desc.m_levels[level].m_offset = level_index.byteOffset;
+            desc.m_levels[level].m_size = level_index.byteLength;
+            desc.m_levels[level].m_uncompressed_size = level_index.uncompressedByteLength;
+        }
+        return true;
+    }
+
+    Interface::FileLoader::ImageBuffer ImageLoader::loadKTX2(const void* buffer, size_t size, const ImageAllocator& allocator, ImageLayout& layout)
+    {
+        ImageLoadRecord record(ImageContainer::KTX2, size);
+        KTX2ImageDesc desc;
+        bool is_header_valid = false;
+        {
+            ImageStageTimer timer(ImageLoadStage::PARSE_HEADER);
+            is_header_valid = parseKTX2Header(buffer, size, desc);
+        }
+        if(is_header_valid == false)
+        {
+            layout = ImageLayout{};
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        size_t texture_buffer_size = buildImageLayout(
+            layout,
+            desc.m_format,
+            desc.m_dimension,
+            desc.m_width,
+            desc.m_height,
+            desc.m_depth,
+            desc.m_mip_map_count,
+            desc.m_array_size
+        );
+        if(texture_buffer_size == 0)
+        {
+            Core::Logger::error("ktx2 load failed: unsized format {}", (std::uint32_t)desc.m_format);
+            layout = ImageLayout{};
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        // The layers of one level are contiguous in layout as well, so a whole
+        // level has to come out at exactly the size of its subresources.
+        for(std::uint32_t mip_level = 0; mip_level < desc.m_mip_map_count; ++mip_level)
+        {
+            const KTX2Level& level = desc.m_levels[mip_level];
+            std::uint64_t level_size = (std::uint64_t)layout.getSubresource(mip_level, 0)->m_size * desc.m_array_size;
+            std::uint64_t uncompressed_size = desc.m_supercompression == Supercompression::NONE ? level.m_size : level.m_uncompressed_size;
+            if(level.m_offset > size || level.m_size > size - level.m_offset || uncompressed_size != level_size)
+            {
+                Core::Logger::error("ktx2 load failed: level {} truncated or of unexpected size", mip_level);
+                layout = ImageLayout{};
+                return Interface::FileLoader::ImageBuffer{};
+            }
+        }
+
+        void* destination = nullptr;
+        {
+            ImageStageTimer timer(ImageLoadStage::ALLOCATE);
+            destination = allocator(texture_buffer_size);
+        }
+        if(destination == nullptr)
+        {
+            Core::Logger::error("ktx2 load failed: allocator returned null for {} bytes", texture_buffer_size);
+            layout = ImageLayout{};
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        // KTX2 stores levels mip-major and ImageLayout is layer-major, so every
+        // level scatters to one subresource per layer. Levels run in parallel
+        // and decompress straight into place.
+        std::atomic<bool> failed{false};
+        ImageStageTimer timer(desc.m_supercompression == Supercompression::NONE ? ImageLoadStage::COPY : ImageLoadStage::DECOMPRESS);
+        m_task_pool.parallelFor(desc.m_mip_map_count, 1, [&](size_t begin, size_t end)
+        {
+            ScratchScope scratch;
+            void** destinations = scratch.getArena().allocateArray<void*>(desc.m_array_size);
+            size_t* destination_sizes = scratch.getArena().allocateArray<size_t>(desc.m_array_size);
+            if(destinations == nullptr || destination_sizes == nullptr)
+            {
+                failed.store(true, std::memory_order_relaxed);
+                return;
+            }
+            for(size_t mip_level = begin; mip_level < end && failed.load(std::memory_order_relaxed) == false; ++mip_level)
+            {
+                for(std::uint32_t layer = 0; layer < desc.m_array_size; ++layer)
+                {
+                    const ImageSubresource* subresource = layout.getSubresource((std::uint32_t)mip_level, layer);
+                    destinations[layer] = (std::byte*)destination + subresource->m_offset;
+                    destination_sizes[layer] = subresource->m_size;
+                }
+
+                const KTX2Level& level = desc.m_levels[mip_level];
+                const std::byte* source = (const std::byte*)buffer + level.m_offset;
+                bool decompressed = true;
+                if(desc.m_supercompression == Supercompression::ZSTD)
+                {
+                    decompressed = desc.m_array_size == 1
+                        ? decompressBlock(Supercompression::ZSTD, source, (size_t)level.m_size, destinations[0], destination_sizes[0])
+                        : decompressZstdFrame(source, (size_t)level.m_size, destinations, destination_sizes, desc.m_array_size);
+                }
+                else
+                {
+                    for(std::uint32_t layer = 0; layer < desc.m_array_size; ++layer)
+                    {
+                        std::memcpy(destinations[layer], source, destination_sizes[layer]);
+                        source += destination_sizes[layer];
+                    }
+                }
+                if(decompressed == false)
+                {
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+        });
+        if(failed.load())
+        {
+            layout = ImageLayout{};
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        Interface::FileLoader::ImageBuffer image_buffer{};
+        {
+            image_buffer.m_buffer = destination;
+            image_buffer.m_size = texture_buffer_size;
+
+            image_buffer.m_format = desc.m_format;
+
+            image_buffer.m_width = desc.m_width;
+            image_buffer.m_height = desc.m_height;
+            image_buffer.m_depth = desc.m_depth;
+            image_buffer.m_mip_map_count = layout.m_mip_map_count;
+        }
+        record.setResult(image_buffer);
+        return image_buffer;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "loaded_image.h"
+
+namespace Arieo
+{
+    LoadedImage::LoadedImage(PooledBuffer storage, const Interface::FileLoader::ImageBuffer& image_buffer, ImageLayout layout)
+        : m_storage(std::move(storage)),
+          m_image_buffer(image_buffer),
+          m_layout(std::move(layout))
+    {
+    }
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+#include "interface/file_loader/image_loader.h"
+#include "image_buffer_pool.h"
+#include "image_layout.h"
+#include <cstddef>
+#include <memory>
+namespace Arieo
+{
+    // A decoded image that owns its texels in a pooled buffer. Immutable once
+    // built, so any number of threads may read it through their handles; the
+    // buffer goes back to its pool when the last handle is dropped.
+    class LoadedImage
+    {
+    public:
+        LoadedImage(PooledBuffer storage, const Interface::FileLoader::ImageBuffer& image_buffer, ImageLayout layout);
+
+        const Interface::FileLoader::ImageBuffer& getImageBuffer() const { return m_image_buffer; }
+        const ImageLayout& getLayout() const { return m_layout; }
+
+        // Bytes charged against the cache budget.
+        size_t getMemorySize() const { return m_image_buffer.m_size; }
+
+    private:
+        PooledBuffer m_storage;
+        Interface::FileLoader::ImageBuffer m_image_buffer{};
+        ImageLayout m_layout;
+    };
+
+    using ImageHandle = std::shared_ptr<const LoadedImage>;
+}
\ No newline at end of file
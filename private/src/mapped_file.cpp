@@ -0,0 +1,176 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "mapped_file.h"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Arieo
+{
+    static size_t getPageSize()
+    {
+#if defined(_WIN32)
+        SYSTEM_INFO system_info;
+        GetSystemInfo(&system_info);
+        return system_info.dwPageSize;
+#else
+        return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+    }
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    bool MappedFile::open(const std::filesystem::path& path)
+    {
+        close();
+
+#if defined(_WIN32)
+        HANDLE file_handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+        if(file_handle == INVALID_HANDLE_VALUE)
+        {
+            Core::Logger::error("map file failed: cannot open {}", path.string());
+            return false;
+        }
+
+        LARGE_INTEGER file_size;
+        if(GetFileSizeEx(file_handle, &file_size) == FALSE || file_size.QuadPart == 0)
+        {
+            Core::Logger::error("map file failed: empty file {}", path.string());
+            CloseHandle(file_handle);
+            return false;
+        }
+
+        HANDLE mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(mapping_handle == nullptr)
+        {
+            Core::Logger::error("map file failed: cannot create mapping for {}", path.string());
+            CloseHandle(file_handle);
+            return false;
+        }
+
+        void* data = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+        if(data == nullptr)
+        {
+            Core::Logger::error("map file failed: cannot map view of {}", path.string());
+            CloseHandle(mapping_handle);
+            CloseHandle(file_handle);
+            return false;
+        }
+
+        m_file_handle = file_handle;
+        m_mapping_handle = mapping_handle;
+        m_data = data;
+        m_size = (size_t)file_size.QuadPart;
+#else
+        int file_descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(file_descriptor < 0)
+        {
+            Core::Logger::error("map file failed: cannot open {}", path.string());
+            return false;
+        }
+
+        struct stat file_stat;
+        if(fstat(file_descriptor, &file_stat) != 0 || file_stat.st_size == 0)
+        {
+            Core::Logger::error("map file failed: empty file {}", path.string());
+            ::close(file_descriptor);
+            return false;
+        }
+
+        void* data = mmap(nullptr, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+        // The mapping keeps its own reference to the file.
+        ::close(file_descriptor);
+        if(data == MAP_FAILED)
+        {
+            Core::Logger::error("map file failed: mmap of {} failed", path.string());
+            return false;
+        }
+
+        madvise(data, (size_t)file_stat.st_size, MADV_RANDOM);
+
+        m_data = data;
+        m_size = (size_t)file_stat.st_size;
+#endif
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if(m_data == nullptr)
+        {
+            return;
+        }
+
+#if defined(_WIN32)
+        UnmapViewOfFile(m_data);
+        CloseHandle((HANDLE)m_mapping_handle);
+        CloseHandle((HANDLE)m_file_handle);
+        m_mapping_handle = nullptr;
+        m_file_handle = nullptr;
+#else
+        munmap(m_data, m_size);
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    void MappedFile::prefetch(size_t offset, size_t size) const
+    {
+        if(m_data == nullptr || offset >= m_size || size == 0)
+        {
+            return;
+        }
+
+        size_t page_size = getPageSize();
+        size_t begin = offset & ~(page_size - 1);
+        size_t end = std::min(offset + size, m_size);
+
+#if defined(_WIN32)
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = (std::byte*)m_data + begin;
+        range.NumberOfBytes = end - begin;
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+        madvise((std::byte*)m_data + begin, end - begin, MADV_WILLNEED);
+#endif
+    }
+
+    void MappedFile::release(size_t offset, size_t size) const
+    {
+        if(m_data == nullptr || offset >= m_size || size == 0)
+        {
+            return;
+        }
+
+        // Only whole pages inside the range, neighbouring data must stay resident.
+        size_t page_size = getPageSize();
+        size_t begin = (offset + page_size - 1) & ~(page_size - 1);
+        size_t end = std::min(offset + size, m_size) & ~(page_size - 1);
+        if(end <= begin)
+        {
+            return;
+        }
+
+#if defined(_WIN32)
+        // Unlocking pages that are not locked removes them from the working set.
+        VirtualUnlock((std::byte*)m_data + begin, end - begin);
+#else
+        madvise((std::byte*)m_data + begin, end - begin, MADV_DONTNEED);
+#endif
+    }
+}
\ No newline at end of file
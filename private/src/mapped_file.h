@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+namespace Arieo
+{
+    // Read-only memory mapping of a whole file.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool open(const std::filesystem::path& path);
+        void close();
+
+        const void* getData() const { return m_data; }
+        size_t getSize() const { return m_size; }
+
+        // The mapping is opened with read-ahead disabled, so only pages that
+        // are touched or prefetched here get read from disk.
+        void prefetch(size_t offset, size_t size) const;
+
+        // Drops resident pages of a range; they are re-read on the next touch.
+        void release(size_t offset, size_t size) const;
+
+    private:
+        void* m_data = nullptr;
+        size_t m_size = 0;
+#if defined(_WIN32)
+        void* m_file_handle = nullptr;
+        void* m_mapping_handle = nullptr;
+#endif
+    };
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "mapped_image.h"
+#include "image_loader.h"
+
+#include <algorithm>
+
+namespace Arieo
+{
+    void MappedImage::prefetchMipLevels(std::uint32_t first_mip, std::uint32_t last_mip) const
+    {
+        if(m_layout.m_subresources.empty())
+        {
+            return;
+        }
+        last_mip = std::min(last_mip, m_layout.m_mip_map_count - 1);
+        if(first_mip > last_mip)
+        {
+            return;
+        }
+        for(std::uint32_t array_layer = 0; array_layer < m_layout.m_array_size; ++array_layer)
+        {
+            const ImageSubresource* first = m_layout.getSubresource(first_mip, array_layer);
+            const ImageSubresource* last = m_layout.getSubresource(last_mip, array_layer);
+            if(first == nullptr || last == nullptr)
+            {
+                continue;
+            }
+            // The mips of one layer are contiguous, so this is a single range per layer.
+            m_mapped_file.prefetch(m_data_offset + first->m_offset, last->m_offset + last->m_size - first->m_offset);
+        }
+    }
+
+    void MappedImage::releaseMipLevels(std::uint32_t first_mip, std::uint32_t last_mip) const
+    {
+        if(m_layout.m_subresources.empty())
+        {
+            return;
+        }
+        last_mip = std::min(last_mip, m_layout.m_mip_map_count - 1);
+        if(first_mip > last_mip)
+        {
+            return;
+        }
+        for(std::uint32_t array_layer = 0; array_layer < m_layout.m_array_size; ++array_layer)
+        {
+            const ImageSubresource* first = m_layout.getSubresource(first_mip, array_layer);
+            const ImageSubresource* last = m_layout.getSubresource(last_mip, array_layer);
+            if(first == nullptr || last == nullptr)
+            {
+                continue;
+            }
+            m_mapped_file.release(m_data_offset + first->m_offset, last->m_offset + last->m_size - first->m_offset);
+        }
+    }
+
+    std::shared_ptr<MappedImage> ImageLoader::loadDDSFile(const std::filesystem::path& path)
+    {
+        std::shared_ptr<MappedImage> mapped_image = std::make_shared<MappedImage>();
+        if(mapped_image->m_mapped_file.open(path) == false)
+        {
+            return nullptr;
+        }
+
+        // Parsing only touches the header page, texel pages stay on disk until used.
+        void* file_data = const_cast<void*>(mapped_image->m_mapped_file.getData());
+        mapped_image->m_image_buffer = loadDDS(file_data, mapped_image->m_mapped_file.getSize(), mapped_image->m_layout);
+        if(mapped_image->m_image_buffer.m_buffer == nullptr)
+        {
+            Core::Logger::error("dds file load failed: {}", path.string());
+            return nullptr;
+        }
+        mapped_image->m_data_offset = (std::byte*)mapped_image->m_image_buffer.m_buffer - (std::byte*)file_data;
+        return mapped_image;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include "interface/file_loader/image_loader.h"
+#include "image_layout.h"
+#include "mapped_file.h"
+#include <cstdint>
+namespace Arieo
+{
+    // A DDS file loaded through a memory mapping. m_image_buffer and every
+    // subresource point into the mapping, which is unmapped together with
+    // this object.
+    class MappedImage
+    {
+    public:
+        const Interface::FileLoader::ImageBuffer& getImageBuffer() const { return m_image_buffer; }
+        const ImageLayout& getLayout() const { return m_layout; }
+
+        // Asks the OS to page in [first_mip, last_mip] of every array layer ahead of use.
+        void prefetchMipLevels(std::uint32_t first_mip, std::uint32_t last_mip) const;
+
+        // Hands the pages of [first_mip, last_mip] back to the OS, e.g. once uploaded.
+        void releaseMipLevels(std::uint32_t first_mip, std::uint32_t last_mip) const;
+
+    private:
+        friend class ImageLoader;
+
+        MappedFile m_mapped_file;
+        Interface::FileLoader::ImageBuffer m_image_buffer{};
+        ImageLayout m_layout;
+        size_t m_data_offset = 0;
+    };
+}
\ No newline at end of file
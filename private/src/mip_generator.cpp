@@ -0,0 +1,564 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "mip_generator.h"
+#include "image_buffer_pool.h"
+#include "image_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Arieo
+{
+    enum class MipChannelType : std::uint32_t
+    {
+        UNORM8,
+        UNORM16,
+        FLOAT16,
+        FLOAT32
+    };
+
+    struct MipTexelFormat
+    {
+        MipChannelType m_channel_type = MipChannelType::UNORM8;
+        std::uint32_t m_channel_count = 0;
+        bool m_srgb = false;
+        bool m_swap_red_blue = false;
+    };
+
+    static bool getMipTexelFormat(Interface::RHI::Format format, MipTexelFormat& texel_format)
+    {
+        switch(format)
+        {
+        case Interface::RHI::Format::R8_UNORM: texel_format = {MipChannelType::UNORM8, 1, false, false}; return true;
+        case Interface::RHI::Format::R8G8_UNORM: texel_format = {MipChannelType::UNORM8, 2, false, false}; return true;
+        case Interface::RHI::Format::R8G8B8A8_UNORM: texel_format = {MipChannelType::UNORM8, 4, false, false}; return true;
+        case Interface::RHI::Format::B8G8R8A8_UNORM: texel_format = {MipChannelType::UNORM8, 4, false, true}; return true;
+        case Interface::RHI::Format::B8G8R8A8_SRGB: texel_format = {MipChannelType::UNORM8, 4, true, true}; return true;
+        case Interface::RHI::Format::R16_UNORM: texel_format = {MipChannelType::UNORM16, 1, false, false}; return true;
+        case Interface::RHI::Format::R16G16_UNORM: texel_format = {MipChannelType::UNORM16, 2, false, false}; return true;
+        case Interface::RHI::Format::R16G16B16A16_UNORM: texel_format = {MipChannelType::UNORM16, 4, false, false}; return true;
+        case Interface::RHI::Format::R16_SFLOAT: texel_format = {MipChannelType::FLOAT16, 1, false, false}; return true;
+        case Interface::RHI::Format::R16G16_SFLOAT: texel_format = {MipChannelType::FLOAT16, 2, false, false}; return true;
+        case Interface::RHI::Format::R16G16B16A16_SFLOAT: texel_format = {MipChannelType::FLOAT16, 4, false, false}; return true;
+        case Interface::RHI::Format::R32_SFLOAT: texel_format = {MipChannelType::FLOAT32, 1, false, false}; return true;
+        case Interface::RHI::Format::R32G32_SFLOAT: texel_format = {MipChannelType::FLOAT32, 2, false, false}; return true;
+        case Interface::RHI::Format::R32G32B32_SFLOAT: texel_format = {MipChannelType::FLOAT32, 3, false, false}; return true;
+        case Interface::RHI::Format::R32G32B32A32_SFLOAT: texel_format = {MipChannelType::FLOAT32, 4, false, false}; return true;
+        default: return false;
+        }
+    }
+
+    bool isMipGenerationSupported(Interface::RHI::Format format)
+    {
+        MipTexelFormat texel_format;
+        return getMipTexelFormat(format, texel_format);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Channel conversion
+
+    static float convertHalfToFloat(std::uint16_t half)
+    {
+        std::uint32_t sign = (std::uint32_t)(half & 0x8000) << 16;
+        std::uint32_t exponent = (half >> 10) & 0x1F;
+        std::uint32_t mantissa = half & 0x3FF;
+
+        float value;
+        if(exponent == 0)
+        {
+            value = std::ldexp((float)mantissa, -24);
+            return sign != 0 ? -value : value;
+        }
+
+        std::uint32_t bits = exponent == 31
+            ? sign | 0x7F800000 | (mantissa << 13)
+            : sign | ((exponent + 112) << 23) | (mantissa << 13);
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // Round to nearest even, overflow goes to infinity.
+    static std::uint16_t convertFloatToHalf(float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        std::uint32_t sign = (bits >> 16) & 0x8000;
+        std::uint32_t exponent = (bits >> 23) & 0xFF;
+        std::uint32_t mantissa = bits & 0x7FFFFF;
+
+        if(exponent == 255)
+        {
+            return (std::uint16_t)(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+        }
+
+        std::int32_t half_exponent = (std::int32_t)exponent - 127 + 15;
+        if(half_exponent >= 31)
+        {
+            return (std::uint16_t)(sign | 0x7C00);
+        }
+
+        std::uint32_t shift = 13;
+        std::uint32_t half;
+        if(half_exponent <= 0)
+        {
+            if(half_exponent < -10)
+            {
+                return (std::uint16_t)sign;
+            }
+            mantissa |= 0x800000;
+            shift = (std::uint32_t)(14 - half_exponent);
+            half = mantissa >> shift;
+        }
+        else
+        {
+            half = ((std::uint32_t)half_exponent << 10) | (mantissa >> 13);
+        }
+
+        std::uint32_t remainder = mantissa & ((1u << shift) - 1);
+        std::uint32_t halfway = 1u << (shift - 1);
+        if(remainder > halfway || (remainder == halfway && (half & 0x1) != 0))
+        {
+            // A carry out of the mantissa correctly bumps the exponent.
+            ++half;
+        }
+        return (std::uint16_t)(sign | half);
+    }
+
+    static float convertSrgbToLinear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    struct SrgbTables
+    {
+        float m_to_linear[256];
+        // Linear value at which the encoding steps from code k to k + 1,
+        // so that re-encoding rounds in sRGB space.
+        float m_thresholds[255];
+    };
+
+    static const SrgbTables& getSrgbTables()
+    {
+        static const SrgbTables tables = []()
+        {
+            SrgbTables result;
+            for(std::uint32_t code = 0; code < 256; ++code)
+            {
+                result.m_to_linear[code] = convertSrgbToLinear((float)code / 255.0f);
+            }
+            for(std::uint32_t code = 0; code < 255; ++code)
+            {
+                result.m_thresholds[code] = convertSrgbToLinear(((float)code + 0.5f) / 255.0f);
+            }
+            return result;
+        }();
+        return tables;
+    }
+
+    static std::uint8_t encodeSrgb(const SrgbTables& tables, float linear)
+    {
+        return (std::uint8_t)(std::upper_bound(tables.m_thresholds, tables.m_thresholds + 255, linear) - tables.m_thresholds);
+    }
+
+    static std::uint32_t quantizeUnorm(float value, float maximum)
+    {
+        return (std::uint32_t)(std::clamp(value, 0.0f, 1.0f) * maximum + 0.5f);
+    }
+
+    // Reads one row into linear RGBA floats; missing channels read as (0, 0, 1).
+    static void loadMipRow(const MipTexelFormat& texel_format, const MipGenerationOptions& options, const std::uint8_t* source, std::uint32_t width, float* destination)
+    {
+        const SrgbTables& srgb_tables = getSrgbTables();
+        bool linearize = texel_format.m_srgb && options.m_linearize_srgb;
+        bool premultiply = texel_format.m_channel_count == 4 && options.m_premultiply_alpha;
+
+        for(std::uint32_t x = 0; x < width; ++x)
+        {
+            float channels[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+            for(std::uint32_t channel = 0; channel < texel_format.m_channel_count; ++channel)
+            {
+                std::uint32_t index = x * texel_format.m_channel_count + channel;
+                switch(texel_format.m_channel_type)
+                {
+                case MipChannelType::UNORM8:
+                    channels[channel] = (linearize && channel < 3)
+                        ? srgb_tables.m_to_linear[source[index]]
+                        : (float)source[index] / 255.0f;
+                    break;
+                case MipChannelType::UNORM16:
+                {
+                    std::uint16_t value;
+                    std::memcpy(&value, source + index * sizeof(value), sizeof(value));
+                    channels[channel] = (float)value / 65535.0f;
+                    break;
+                }
+                case MipChannelType::FLOAT16:
+                {
+                    std::uint16_t value;
+                    std::memcpy(&value, source + index * sizeof(value), sizeof(value));
+                    channels[channel] = convertHalfToFloat(value);
+                    break;
+                }
+                case MipChannelType::FLOAT32:
+                    std::memcpy(&channels[channel], source + index * sizeof(float), sizeof(float));
+                    break;
+                }
+            }
+            if(texel_format.m_swap_red_blue)
+            {
+                std::swap(channels[0], channels[2]);
+            }
+            if(premultiply)
+            {
+                channels[0] *= channels[3];
+                channels[1] *= channels[3];
+                channels[2] *= channels[3];
+            }
+            std::memcpy(destination + x * 4, channels, sizeof(channels));
+        }
+    }
+
+    static void storeMipRow(const MipTexelFormat& texel_format, const MipGenerationOptions& options, const float* source, std::uint32_t width, std::uint8_t* destination)
+    {
+        const SrgbTables& srgb_tables = getSrgbTables();
+        bool encode_srgb = texel_format.m_srgb && options.m_linearize_srgb;
+        bool premultiply = texel_format.m_channel_count == 4 && options.m_premultiply_alpha;
+        bool is_unorm = texel_format.m_channel_type == MipChannelType::UNORM8 || texel_format.m_channel_type == MipChannelType::UNORM16;
+
+        for(std::uint32_t x = 0; x < width; ++x)
+        {
+            float channels[4];
+            std::memcpy(channels, source + x * 4, sizeof(channels));
+            if(premultiply)
+            {
+                // Sharpening filters can overshoot, clamp before dividing.
+                float alpha = is_unorm ? std::clamp(channels[3], 0.0f, 1.0f) : channels[3];
+                float scale = alpha > 0.0f ? 1.0f / alpha : 0.0f;
+                channels[0] *= scale;
+                channels[1] *= scale;
+                channels[2] *= scale;
+            }
+            if(texel_format.m_swap_red_blue)
+            {
+                std::swap(channels[0], channels[2]);
+            }
+
+            for(std::uint32_t channel = 0; channel < texel_format.m_channel_count; ++channel)
+            {
+                std::uint32_t index = x * texel_format.m_channel_count + channel;
+                switch(texel_format.m_channel_type)
+                {
+                case MipChannelType::UNORM8:
+                    destination[index] = (encode_srgb && channel < 3)
+                        ? encodeSrgb(srgb_tables, channels[channel])
+                        : (std::uint8_t)quantizeUnorm(channels[channel], 255.0f);
+                    break;
+                case MipChannelType::UNORM16:
+                {
+                    std::uint16_t value = (std::uint16_t)quantizeUnorm(channels[channel], 65535.0f);
+                    std::memcpy(destination + index * sizeof(value), &value, sizeof(value));
+                    break;
+                }
+                case MipChannelType::FLOAT16:
+                {
+                    std::uint16_t value = convertFloatToHalf(channels[channel]);
+                    std::memcpy(destination + index * sizeof(value), &value, sizeof(value));
+                    break;
+                }
+                case MipChannelType::FLOAT32:
+                    std::memcpy(destination + index * sizeof(float), &channels[channel], sizeof(float));
+                    break;
+                }
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Filter weights
+
+    static const float g_mip_filter_radius = 3.0f;
+    static const float g_mip_kaiser_alpha = 4.0f;
+    static const float g_pi = 3.14159265358979f;
+
+    static float computeSinc(float x)
+    {
+        if(std::fabs(x) < 1e-6f)
+        {
+            return 1.0f;
+        }
+        x *= g_pi;
+        return std::sin(x) / x;
+    }
+
+    // Zeroth order modified Bessel function of the first kind.
+    static float computeBesselI0(float x)
+    {
+        float sum = 1.0f;
+        float term = 1.0f;
+        float half_x = x * 0.5f;
+        for(std::uint32_t k = 1; k < 20; ++k)
+        {
+            term *= (half_x / (float)k) * (half_x / (float)k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    // x is in destination texels.
+    static float evaluateMipKernel(MipFilter filter, float x)
+    {
+        if(std::fabs(x) >= g_mip_filter_radius)
+        {
+            return 0.0f;
+        }
+        switch(filter)
+        {
+        case MipFilter::LANCZOS:
+            return computeSinc(x) * computeSinc(x / g_mip_filter_radius);
+        case MipFilter::KAISER:
+        {
+            float t = x / g_mip_filter_radius;
+            return computeSinc(x) * computeBesselI0(g_mip_kaiser_alpha * std::sqrt(1.0f - t * t)) / computeBesselI0(g_mip_kaiser_alpha);
+        }
+        default:
+            return 0.0f;
+        }
+    }
+
+    MipAxisFilter buildMipAxisFilter(MipFilter filter, std::uint32_t source_extent, std::uint32_t destination_extent)
+    {
+        MipAxisFilter axis_filter;
+        if(source_extent == destination_extent)
+        {
+            axis_filter.m_tap_count = 1;
+            for(std::uint32_t index = 0; index < destination_extent; ++index)
+            {
+                axis_filter.m_indices.emplace_back(index);
+                axis_filter.m_weights.emplace_back(1.0f);
+            }
+            return axis_filter;
+        }
+
+        float scale = (float)source_extent / (float)destination_extent;
+        std::vector<std::vector<std::pair<std::uint32_t, float>>> taps(destination_extent);
+        for(std::uint32_t index = 0; index < destination_extent; ++index)
+        {
+            if(filter == MipFilter::BOX)
+            {
+                // Overlap of each source texel with the destination texel footprint.
+                float begin = (float)index * scale;
+                float end = (float)(index + 1) * scale;
+                for(std::int32_t source = (std::int32_t)std::floor(begin); (float)source < end; ++source)
+                {
+                    float weight = std::min((float)(source + 1), end) - std::max((float)source, begin);
+                    if(weight > 0.0f)
+                    {
+                        taps[index].emplace_back(std::min<std::uint32_t>(source, source_extent - 1), weight);
+                    }
+                }
+            }
+            else
+            {
+                float center = ((float)index + 0.5f) * scale;
+                float radius = g_mip_filter_radius * scale;
+                std::int32_t first = (std::int32_t)std::floor(center - radius);
+                std::int32_t last = (std::int32_t)std::ceil(center + radius);
+                for(std::int32_t source = first; source <= last; ++source)
+                {
+                    float weight = evaluateMipKernel(filter, ((float)source + 0.5f - center) / scale);
+                    if(weight != 0.0f)
+                    {
+                        // Clamp to edge; repeated edge texels simply add up.
+                        taps[index].emplace_back((std::uint32_t)std::clamp<std::int32_t>(source, 0, (std::int32_t)source_extent - 1), weight);
+                    }
+                }
+            }
+
+            float sum = 0.0f;
+            for(const auto& tap : taps[index])
+            {
+                sum += tap.second;
+            }
+            for(auto& tap : taps[index])
+            {
+                tap.second /= sum;
+            }
+            axis_filter.m_tap_count = std::max<std::uint32_t>(axis_filter.m_tap_count, (std::uint32_t)taps[index].size());
+        }
+
+        axis_filter.m_indices.resize(destination_extent * axis_filter.m_tap_count, 0);
+        axis_filter.m_weights.resize(destination_extent * axis_filter.m_tap_count, 0.0f);
+        for(std::uint32_t index = 0; index < destination_extent; ++index)
+        {
+            for(size_t tap = 0; tap < taps[index].size(); ++tap)
+            {
+                axis_filter.m_indices[index * axis_filter.m_tap_count + tap] = taps[index][tap].first;
+                axis_filter.m_weights[index * axis_filter.m_tap_count + tap] = taps[index][tap].second;
+            }
+        }
+        return axis_filter;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Scalar kernels
+
+    static void accumulateMipRowScalar(float* accumulator, const float* row, float weight, std::uint32_t texel_count)
+    {
+        for(std::uint32_t index = 0; index < texel_count * 4; ++index)
+        {
+            accumulator[index] += weight * row[index];
+        }
+    }
+
+    static void filterMipRowScalar(const float* row, const MipAxisFilter& filter, float* destination, std::uint32_t destination_width)
+    {
+        for(std::uint32_t x = 0; x < destination_width; ++x)
+        {
+            float sum[4] = {};
+            for(std::uint32_t tap = 0; tap < filter.m_tap_count; ++tap)
+            {
+                float weight = filter.m_weights[x * filter.m_tap_count + tap];
+                const float* texel = row + filter.m_indices[x * filter.m_tap_count + tap] * 4;
+                for(std::uint32_t channel = 0; channel < 4; ++channel)
+                {
+                    sum[channel] += weight * texel[channel];
+                }
+            }
+            std::memcpy(destination + x * 4, sum, sizeof(sum));
+        }
+    }
+
+    static void boxMipRowScalar(const float* row0, const float* row1, float* destination, std::uint32_t destination_width)
+    {
+        for(std::uint32_t x = 0; x < destination_width; ++x)
+        {
+            for(std::uint32_t channel = 0; channel < 4; ++channel)
+            {
+                destination[x * 4 + channel] = ((row0[x * 8 + channel] + row0[x * 8 + 4 + channel]) + (row1[x * 8 + channel] + row1[x * 8 + 4 + channel])) * 0.25f;
+            }
+        }
+    }
+
+    const MipFilterKernels& getScalarMipFilterKernels()
+    {
+        static const MipFilterKernels kernels =
+        {
+            accumulateMipRowScalar,
+            filterMipRowScalar,
+            boxMipRowScalar,
+        };
+        return kernels;
+    }
+
+    const MipFilterKernels& getMipFilterKernels(SimdLevel simd_level)
+    {
+#if ARIEO_IMAGE_LOADER_X86
+        static const MipFilterKernels sse41_kernels = []()
+        {
+            MipFilterKernels kernels = getScalarMipFilterKernels();
+            fillSSE41MipFilterKernels(kernels);
+            return kernels;
+        }();
+
+        if(simd_level != SimdLevel::SCALAR)
+        {
+            return sse41_kernels;
+        }
+#endif
+        return getScalarMipFilterKernels();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+
+    void generateMipRows(
+        Interface::RHI::Format format,
+        const MipGenerationOptions& options,
+        SimdLevel simd_level,
+        const MipAxisFilter& filter_x,
+        const MipAxisFilter& filter_y,
+        const MipAxisFilter& filter_z,
+        const void* source,
+        size_t source_row_pitch,
+        size_t source_slice_pitch,
+        std::uint32_t source_width,
+        void* destination,
+        size_t destination_row_pitch,
+        size_t destination_slice_pitch,
+        std::uint32_t destination_width,
+        std::uint32_t destination_slice,
+        std::uint32_t first_row,
+        std::uint32_t row_count)
+    {
+        MipTexelFormat texel_format;
+        if(getMipTexelFormat(format, texel_format) == false)
+        {
+            return;
+        }
+
+        // Row buffers come from the worker's scratch arena, which keeps them warm across jobs.
+        const MipFilterKernels& kernels = getMipFilterKernels(simd_level);
+        ScratchScope scratch;
+        float* source_row = scratch.getArena().allocateArray<float>(source_width * 4);
+        float* destination_row = scratch.getArena().allocateArray<float>(destination_width * 4);
+        if(source_row == nullptr || destination_row == nullptr)
+        {
+            return;
+        }
+        std::uint8_t* destination_slice_data = (std::uint8_t*)destination + destination_slice * destination_slice_pitch;
+
+        // Exact 2:1 box in x and y within one slice: two source rows per destination row.
+        bool is_box_2x2 = options.m_filter == MipFilter::BOX
+            && filter_x.m_tap_count == 2
+            && filter_y.m_tap_count == 2
+            && filter_z.m_tap_count == 1
+            && source_width == destination_width * 2;
+
+        if(is_box_2x2)
+        {
+            float* second_row = scratch.getArena().allocateArray<float>(source_width * 4);
+            if(second_row == nullptr)
+            {
+                return;
+            }
+            const std::uint8_t* source_slice_data = (const std::uint8_t*)source + filter_z.m_indices[destination_slice] * source_slice_pitch;
+            for(std::uint32_t y = first_row; y < first_row + row_count; ++y)
+            {
+                loadMipRow(texel_format, options, source_slice_data + (y * 2) * source_row_pitch, source_width, source_row);
+                loadMipRow(texel_format, options, source_slice_data + (y * 2 + 1) * source_row_pitch, source_width, second_row);
+                kernels.m_box_row(source_row, second_row, destination_row, destination_width);
+                storeMipRow(texel_format, options, destination_row, destination_width, destination_slice_data + y * destination_row_pitch);
+            }
+            return;
+        }
+
+        float* accumulator = scratch.getArena().allocateArray<float>(source_width * 4);
+        if(accumulator == nullptr)
+        {
+            return;
+        }
+        for(std::uint32_t y = first_row; y < first_row + row_count; ++y)
+        {
+            // Vertical (and depth) pass into one source width row, then horizontal.
+            std::fill(accumulator, accumulator + source_width * 4, 0.0f);
+            for(std::uint32_t tap_z = 0; tap_z < filter_z.m_tap_count; ++tap_z)
+            {
+                float weight_z = filter_z.m_weights[destination_slice * filter_z.m_tap_count + tap_z];
+                const std::uint8_t* source_slice_data = (const std::uint8_t*)source + filter_z.m_indices[destination_slice * filter_z.m_tap_count + tap_z] * source_slice_pitch;
+                for(std::uint32_t tap_y = 0; tap_y < filter_y.m_tap_count; ++tap_y)
+                {
+                    float weight = weight_z * filter_y.m_weights[y * filter_y.m_tap_count + tap_y];
+                    if(weight == 0.0f)
+                    {
+                        continue;
+                    }
+                    loadMipRow(texel_format, options, source_slice_data + filter_y.m_indices[y * filter_y.m_tap_count + tap_y] * source_row_pitch, source_width, source_row);
+                    kernels.m_accumulate_row(accumulator, source_row, weight, source_width);
+                }
+            }
+            kernels.m_filter_row(accumulator, filter_x, destination_row, destination_width);
+            storeMipRow(texel_format, options, destination_row, destination_width, destination_slice_data + y * destination_row_pitch);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include "interface/file_loader/image_loader.h"
+#include "cpu_features.h"
+#include <cstdint>
+#include <vector>
+namespace Arieo
+{
+    enum class MipFilter : std::uint32_t
+    {
+        // Area weighted average, an exact 2x2 box for even extents.
+        BOX,
+        // Kaiser windowed sinc, radius 3, alpha 4.
+        KAISER,
+        // Lanczos windowed sinc, radius 3.
+        LANCZOS
+    };
+
+    struct MipGenerationOptions
+    {
+        MipFilter m_filter = MipFilter::BOX;
+
+        // Filter sRGB formats in linear space and re-encode afterwards.
+        bool m_linearize_srgb = true;
+
+        // Weight colour by alpha while filtering so that the colour of fully
+        // transparent texels does not bleed into their neighbours. Results are
+        // stored with straight alpha again.
+        bool m_premultiply_alpha = true;
+    };
+
+    // Source texels and weights of every destination texel along one axis;
+    // each destination texel has m_tap_count entries, unused ones weigh 0.
+    struct MipAxisFilter
+    {
+        std::uint32_t m_tap_count = 0;
+        std::vector<std::uint32_t> m_indices;
+        std::vector<float> m_weights;
+    };
+
+    MipAxisFilter buildMipAxisFilter(MipFilter filter, std::uint32_t source_extent, std::uint32_t destination_extent);
+
+    // Row kernels on linear RGBA float texels.
+    struct MipFilterKernels
+    {
+        // accumulator[i] += weight * row[i] over texel_count RGBA texels.
+        void (*m_accumulate_row)(float* accumulator, const float* row, float weight, std::uint32_t texel_count) = nullptr;
+        // Horizontal pass of the separable filter.
+        void (*m_filter_row)(const float* row, const MipAxisFilter& filter, float* destination, std::uint32_t destination_width) = nullptr;
+        // destination[i] = average of row0[2i], row0[2i + 1], row1[2i], row1[2i + 1].
+        void (*m_box_row)(const float* row0, const float* row1, float* destination, std::uint32_t destination_width) = nullptr;
+    };
+
+    const MipFilterKernels& getScalarMipFilterKernels();
+#if ARIEO_IMAGE_LOADER_X86
+    void fillSSE41MipFilterKernels(MipFilterKernels& kernels);
+#endif
+    const MipFilterKernels& getMipFilterKernels(SimdLevel simd_level);
+
+    // True for the uncompressed 8, 16 and 32 bit per channel UNORM, sRGB and
+    // float formats the generator can read and write.
+    bool isMipGenerationSupported(Interface::RHI::Format format);
+
+    // Filters rows [first_row, first_row + row_count) of slice destination_slice
+    // of the next mip level. source and destination point at the start of their
+    // subresources; the source is read in its own format.
+    void generateMipRows(
+        Interface::RHI::Format format,
+        const MipGenerationOptions& options,
+        SimdLevel simd_level,
+        const MipAxisFilter& filter_x,
+        const MipAxisFilter& filter_y,
+        const MipAxisFilter& filter_z,
+        const void* source,
+        size_t source_row_pitch,
+        size_t source_slice_pitch,
+        std::uint32_t source_width,
+        void* destination,
+        size_t destination_row_pitch,
+        size_t destination_slice_pitch,
+        std::uint32_t destination_width,
+        std::uint32_t destination_slice,
+        std::uint32_t first_row,
+        std::uint32_t row_count
+    );
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "mip_generator.h"
+
+#if ARIEO_IMAGE_LOADER_X86
+#include <immintrin.h>
+
+// Texels are RGBA floats, so one texel is one SSE register and every kernel
+// works texel by texel.
+
+namespace Arieo
+{
+    ARIEO_TARGET_SSE41 static void accumulateMipRowSSE41(float* accumulator, const float* row, float weight, std::uint32_t texel_count)
+    {
+        __m128 weight_vector = _mm_set1_ps(weight);
+        for(std::uint32_t x = 0; x < texel_count; ++x)
+        {
+            __m128 sum = _mm_add_ps(_mm_loadu_ps(accumulator + x * 4), _mm_mul_ps(weight_vector, _mm_loadu_ps(row + x * 4)));
+            _mm_storeu_ps(accumulator + x * 4, sum);
+        }
+    }
+
+    ARIEO_TARGET_SSE41 static void filterMipRowSSE41(const float* row, const MipAxisFilter& filter, float* destination, std::uint32_t destination_width)
+    {
+        const std::uint32_t* indices = filter.m_indices.data();
+        const float* weights = filter.m_weights.data();
+        for(std::uint32_t x = 0; x < destination_width; ++x)
+        {
+            __m128 sum = _mm_setzero_ps();
+            for(std::uint32_t tap = 0; tap < filter.m_tap_count; ++tap)
+            {
+                std::uint32_t index = x * filter.m_tap_count + tap;
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[index]), _mm_loadu_ps(row + indices[index] * 4)));
+            }
+            _mm_storeu_ps(destination + x * 4, sum);
+        }
+    }
+
+    ARIEO_TARGET_SSE41 static void boxMipRowSSE41(const float* row0, const float* row1, float* destination, std::uint32_t destination_width)
+    {
+        const __m128 quarter = _mm_set1_ps(0.25f);
+        for(std::uint32_t x = 0; x < destination_width; ++x)
+        {
+            __m128 top = _mm_add_ps(_mm_loadu_ps(row0 + x * 8), _mm_loadu_ps(row0 + x * 8 + 4));
+            __m128 bottom = _mm_add_ps(_mm_loadu_ps(row1 + x * 8), _mm_loadu_ps(row1 + x * 8 + 4));
+            _mm_storeu_ps(destination + x * 4, _mm_mul_ps(_mm_add_ps(top, bottom), quarter));
+        }
+    }
+
+    void fillSSE41MipFilterKernels(MipFilterKernels& kernels)
+    {
+        kernels.m_accumulate_row = accumulateMipRowSSE41;
+        kernels.m_filter_row = filterMipRowSSE41;
+        kernels.m_box_row = boxMipRowSSE41;
+    }
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "image_loader.h"
+#include "image_metrics.h"
+
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+namespace Arieo
+{
+    // stb allocates its output with STBI_MALLOC. While a decode is running we
+    // hand out the caller's destination for the first allocation that has
+    // the output size, so the pixels are written in place instead of being
+    // copied out of a stb owned buffer afterwards. The JPEG decoder asks for
+    // one byte more than it writes (stbi__malloc_mad3(n, x, y, 1)), which
+    // m_slack allows for; other decoders get an exact match only, PNG for
+    // one has a zlib buffer of output size plus one for single row images.
+    struct StbDestination
+    {
+        void* m_buffer = nullptr;
+        size_t m_size = 0;
+        size_t m_slack = 0;
+        bool m_handed_out = false;
+    };
+    static thread_local StbDestination t_stb_destination;
+
+    static void* stbMalloc(size_t size)
+    {
+        StbDestination& destination = t_stb_destination;
+        if(destination.m_buffer != nullptr
+            && destination.m_handed_out == false
+            && size >= destination.m_size
+            && size - destination.m_size <= destination.m_slack)
+        {
+            destination.m_handed_out = true;
+            return destination.m_buffer;
+        }
+        return std::malloc(size);
+    }
+
+    static void stbFree(void* ptr)
+    {
+        if(ptr != nullptr && ptr == t_stb_destination.m_buffer)
+        {
+            return;
+        }
+        std::free(ptr);
+    }
+
+    static void* stbRealloc(void* ptr, size_t size)
+    {
+        StbDestination& destination = t_stb_destination;
+        if(ptr != nullptr && ptr == destination.m_buffer)
+        {
+            if(size <= destination.m_size)
+            {
+                return ptr;
+            }
+            // Grown past the destination, continue on the heap and copy back at the end.
+            void* new_ptr = std::malloc(size);
+            if(new_ptr != nullptr)
+            {
+                std::memcpy(new_ptr, ptr, destination.m_size);
+            }
+            return new_ptr;
+        }
+        return std::realloc(ptr, size);
+    }
+}
+
+#define STBI_MALLOC(size) Arieo::stbMalloc(size)
+#define STBI_REALLOC(ptr, size) Arieo::stbRealloc(ptr, size)
+#define STBI_FREE(ptr) Arieo::stbFree(ptr)
+
+#define STBI_ONLY_PNG
+#define STBI_ONLY_JPEG
+#define STBI_ONLY_TGA
+#define STBI_ONLY_BMP
+#define STBI_ONLY_HDR
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+namespace Arieo
+{
+    static Interface::RHI::Format getStbOutputFormat(int channels, bool is_hdr, bool is_16_bit)
+    {
+        // Three channel images are widened to four, the RHI has no tightly packed RGB formats.
+        if(is_hdr)
+        {
+            switch(channels)
+            {
+            case 1: return Interface::RHI::Format::R32_SFLOAT;
+            case 2: return Interface::RHI::Format::R32G32_SFLOAT;
+            default: return Interface::RHI::Format::R32G32B32A32_SFLOAT;
+            }
+        }
+        if(is_16_bit)
+        {
+            switch(channels)
+            {
+            case 1: return Interface::RHI::Format::R16_UNORM;
+            case 2: return Interface::RHI::Format::R16G16_UNORM;
+            default: return Interface::RHI::Format::R16G16B16A16_UNORM;
+            }
+        }
+        switch(channels)
+        {
+        case 1: return Interface::RHI::Format::R8_UNORM;
+        case 2: return Interface::RHI::Format::R8G8_UNORM;
+        default: return Interface::RHI::Format::R8G8B8A8_UNORM;
+        }
+    }
+
+    bool ImageLoader::queryImageInfo(const void* buffer, size_t size, ImageInfo& info)
+    {
+        if(buffer == nullptr || size == 0 || size > INT_MAX)
+        {
+            Core::Logger::error("image query failed: invalid buffer");
+            return false;
+        }
+
+        const stbi_uc* stb_buffer = (const stbi_uc*)buffer;
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        if(stbi_info_from_memory(stb_buffer, (int)size, &width, &height, &channels) == 0)
+        {
+            Core::Logger::error("image query failed: {}", stbi_failure_reason());
+            return false;
+        }
+
+        bool is_hdr = stbi_is_hdr_from_memory(stb_buffer, (int)size) != 0;
+        bool is_16_bit = is_hdr == false && stbi_is_16_bit_from_memory(stb_buffer, (int)size) != 0;
+
+        info.m_channels = channels == 3 ? 4 : (std::uint32_t)channels;
+        info.m_format = getStbOutputFormat(channels, is_hdr, is_16_bit);
+        info.m_width = (std::uint32_t)width;
+        info.m_height = (std::uint32_t)height;
+
+        size_t channel_size = is_hdr ? sizeof(float) : (is_16_bit ? sizeof(std::uint16_t) : sizeof(std::uint8_t));
+        info.m_size = size_t(info.m_width) * info.m_height * info.m_channels * channel_size;
+        return true;
+    }
+
+    static bool isJpegData(const void* buffer, size_t size)
+    {
+        const std::uint8_t* bytes = (const std::uint8_t*)buffer;
+        return size >= 2 && bytes[0] == 0xFF && bytes[1] == 0xD8;
+    }
+
+    static Interface::FileLoader::ImageBuffer decodeStbImage(const void* buffer, size_t size, const ImageInfo& info, void* destination)
+    {
+        ImageStageTimer timer(ImageLoadStage::DECODE);
+        t_stb_destination = StbDestination{destination, info.m_size, isJpegData(buffer, size) ? (size_t)1 : 0, false};
+
+        const stbi_uc* stb_buffer = (const stbi_uc*)buffer;
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        void* decoded = nullptr;
+        switch(info.m_format)
+        {
+        case Interface::RHI::Format::R32_SFLOAT:
+        case Interface::RHI::Format::R32G32_SFLOAT:
+        case Interface::RHI::Format::R32G32B32A32_SFLOAT:
+            decoded = stbi_loadf_from_memory(stb_buffer, (int)size, &width, &height, &channels, (int)info.m_channels);
+            break;
+        case Interface::RHI::Format::R16_UNORM:
+        case Interface::RHI::Format::R16G16_UNORM:
+        case Interface::RHI::Format::R16G16B16A16_UNORM:
+            decoded = stbi_load_16_from_memory(stb_buffer, (int)size, &width, &height, &channels, (int)info.m_channels);
+            break;
+        default:
+            decoded = stbi_load_from_memory(stb_buffer, (int)size, &width, &height, &channels, (int)info.m_channels);
+            break;
+        }
+
+        t_stb_destination = StbDestination{};
+
+        if(decoded == nullptr)
+        {
+            Core::Logger::error("image load failed: {}", stbi_failure_reason());
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        if(decoded != destination)
+        {
+            // stb took an intermediate path, the result did not land in place.
+            std::memcpy(destination, decoded, info.m_size);
+            stbi_image_free(decoded);
+        }
+
+        Interface::FileLoader::ImageBuffer image_buffer{};
+        {
+            image_buffer.m_buffer = destination;
+            image_buffer.m_size = info.m_size;
+
+            image_buffer.m_format = info.m_format;
+
+            image_buffer.m_width = info.m_width;
+            image_buffer.m_height = info.m_height;
+            image_buffer.m_depth = 1;
+            image_buffer.m_mip_map_count = 1;
+        }
+        return image_buffer;
+    }
+
+    Interface::FileLoader::ImageBuffer ImageLoader::loadImage(const void* buffer, size_t size, void* destination, size_t destination_size)
+    {
+        ImageLoadRecord record(ImageContainer::STB, size);
+        ImageInfo info;
+        bool is_info_valid = false;
+        {
+            ImageStageTimer timer(ImageLoadStage::PARSE_HEADER);
+            is_info_valid = queryImageInfo(buffer, size, info);
+        }
+        if(is_info_valid == false)
+        {
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        if(destination == nullptr || destination_size < info.m_size)
+        {
+            Core::Logger::error("image load failed: destination needs {} bytes, got {}", info.m_size, destination_size);
+            return Interface::FileLoader::ImageBuffer{};
+        }
+        Interface::FileLoader::ImageBuffer image_buffer = decodeStbImage(buffer, size, info, destination);
+        record.setResult(image_buffer);
+        return image_buffer;
+    }
+
+    Interface::FileLoader::ImageBuffer ImageLoader::loadImage(const void* buffer, size_t size, const ImageAllocator& allocator)
+    {
+        ImageLoadRecord record(ImageContainer::STB, size);
+        ImageInfo info;
+        bool is_info_valid = false;
+        {
+            ImageStageTimer timer(ImageLoadStage::PARSE_HEADER);
+            is_info_valid = queryImageInfo(buffer, size, info);
+        }
+        if(is_info_valid == false)
+        {
+            return Interface::FileLoader::ImageBuffer{};
+        }
+
+        void* destination = nullptr;
+        {
+            ImageStageTimer timer(ImageLoadStage::ALLOCATE);
+            destination = allocator(info.m_size);
+        }
+        if(destination == nullptr)
+        {
+            Core::Logger::error("image load failed: allocator returned null for {} bytes", info.m_size);
+            return Interface::FileLoader::ImageBuffer{};
+        }
+        Interface::FileLoader::ImageBuffer image_buffer = decodeStbImage(buffer, size, info, destination);
+        record.setResult(image_buffer);
+        return image_buffer;
+    }
+}
\ No newline at end of file
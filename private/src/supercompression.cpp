@@ -0,0 +1,175 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "supercompression.h"
+
+#include <lz4.h>
+#include <lz4hc.h>
+#include <zstd.h>
+
+#include <cstring>
+#include <memory>
+
+namespace Arieo
+{
+    struct ZstdContextDeleter
+    {
+        void operator()(ZSTD_DCtx* context) const { ZSTD_freeDCtx(context); }
+    };
+
+    // Creating a context allocates its window buffers, reuse one per worker.
+    static ZSTD_DCtx* getThreadZstdContext()
+    {
+        thread_local std::unique_ptr<ZSTD_DCtx, ZstdContextDeleter> context(ZSTD_createDCtx());
+        return context.get();
+    }
+
+    bool decompressBlock(Supercompression scheme, const void* source, size_t source_size, void* destination, size_t destination_size)
+    {
+        switch(scheme)
+        {
+        case Supercompression::NONE:
+            if(source_size != destination_size)
+            {
+                Core::Logger::error("decompress failed: stored block has {} bytes, expected {}", source_size, destination_size);
+                return false;
+            }
+            std::memcpy(destination, source, destination_size);
+            return true;
+        case Supercompression::LZ4:
+        {
+            if(source_size > (size_t)LZ4_MAX_INPUT_SIZE || destination_size > (size_t)LZ4_MAX_INPUT_SIZE)
+            {
+                Core::Logger::error("decompress failed: lz4 block of {} bytes too large", destination_size);
+                return false;
+            }
+            int result = LZ4_decompress_safe((const char*)source, (char*)destination, (int)source_size, (int)destination_size);
+            if(result != (int)destination_size)
+            {
+                Core::Logger::error("decompress failed: lz4 block corrupt or {} bytes instead of {}", result, destination_size);
+                return false;
+            }
+            return true;
+        }
+        case Supercompression::ZSTD:
+        {
+            ZSTD_DCtx* context = getThreadZstdContext();
+            size_t result = context != nullptr
+                ? ZSTD_decompressDCtx(context, destination, destination_size, source, source_size)
+                : ZSTD_decompress(destination, destination_size, source, source_size);
+            if(ZSTD_isError(result) || result != destination_size)
+            {
+                Core::Logger::error("decompress failed: zstd frame corrupt or wrong size, {}", ZSTD_isError(result) ? ZSTD_getErrorName(result) : "size mismatch");
+                return false;
+            }
+            return true;
+        }
+        default:
+            Core::Logger::error("decompress failed: unknown scheme {}", (std::uint32_t)scheme);
+            return false;
+        }
+    }
+
+    bool decompressZstdFrame(const void* source, size_t source_size, void* const* destinations, const size_t* destination_sizes, size_t destination_count)
+    {
+        ZSTD_DCtx* context = getThreadZstdContext();
+        if(context == nullptr)
+        {
+            Core::Logger::error("decompress failed: cannot create zstd context");
+            return false;
+        }
+        ZSTD_DCtx_reset(context, ZSTD_reset_session_only);
+
+        // Without a stable output buffer zstd keeps its window internally, so
+        // the output may move to the next destination between calls.
+        ZSTD_inBuffer input{source, source_size, 0};
+        size_t result = 1;
+        for(size_t index = 0; index < destination_count; ++index)
+        {
+            ZSTD_outBuffer output{destinations[index], destination_sizes[index], 0};
+            while(output.pos < output.size)
+            {
+                size_t input_position = input.pos;
+                size_t output_position = output.pos;
+                result = ZSTD_decompressStream(context, &output, &input);
+                if(ZSTD_isError(result))
+                {
+                    Core::Logger::error("decompress failed: zstd frame corrupt, {}", ZSTD_getErrorName(result));
+                    return false;
+                }
+                if(output.pos < output.size && (result == 0 || (input.pos == input_position && output.pos == output_position)))
+                {
+                    Core::Logger::error("decompress failed: zstd frame shorter than its images");
+                    return false;
+                }
+            }
+        }
+
+        // The last image can fill up before the frame epilogue was read.
+        ZSTD_outBuffer no_output{nullptr, 0, 0};
+        while(result != 0 && ZSTD_isError(result) == false && input.pos < input.size)
+        {
+            size_t input_position = input.pos;
+            result = ZSTD_decompressStream(context, &no_output, &input);
+            if(input.pos == input_position)
+            {
+                break;
+            }
+        }
+        if(result != 0 || input.pos != input.size)
+        {
+            Core::Logger::error("decompress failed: zstd frame longer than its images");
+            return false;
+        }
+        return true;
+    }
+
+    bool compressBlock(Supercompression scheme, int level, const void* source, size_t source_size, std::vector<std::byte>& output)
+    {
+        size_t output_offset = output.size();
+        switch(scheme)
+        {
+        case Supercompression::NONE:
+            output.insert(output.end(), (const std::byte*)source, (const std::byte*)source + source_size);
+            return true;
+        case Supercompression::LZ4:
+        {
+            if(source_size > (size_t)LZ4_MAX_INPUT_SIZE)
+            {
+                Core::Logger::error("compress failed: {} bytes too large for a lz4 block", source_size);
+                return false;
+            }
+            output.resize(output_offset + LZ4_compressBound((int)source_size));
+            char* destination = (char*)output.data() + output_offset;
+            int capacity = (int)(output.size() - output_offset);
+            int result = level > 0
+                ? LZ4_compress_HC((const char*)source, destination, (int)source_size, capacity, level)
+                : LZ4_compress_default((const char*)source, destination, (int)source_size, capacity);
+            if(result <= 0 && source_size != 0)
+            {
+                Core::Logger::error("compress failed: lz4 error");
+                output.resize(output_offset);
+                return false;
+            }
+            output.resize(output_offset + result);
+            return true;
+        }
+        case Supercompression::ZSTD:
+        {
+            output.resize(output_offset + ZSTD_compressBound(source_size));
+            size_t result = ZSTD_compress(output.data() + output_offset, output.size() - output_offset, source, source_size, level);
+            if(ZSTD_isError(result))
+            {
+                Core::Logger::error("compress failed: zstd error {}", ZSTD_getErrorName(result));
+                output.resize(output_offset);
+                return false;
+            }
+            output.resize(output_offset + result);
+            return true;
+        }
+        default:
+            Core::Logger::error("compress failed: unknown scheme {}", (std::uint32_t)scheme);
+            return false;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+namespace Arieo
+{
+    // Lossless compression on top of the GPU texel data. Values match the
+    // DDS variant written by compressDDS; KTX2 has its own scheme numbers.
+    enum class Supercompression : std::uint32_t
+    {
+        NONE = 0,
+        // LZ4 block format, fast to decode.
+        LZ4 = 1,
+        // Zstandard frame, smaller at a higher decode cost.
+        ZSTD = 2
+    };
+
+    // Decompresses a whole block, which has to come out at exactly
+    // destination_size bytes. Safe to call from several threads, every thread
+    // keeps its own decompression context.
+    bool decompressBlock(Supercompression scheme, const void* source, size_t source_size, void* destination, size_t destination_size);
+
+    // Decompresses one zstd frame that spans several destinations back to
+    // back, without staging the whole frame. KTX2 levels of arrays and cube
+    // maps hold their layers in one frame while ImageLayout keeps them apart.
+    bool decompressZstdFrame(const void* source, size_t source_size, void* const* destinations, const size_t* destination_sizes, size_t destination_count);
+
+    // Appends the compressed block to output. level follows the zstd scale;
+    // LZ4 switches to its high compression mode above 0.
+    bool compressBlock(Supercompression scheme, int level, const void* source, size_t source_size, std::vector<std::byte>& output);
+}
\ No newline at end of file
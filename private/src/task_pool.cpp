@@ -0,0 +1,243 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "task_pool.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace Arieo
+{
+    struct TaskPoolWorker
+    {
+        TaskPool* m_task_pool = nullptr;
+        size_t m_queue_index = 0;
+    };
+    static thread_local TaskPoolWorker t_task_pool_worker;
+
+    TaskPool::TaskPool(size_t thread_count)
+    {
+        if(thread_count == 0)
+        {
+            size_t hardware_thread_count = std::thread::hardware_concurrency();
+            thread_count = hardware_thread_count > 1 ? hardware_thread_count - 1 : 1;
+        }
+
+        m_queues.reserve(thread_count);
+        for(size_t i = 0; i < thread_count; ++i)
+        {
+            m_queues.emplace_back(std::make_unique<WorkerQueue>());
+        }
+
+        m_threads.reserve(thread_count);
+        for(size_t i = 0; i < thread_count; ++i)
+        {
+            m_threads.emplace_back(&TaskPool::workerMain, this, i);
+        }
+    }
+
+    TaskPool::~TaskPool()
+    {
+        shutdown();
+    }
+
+    void TaskPool::shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sleep_mutex);
+            if(m_is_stopping)
+            {
+                return;
+            }
+            m_is_stopping = true;
+        }
+        m_sleep_condition.notify_all();
+
+        for(std::thread& thread : m_threads)
+        {
+            thread.join();
+        }
+        m_threads.clear();
+    }
+
+    void TaskPool::submit(Task task)
+    {
+        if(m_threads.empty())
+        {
+            task();
+            return;
+        }
+
+        // Workers push to their own queue so nested work stays cache local,
+        // everyone else spreads round robin.
+        size_t queue_index = t_task_pool_worker.m_task_pool == this
+            ? t_task_pool_worker.m_queue_index
+            : m_next_queue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+        {
+            WorkerQueue& queue = *m_queues[queue_index];
+            std::lock_guard<std::mutex> lock(queue.m_mutex);
+            queue.m_tasks.emplace_back(std::move(task));
+        }
+        m_pending_count.fetch_add(1, std::memory_order_release);
+
+        {
+            std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        }
+        m_sleep_condition.notify_one();
+    }
+
+    bool TaskPool::popTask(size_t queue_index, Task& task)
+    {
+        if(m_pending_count.load(std::memory_order_acquire) == 0)
+        {
+            return false;
+        }
+
+        if(t_task_pool_worker.m_task_pool == this)
+        {
+            WorkerQueue& queue = *m_queues[queue_index];
+            std::lock_guard<std::mutex> lock(queue.m_mutex);
+            if(queue.m_tasks.empty() == false)
+            {
+                task = std::move(queue.m_tasks.back());
+                queue.m_tasks.pop_back();
+                m_pending_count.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        for(size_t i = 1; i <= m_queues.size(); ++i)
+        {
+            WorkerQueue& victim = *m_queues[(queue_index + i) % m_queues.size()];
+            std::unique_lock<std::mutex> lock(victim.m_mutex, std::try_to_lock);
+            if(lock.owns_lock() && victim.m_tasks.empty() == false)
+            {
+                task = std::move(victim.m_tasks.front());
+                victim.m_tasks.pop_front();
+                m_pending_count.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool TaskPool::runPendingTask()
+    {
+        if(m_queues.empty())
+        {
+            return false;
+        }
+
+        size_t queue_index = t_task_pool_worker.m_task_pool == this
+            ? t_task_pool_worker.m_queue_index
+            : m_next_queue.load(std::memory_order_relaxed) % m_queues.size();
+
+        Task task;
+        if(popTask(queue_index, task) == false)
+        {
+            return false;
+        }
+        task();
+        return true;
+    }
+
+    void TaskPool::workerMain(size_t worker_index)
+    {
+        t_task_pool_worker = TaskPoolWorker{this, worker_index};
+
+        while(true)
+        {
+            Task task;
+            if(popTask(worker_index, task))
+            {
+                task();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_sleep_mutex);
+            m_sleep_condition.wait(lock, [this]()
+            {
+                return m_is_stopping || m_pending_count.load(std::memory_order_acquire) != 0;
+            });
+            if(m_is_stopping && m_pending_count.load(std::memory_order_acquire) == 0)
+            {
+                break;
+            }
+        }
+
+        t_task_pool_worker = TaskPoolWorker{};
+    }
+
+    void TaskPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& func)
+    {
+        if(count == 0)
+        {
+            return;
+        }
+
+        grain = std::max<size_t>(grain, 1);
+        size_t chunk_count = (count + grain - 1) / grain;
+        if(chunk_count == 1 || m_threads.empty())
+        {
+            func(0, count);
+            return;
+        }
+
+        // Chunks are claimed from a shared counter, so helpers that start late
+        // simply find nothing left to do.
+        std::atomic<size_t> next_chunk{0};
+        auto run_chunks = [&]()
+        {
+            size_t chunk = 0;
+            while((chunk = next_chunk.fetch_add(1, std::memory_order_relaxed)) < chunk_count)
+            {
+                size_t begin = chunk * grain;
+                func(begin, std::min(begin + grain, count));
+            }
+        };
+
+        TaskGroup task_group(*this);
+        size_t helper_count = std::min(chunk_count - 1, m_threads.size());
+        for(size_t i = 0; i < helper_count; ++i)
+        {
+            task_group.run(run_chunks);
+        }
+        run_chunks();
+        task_group.wait();
+    }
+
+    void TaskGroup::run(TaskPool::Task task)
+    {
+        m_remaining_count.fetch_add(1, std::memory_order_relaxed);
+        m_task_pool.submit([this, task = std::move(task)]()
+        {
+            task();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(m_remaining_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                m_condition.notify_all();
+            }
+        });
+    }
+
+    void TaskGroup::wait()
+    {
+        while(m_remaining_count.load(std::memory_order_acquire) != 0)
+        {
+            if(m_task_pool.runPendingTask())
+            {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait_for(lock, std::chrono::milliseconds(1), [this]()
+            {
+                return m_remaining_count.load(std::memory_order_acquire) == 0;
+            });
+        }
+
+        // The last task may still hold the mutex while notifying, do not let
+        // the group be destroyed underneath it.
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+}
\ No newline at end of file
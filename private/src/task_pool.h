@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+namespace Arieo
+{
+    // Fixed size worker pool. Every worker owns a deque, pops its own work
+    // from the back and steals from the front of the others when it runs dry.
+    class TaskPool
+    {
+    public:
+        using Task = std::function<void()>;
+
+        // thread_count 0 picks one worker per hardware thread minus the caller.
+        explicit TaskPool(size_t thread_count = 0);
+        ~TaskPool();
+
+        TaskPool(const TaskPool&) = delete;
+        TaskPool& operator=(const TaskPool&) = delete;
+
+        size_t getThreadCount() const { return m_threads.size(); }
+
+        void submit(Task task);
+
+        // Runs one queued task on the calling thread, returns false if there was none.
+        bool runPendingTask();
+
+        // Splits [0, count) into chunks of at most grain items and blocks until
+        // every chunk ran. The caller executes chunks as well, so this is safe
+        // to call from inside a task.
+        void parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& func);
+
+        void shutdown();
+
+    private:
+        struct WorkerQueue
+        {
+            std::mutex m_mutex;
+            std::deque<Task> m_tasks;
+        };
+
+        bool popTask(size_t queue_index, Task& task);
+        void workerMain(size_t worker_index);
+
+        std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+        std::vector<std::thread> m_threads;
+
+        std::mutex m_sleep_mutex;
+        std::condition_variable m_sleep_condition;
+        std::atomic<size_t> m_pending_count{0};
+        std::atomic<size_t> m_next_queue{0};
+        bool m_is_stopping = false;
+    };
+
+    // Counts tasks submitted through it so a caller can wait for just those.
+    class TaskGroup
+    {
+    public:
+        explicit TaskGroup(TaskPool& task_pool) : m_task_pool(task_pool) {}
+        ~TaskGroup() { wait(); }
+
+        void run(TaskPool::Task task);
+
+        // Helps executing queued work until every task of this group finished.
+        void wait();
+
+    private:
+        TaskPool& m_task_pool;
+        std::atomic<size_t> m_remaining_count{0};
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "texture_pack.h"
+
+#include <algorithm>
+
+namespace Arieo
+{
+    bool TexturePack::open(const std::filesystem::path& path)
+    {
+        close();
+        if(m_mapped_file.open(path) == false)
+        {
+            return false;
+        }
+
+        const std::byte* data = (const std::byte*)m_mapped_file.getData();
+        m_header = (const TexturePackHeader*)data;
+        if(validate(path) == false)
+        {
+            close();
+            return false;
+        }
+
+        m_entries = (const TexturePackEntry*)(data + m_header->m_entry_table_offset);
+        m_subresources = (const TexturePackSubresource*)(data + m_header->m_subresource_table_offset);
+        m_names = (const char*)(data + m_header->m_name_table_offset);
+
+        // Lookups hit the table of contents only, keep it resident from the start.
+        m_mapped_file.prefetch(0, m_header->m_name_table_offset + m_header->m_name_table_size);
+        return true;
+    }
+
+    void TexturePack::close()
+    {
+        m_mapped_file.close();
+        m_header = nullptr;
+        m_entries = nullptr;
+        m_subresources = nullptr;
+        m_names = nullptr;
+    }
+
+    // Checked once here so that lookups can trust every offset in the tables.
+    bool TexturePack::validate(const std::filesystem::path& path) const
+    {
+        size_t file_size = m_mapped_file.getSize();
+        if(file_size < sizeof(TexturePackHeader)
+            || m_header->m_magic_number != g_texture_pack_magic_number)
+        {
+            Core::Logger::error("texture pack open failed: {} is not a texture pack", path.string());
+            return false;
+        }
+        if(m_header->m_version != g_texture_pack_version)
+        {
+            Core::Logger::error("texture pack open failed: {} has version {}, expected {}", path.string(), m_header->m_version, g_texture_pack_version);
+            return false;
+        }
+        if(m_header->m_file_size != file_size)
+        {
+            Core::Logger::error("texture pack open failed: {} is truncated, expected {} bytes, got {}", path.string(), m_header->m_file_size, file_size);
+            return false;
+        }
+
+        auto isInFile = [file_size](std::uint64_t offset, std::uint64_t size)
+        {
+            return offset <= file_size && size <= file_size - offset;
+        };
+        if(isInFile(m_header->m_entry_table_offset, (std::uint64_t)m_header->m_entry_count * sizeof(TexturePackEntry)) == false
+            || isInFile(m_header->m_subresource_table_offset, (std::uint64_t)m_header->m_subresource_count * sizeof(TexturePackSubresource)) == false
+            || isInFile(m_header->m_name_table_offset, m_header->m_name_table_size) == false
+            || m_header->m_entry_table_offset % alignof(TexturePackEntry) != 0
+            || m_header->m_subresource_table_offset % alignof(TexturePackSubresource) != 0)
+        {
+            Core::Logger::error("texture pack open failed: {} has a corrupt table of contents", path.string());
+            return false;
+        }
+
+        const std::byte* data = (const std::byte*)m_mapped_file.getData();
+        const TexturePackEntry* entries = (const TexturePackEntry*)(data + m_header->m_entry_table_offset);
+        const TexturePackSubresource* subresources = (const TexturePackSubresource*)(data + m_header->m_subresource_table_offset);
+        const char* names = (const char*)(data + m_header->m_name_table_offset);
+        std::string_view previous_name;
+        for(std::uint32_t entry_index = 0; entry_index < m_header->m_entry_count; ++entry_index)
+        {
+            const TexturePackEntry& entry = entries[entry_index];
+            std::uint64_t subresource_count = (std::uint64_t)entry.m_mip_map_count * entry.m_array_size;
+            if(isInFile(entry.m_data_offset, entry.m_data_size) == false
+                || (std::uint64_t)entry.m_name_offset + entry.m_name_length > m_header->m_name_table_size
+                || (std::uint64_t)entry.m_first_subresource + subresource_count > m_header->m_subresource_count)
+            {
+                Core::Logger::error("texture pack open failed: {} has a corrupt entry {}", path.string(), entry_index);
+                return false;
+            }
+
+            // getImage hands these regions to uploaders as they are.
+            for(std::uint64_t subresource_index = 0; subresource_index < subresource_count; ++subresource_index)
+            {
+                const TexturePackSubresource& subresource = subresources[entry.m_first_subresource + subresource_index];
+                if(subresource.m_offset > entry.m_data_size || subresource.m_size > entry.m_data_size - subresource.m_offset)
+                {
+                    Core::Logger::error("texture pack open failed: {} has a subresource outside of entry {}", path.string(), entry_index);
+                    return false;
+                }
+            }
+
+            // findEntry binary searches, names have to be unique and ascending.
+            std::string_view name(names + entry.m_name_offset, entry.m_name_length);
+            if(entry_index > 0 && (previous_name < name) == false)
+            {
+                Core::Logger::error("texture pack open failed: {} has entry {} out of name order", path.string(), entry_index);
+                return false;
+            }
+            previous_name = name;
+        }
+        return true;
+    }
+
+    std::string_view TexturePack::getName(const TexturePackEntry& entry) const
+    {
+        return std::string_view(m_names + entry.m_name_offset, entry.m_name_length);
+    }
+
+    std::string_view TexturePack::getEntryName(size_t entry_index) const
+    {
+        if(entry_index >= getEntryCount())
+        {
+            return std::string_view();
+        }
+        return getName(m_entries[entry_index]);
+    }
+
+    const TexturePackEntry* TexturePack::findEntry(std::string_view name) const
+    {
+        const TexturePackEntry* end = m_entries + getEntryCount();
+        const TexturePackEntry* found = std::lower_bound(m_entries, end, name, [this](const TexturePackEntry& entry, std::string_view value)
+        {
+            return getName(entry) < value;
+        });
+        if(found == end || getName(*found) != name)
+        {
+            return nullptr;
+        }
+        return found;
+    }
+
+    bool TexturePack::find(std::string_view name, Interface::FileLoader::ImageBuffer& image_buffer, ImageLayout& layout) const
+    {
+        const TexturePackEntry* entry = findEntry(name);
+        if(entry == nullptr)
+        {
+            Core::Logger::error("texture pack lookup failed: no entry {}", std::string(name));
+            return false;
+        }
+        getImage(*entry, image_buffer, layout);
+        return true;
+    }
+
+    void TexturePack::getImage(const TexturePackEntry& entry, Interface::FileLoader::ImageBuffer& image_buffer, ImageLayout& layout) const
+    {
+        {
+            image_buffer.m_buffer = (std::byte*)const_cast<void*>(m_mapped_file.getData()) + entry.m_data_offset;
+            image_buffer.m_size = (size_t)entry.m_data_size;
+
+            image_buffer.m_format = (Interface::RHI::Format)entry.m_format;
+
+            image_buffer.m_width = entry.m_width;
+            image_buffer.m_height = entry.m_height;
+            image_buffer.m_depth = entry.m_depth;
+            image_buffer.m_mip_map_count = entry.m_mip_map_count;
+        }
+
+        layout.m_dimension = (ImageDimension)entry.m_dimension;
+        layout.m_array_size = entry.m_array_size;
+        layout.m_mip_map_count = entry.m_mip_map_count;
+        layout.m_subresources.resize((size_t)entry.m_mip_map_count * entry.m_array_size);
+        for(size_t subresource_index = 0; subresource_index < layout.m_subresources.size(); ++subresource_index)
+        {
+            const TexturePackSubresource& source = m_subresources[entry.m_first_subresource + subresource_index];
+            ImageSubresource& target = layout.m_subresources[subresource_index];
+            target.m_mip_level = source.m_mip_level;
+            target.m_array_layer = source.m_array_layer;
+            target.m_width = source.m_width;
+            target.m_height = source.m_height;
+            target.m_depth = source.m_depth;
+            target.m_offset = (size_t)source.m_offset;
+            target.m_size = (size_t)source.m_size;
+            target.m_row_pitch = (size_t)source.m_row_pitch;
+            target.m_slice_pitch = (size_t)source.m_slice_pitch;
+        }
+    }
+
+    void TexturePack::prefetch(const TexturePackEntry& entry) const
+    {
+        m_mapped_file.prefetch((size_t)entry.m_data_offset, (size_t)entry.m_data_size);
+    }
+
+    void TexturePack::release(const TexturePackEntry& entry) const
+    {
+        m_mapped_file.release((size_t)entry.m_data_offset, (size_t)entry.m_data_size);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include "interface/file_loader/image_loader.h"
+#include "image_layout.h"
+#include "mapped_file.h"
+#include "texture_pack_format.h"
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+namespace Arieo
+{
+    // Read side of a texture pack built by TexturePackBuilder. The whole pack
+    // is one read-only mapping; the table of contents is validated once in
+    // open, lookups are a binary search over the sorted entries and the
+    // returned buffers point into the mapping.
+    class TexturePack
+    {
+    public:
+        bool open(const std::filesystem::path& path);
+        void close();
+
+        size_t getEntryCount() const { return m_header != nullptr ? m_header->m_entry_count : 0; }
+        std::string_view getEntryName(size_t entry_index) const;
+
+        // Returns nullptr if the pack has no entry of that name.
+        const TexturePackEntry* findEntry(std::string_view name) const;
+
+        // Fills image_buffer and layout of the named entry, false if there is none.
+        bool find(std::string_view name, Interface::FileLoader::ImageBuffer& image_buffer, ImageLayout& layout) const;
+        void getImage(const TexturePackEntry& entry, Interface::FileLoader::ImageBuffer& image_buffer, ImageLayout& layout) const;
+
+        // Page hints for the texel data of one entry, see MappedFile.
+        void prefetch(const TexturePackEntry& entry) const;
+        void release(const TexturePackEntry& entry) const;
+
+    private:
+        bool validate(const std::filesystem::path& path) const;
+        std::string_view getName(const TexturePackEntry& entry) const;
+
+        MappedFile m_mapped_file;
+        const TexturePackHeader* m_header = nullptr;
+        const TexturePackEntry* m_entries = nullptr;
+        const TexturePackSubresource* m_subresources = nullptr;
+        const char* m_names = nullptr;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "texture_pack_builder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+
+namespace Arieo
+{
+    static std::uint64_t alignUp(std::uint64_t value, std::uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    TexturePackBuilder::TexturePackBuilder(std::uint32_t alignment)
+        : m_alignment(std::max<std::uint32_t>(alignment, alignof(TexturePackEntry)))
+    {
+    }
+
+    bool TexturePackBuilder::add(std::string name, const Interface::FileLoader::ImageBuffer& image_buffer, const ImageLayout& layout)
+    {
+        if(image_buffer.m_buffer == nullptr || layout.m_subresources.empty())
+        {
+            Core::Logger::error("texture pack add failed: {} has no subresource layout", name);
+            return false;
+        }
+
+        PendingEntry entry;
+        entry.m_name = std::move(name);
+        entry.m_image_buffer = image_buffer;
+        entry.m_image_buffer.m_buffer = nullptr;
+        entry.m_layout = layout;
+        entry.m_data.assign((const std::byte*)image_buffer.m_buffer, (const std::byte*)image_buffer.m_buffer + image_buffer.m_size);
+        m_entries.emplace_back(std::move(entry));
+        return true;
+    }
+
+    bool TexturePackBuilder::write(const std::filesystem::path& path) const
+    {
+        std::vector<size_t> order(m_entries.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs)
+        {
+            return m_entries[lhs].m_name < m_entries[rhs].m_name;
+        });
+        for(size_t index = 1; index < order.size(); ++index)
+        {
+            if(m_entries[order[index - 1]].m_name == m_entries[order[index]].m_name)
+            {
+                Core::Logger::error("texture pack write failed: duplicate entry {}", m_entries[order[index]].m_name);
+                return false;
+            }
+        }
+
+        // Tables first, so opening a pack only touches its leading pages.
+        std::vector<TexturePackEntry> entries(m_entries.size());
+        std::vector<TexturePackSubresource> subresources;
+        std::string names;
+        for(size_t index = 0; index < order.size(); ++index)
+        {
+            const PendingEntry& pending = m_entries[order[index]];
+            TexturePackEntry& entry = entries[index];
+            entry = TexturePackEntry{};
+            entry.m_name_offset = (std::uint32_t)names.size();
+            entry.m_name_length = (std::uint32_t)pending.m_name.size();
+            entry.m_format = (std::uint32_t)pending.m_image_buffer.m_format;
+            entry.m_dimension = (std::uint32_t)pending.m_layout.m_dimension;
+            entry.m_width = pending.m_image_buffer.m_width;
+            entry.m_height = pending.m_image_buffer.m_height;
+            entry.m_depth = pending.m_image_buffer.m_depth;
+            entry.m_mip_map_count = pending.m_layout.m_mip_map_count;
+            entry.m_array_size = pending.m_layout.m_array_size;
+            entry.m_first_subresource = (std::uint32_t)subresources.size();
+            entry.m_data_size = pending.m_data.size();
+            names += pending.m_name;
+
+            for(const ImageSubresource& source : pending.m_layout.m_subresources)
+            {
+                TexturePackSubresource subresource{};
+                subresource.m_mip_level = source.m_mip_level;
+                subresource.m_array_layer = source.m_array_layer;
+                subresource.m_width = source.m_width;
+                subresource.m_height = source.m_height;
+                subresource.m_depth = source.m_depth;
+                subresource.m_offset = source.m_offset;
+                subresource.m_size = source.m_size;
+                subresource.m_row_pitch = source.m_row_pitch;
+                subresource.m_slice_pitch = source.m_slice_pitch;
+                subresources.emplace_back(subresource);
+            }
+        }
+
+        TexturePackHeader header{};
+        header.m_magic_number = g_texture_pack_magic_number;
+        header.m_version = g_texture_pack_version;
+        header.m_entry_count = (std::uint32_t)entries.size();
+        header.m_subresource_count = (std::uint32_t)subresources.size();
+        header.m_alignment = m_alignment;
+        header.m_entry_table_offset = sizeof(TexturePackHeader);
+        header.m_subresource_table_offset = header.m_entry_table_offset + entries.size() * sizeof(TexturePackEntry);
+        header.m_name_table_offset = header.m_subresource_table_offset + subresources.size() * sizeof(TexturePackSubresource);
+        header.m_name_table_size = names.size();
+
+        std::uint64_t data_offset = header.m_name_table_offset + header.m_name_table_size;
+        for(TexturePackEntry& entry : entries)
+        {
+            data_offset = alignUp(data_offset, m_alignment);
+            entry.m_data_offset = data_offset;
+            data_offset += entry.m_data_size;
+        }
+        header.m_file_size = data_offset;
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if(file.is_open() == false)
+        {
+            Core::Logger::error("texture pack write failed: cannot open {}", path.string());
+            return false;
+        }
+
+        file.write((const char*)&header, sizeof(header));
+        file.write((const char*)entries.data(), entries.size() * sizeof(TexturePackEntry));
+        file.write((const char*)subresources.data(), subresources.size() * sizeof(TexturePackSubresource));
+        file.write(names.data(), names.size());
+
+        static const char padding[4096] = {};
+        std::uint64_t file_offset = header.m_name_table_offset + header.m_name_table_size;
+        for(size_t index = 0; index < order.size(); ++index)
+        {
+            const TexturePackEntry& entry = entries[index];
+            while(file_offset < entry.m_data_offset)
+            {
+                std::uint64_t padding_size = std::min<std::uint64_t>(entry.m_data_offset - file_offset, sizeof(padding));
+                file.write(padding, padding_size);
+                file_offset += padding_size;
+            }
+            const std::vector<std::byte>& data = m_entries[order[index]].m_data;
+            file.write((const char*)data.data(), data.size());
+            file_offset += data.size();
+        }
+
+        file.close();
+        if(file.good() == false)
+        {
+            Core::Logger::error("texture pack write failed: error writing {}", path.string());
+            return false;
+        }
+        return true;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+#include "interface/file_loader/image_loader.h"
+#include "image_layout.h"
+#include "texture_pack_format.h"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+namespace Arieo
+{
+    // Collects loaded images and writes them as one texture pack, see
+    // texture_pack_format.h. Entries are written sorted by name.
+    class TexturePackBuilder
+    {
+    public:
+        explicit TexturePackBuilder(std::uint32_t alignment = g_texture_pack_default_alignment);
+
+        // Copies the texels. Fails for images without a subresource layout.
+        bool add(std::string name, const Interface::FileLoader::ImageBuffer& image_buffer, const ImageLayout& layout);
+
+        size_t getEntryCount() const { return m_entries.size(); }
+
+        // Fails on duplicate names or when the file cannot be written.
+        bool write(const std::filesystem::path& path) const;
+
+    private:
+        struct PendingEntry
+        {
+            std::string m_name;
+            Interface::FileLoader::ImageBuffer m_image_buffer{};
+            ImageLayout m_layout;
+            std::vector<std::byte> m_data;
+        };
+
+        std::uint32_t m_alignment;
+        std::vector<PendingEntry> m_entries;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+namespace Arieo
+{
+    // On-disk layout of a texture pack, little endian:
+    //
+    //   TexturePackHeader
+    //   TexturePackEntry[m_entry_count]              sorted by name
+    //   TexturePackSubresource[m_subresource_count]
+    //   names, not null terminated
+    //   texel data, every entry aligned to m_alignment
+    //
+    // Every offset is relative to the start of the file. Entries carry the
+    // resolved RHI format and layout, so nothing is parsed at load time.
+
+    inline constexpr std::uint32_t g_texture_pack_magic_number = 0x4B505441; // "ATPK"
+    inline constexpr std::uint32_t g_texture_pack_version = 1;
+
+    // Keeps texel data of every entry on its own cache lines and copyable
+    // with the placement alignment upload heaps commonly ask for.
+    inline constexpr std::uint32_t g_texture_pack_default_alignment = 512;
+
+    struct TexturePackHeader
+    {
+        std::uint32_t m_magic_number;
+        std::uint32_t m_version;
+        std::uint32_t m_entry_count;
+        std::uint32_t m_subresource_count;
+        std::uint32_t m_alignment;
+        std::uint32_t m_reserved;
+        std::uint64_t m_entry_table_offset;
+        std::uint64_t m_subresource_table_offset;
+        std::uint64_t m_name_table_offset;
+        std::uint64_t m_name_table_size;
+        std::uint64_t m_file_size;
+    };
+
+    struct TexturePackEntry
+    {
+        std::uint32_t m_name_offset;    // into the name table
+        std::uint32_t m_name_length;
+        std::uint32_t m_format;         // Interface::RHI::Format
+        std::uint32_t m_dimension;      // ImageDimension
+        std::uint32_t m_width;
+        std::uint32_t m_height;
+        std::uint32_t m_depth;
+        std::uint32_t m_mip_map_count;
+        std::uint32_t m_array_size;
+        std::uint32_t m_first_subresource;
+        std::uint64_t m_data_offset;
+        std::uint64_t m_data_size;
+    };
+
+    // Same as ImageSubresource, offsets relative to the entry data.
+    struct TexturePackSubresource
+    {
+        std::uint32_t m_mip_level;
+        std::uint32_t m_array_layer;
+        std::uint32_t m_width;
+        std::uint32_t m_height;
+        std::uint32_t m_depth;
+        std::uint32_t m_reserved;
+        std::uint64_t m_offset;
+        std::uint64_t m_size;
+        std::uint64_t m_row_pitch;
+        std::uint64_t m_slice_pitch;
+    };
+
+    static_assert(sizeof(TexturePackHeader) == 64, "texture pack header layout changed");
+    static_assert(sizeof(TexturePackEntry) == 56, "texture pack entry layout changed");
+    static_assert(sizeof(TexturePackSubresource) == 56, "texture pack subresource layout changed");
+}
\ No newline at end of file
@@ -0,0 +1,1050 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "bc_decoder.h"
+#include "bc_encoder.h"
+#include "cpu_features.h"
+#include "dds_conversion.h"
+#include "dds_format.h"
+#include "image_buffer_pool.h"
+#include "image_loader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+// Usage: arieo_image_loader_benchmark [options]
+//
+//   --output <file>       write results as JSON, one result per line so two
+//                         runs diff line by line
+//   --threads <n,n,...>   loader thread counts, default 1 and every hardware thread
+//   --sizes <n,n,...>     square image extents, default 256,1024
+//   --min-time <seconds>  time per measurement, default 0.1
+//   --filter <text>       only cases whose name contains text
+//   --corpus <directory>  also write the generated files there
+//   --verify              only check every SIMD kernel the CPU runs against
+//                         the scalar reference and the legacy DDS loads of
+//                         IImageLoader, exits with 1 on a mismatch
+//
+// The corpus is generated in memory from a fixed seed, so every build
+// measures the same bytes: DDS files for every DXGI format the loader maps,
+// with DX10 headers, the legacy FourCC and mask formats, LZ4 / zstd
+// supercompressed DDS, and PNG, JPEG, HDR, TGA and BMP written by
+// stb_image_write. Every size comes with a single mip and a full chain.
+// DDS files are loaded zero-copy where the format allows it and copied out
+// through the allocator path; everything else is decoded. Each thread loads
+// the same file over and over, results are aggregated over all threads.
+
+using namespace Arieo;
+
+enum class CorpusContainer : std::uint32_t
+{
+    DDS_DX10,
+    DDS_LEGACY,
+    DDS_LZ4,
+    DDS_ZSTD,
+    PNG,
+    PNG_RGB,
+    JPEG,
+    HDR,
+    TGA,
+    BMP
+};
+
+struct CorpusEntry
+{
+    CorpusContainer m_container = CorpusContainer::DDS_DX10;
+    std::string m_container_name;
+    std::string m_format_name;
+    std::uint32_t m_extent = 0;
+    bool m_full_mips = false;
+
+    // DDS pixel format: a DXGI format for DX10 headers, FourCC or masks otherwise.
+    std::uint32_t m_dxgi_format = 0;
+    std::uint32_t m_pixel_format_flags = 0;
+    std::uint32_t m_fourcc = 0;
+    std::uint32_t m_bit_count = 0;
+    std::uint32_t m_masks[4] = {};
+
+    std::string getName() const
+    {
+        return m_container_name + "/" + m_format_name + "/" + std::to_string(m_extent) + (m_full_mips ? "/mips" : "/mip0");
+    }
+};
+
+enum class BenchmarkOperation : std::uint32_t
+{
+    // loadDDS straight on the file bytes.
+    ZERO_COPY,
+    // loadDDS / loadKTX2 / loadImage into memory from an ImageBufferPool.
+    DECODE
+};
+
+struct BenchmarkResult
+{
+    std::string m_name;
+    const CorpusEntry* m_entry = nullptr;
+    BenchmarkOperation m_operation = BenchmarkOperation::DECODE;
+    size_t m_thread_count = 0;
+    size_t m_input_size = 0;
+    size_t m_output_size = 0;
+    std::uint64_t m_iteration_count = 0;
+    double m_seconds = 0.0;
+};
+
+struct BenchmarkOptions
+{
+    std::string m_output_path;
+    std::string m_corpus_path;
+    std::string m_filter;
+    std::vector<size_t> m_thread_counts;
+    std::vector<std::uint32_t> m_extents{256, 1024};
+    double m_min_time = 0.1;
+    bool m_verify = false;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Corpus
+
+static const std::uint32_t g_ddpf_alpha = 0x00000002;
+static const std::uint32_t g_ddpf_fourcc = 0x00000004;
+static const std::uint32_t g_ddpf_rgb = 0x00000040;
+static const std::uint32_t g_ddpf_luminance = 0x00020000;
+static const std::uint32_t g_ddpf_bumpdudv = 0x00080000;
+
+// DXGI_FORMAT_R32G32B32A32_TYPELESS to DXGI_FORMAT_B4G4R4A4_UNORM; the video
+// formats above have no RHI twin.
+static const std::uint32_t g_first_dxgi_format = 1;
+static const std::uint32_t g_last_dxgi_format = 115;
+
+static constexpr std::uint32_t makeFourCC(char c0, char c1, char c2, char c3)
+{
+    return (std::uint32_t)(std::uint8_t)c0
+        | ((std::uint32_t)(std::uint8_t)c1 << 8)
+        | ((std::uint32_t)(std::uint8_t)c2 << 16)
+        | ((std::uint32_t)(std::uint8_t)c3 << 24);
+}
+
+struct LegacyPixelFormat
+{
+    const char* m_name;
+    std::uint32_t m_flags;
+    std::uint32_t m_fourcc;
+    std::uint32_t m_bit_count;
+    std::uint32_t m_masks[4];
+};
+
+// One of each layout the loader resolves, named after their D3DFMT.
+static const LegacyPixelFormat g_legacy_pixel_formats[] =
+{
+    { "DXT1", g_ddpf_fourcc, makeFourCC('D', 'X', 'T', '1'), 0, {} },
+    { "DXT3", g_ddpf_fourcc, makeFourCC('D', 'X', 'T', '3'), 0, {} },
+    { "DXT5", g_ddpf_fourcc, makeFourCC('D', 'X', 'T', '5'), 0, {} },
+    { "ATI1", g_ddpf_fourcc, makeFourCC('A', 'T', 'I', '1'), 0, {} },
+    { "ATI2", g_ddpf_fourcc, makeFourCC('A', 'T', 'I', '2'), 0, {} },
+    { "A16B16G16R16", g_ddpf_fourcc, 36, 0, {} },
+    { "A16B16G16R16F", g_ddpf_fourcc, 113, 0, {} },
+    { "A32B32G32R32F", g_ddpf_fourcc, 116, 0, {} },
+    { "A8B8G8R8", g_ddpf_rgb, 0, 32, { 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000 } },
+    { "A8R8G8B8", g_ddpf_rgb, 0, 32, { 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 } },
+    { "X8R8G8B8", g_ddpf_rgb, 0, 32, { 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 } },
+    { "X8B8G8R8", g_ddpf_rgb, 0, 32, { 0x000000FF, 0x0000FF00, 0x00FF0000, 0x00000000 } },
+    { "A2B10G10R10", g_ddpf_rgb, 0, 32, { 0x000003FF, 0x000FFC00, 0x3FF00000, 0xC0000000 } },
+    { "A2R10G10B10", g_ddpf_rgb, 0, 32, { 0x3FF00000, 0x000FFC00, 0x000003FF, 0xC0000000 } },
+    { "G16R16", g_ddpf_rgb, 0, 32, { 0x0000FFFF, 0xFFFF0000, 0x00000000, 0x00000000 } },
+    { "R8G8B8", g_ddpf_rgb, 0, 24, { 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 } },
+    { "A1R5G5B5", g_ddpf_rgb, 0, 16, { 0x00007C00, 0x000003E0, 0x0000001F, 0x00008000 } },
+    { "X1R5G5B5", g_ddpf_rgb, 0, 16, { 0x00007C00, 0x000003E0, 0x0000001F, 0x00000000 } },
+    { "R5G6B5", g_ddpf_rgb, 0, 16, { 0x0000F800, 0x000007E0, 0x0000001F, 0x00000000 } },
+    { "A4R4G4B4", g_ddpf_rgb, 0, 16, { 0x00000F00, 0x000000F0, 0x0000000F, 0x0000F000 } },
+    { "X4R4G4B4", g_ddpf_rgb, 0, 16, { 0x00000F00, 0x000000F0, 0x0000000F, 0x00000000 } },
+    { "L8", g_ddpf_luminance, 0, 8, { 0x000000FF, 0x00000000, 0x00000000, 0x00000000 } },
+    { "L16", g_ddpf_luminance, 0, 16, { 0x0000FFFF, 0x00000000, 0x00000000, 0x00000000 } },
+    { "A8L8", g_ddpf_luminance, 0, 16, { 0x000000FF, 0x00000000, 0x00000000, 0x0000FF00 } },
+    { "A8", g_ddpf_alpha, 0, 8, { 0x00000000, 0x00000000, 0x00000000, 0x000000FF } },
+    { "V8U8", g_ddpf_bumpdudv, 0, 16, { 0x000000FF, 0x0000FF00, 0x00000000, 0x00000000 } },
+    { "Q8W8V8U8", g_ddpf_bumpdudv, 0, 32, { 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000 } },
+};
+
+// xorshift32, the corpus has to be identical on every run and platform.
+struct PatternRandom
+{
+    std::uint32_t m_state = 0x9E3779B9;
+
+    std::uint32_t next()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+};
+
+// Smooth ramps with a little noise, so compressors see roughly what real
+// textures give them rather than incompressible noise.
+static void fillPattern(std::uint8_t* data, size_t size, std::uint32_t row_size)
+{
+    PatternRandom random;
+    for(size_t offset = 0; offset < size; ++offset)
+    {
+        size_t x = offset % row_size;
+        size_t y = offset / row_size;
+        data[offset] = (std::uint8_t)((x / 4 + y * 3 + (offset & 3) * 64) + (random.next() & 7));
+    }
+}
+
+static void writeDDSFile(const CorpusEntry& entry, std::uint32_t mip_map_count, size_t payload_size, std::vector<std::byte>& file)
+{
+    bool is_dx10 = entry.m_container != CorpusContainer::DDS_LEGACY;
+    std::uint32_t header[37] = {};
+    {
+        header[0] = makeFourCC('D', 'D', 'S', ' ');
+        header[1] = 124;                                 // dwSize
+        header[2] = 0x1007 | 0x20000;                    // caps, height, width, pixel format, mip count
+        header[3] = entry.m_extent;                      // dwHeight
+        header[4] = entry.m_extent;                      // dwWidth
+        header[7] = mip_map_count;                       // dwMipMapCount
+        header[19] = 32;                                 // ddspf.dwSize
+        header[20] = is_dx10 ? g_ddpf_fourcc : entry.m_pixel_format_flags;
+        header[21] = is_dx10 ? makeFourCC('D', 'X', '1', '0') : entry.m_fourcc;
+        header[22] = entry.m_bit_count;
+        std::memcpy(header + 23, entry.m_masks, sizeof(entry.m_masks));
+        header[27] = 0x1000 | (mip_map_count > 1 ? 0x400008 : 0); // DDSCAPS_TEXTURE, MIPMAP | COMPLEX
+        header[32] = entry.m_dxgi_format;                // DDS_HEADER_DXT10
+        header[33] = 3;                                  // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+        header[35] = 1;                                  // arraySize
+    }
+    size_t header_size = is_dx10 ? sizeof(header) : 4 + 124;
+    file.resize(header_size + payload_size);
+    std::memcpy(file.data(), header, header_size);
+}
+
+// Size of the texels behind the header in the layout on disk, 0 if the
+// loader does not resolve the format.
+static size_t getDDSPayloadSize(const std::vector<std::byte>& file, std::uint32_t mip_map_count, DDSImageDesc& desc)
+{
+    if(parseDDSHeader(file.data(), file.size(), desc) == false || desc.m_format == Interface::RHI::Format::UNKNOWN)
+    {
+        return 0;
+    }
+    ImageFormatInfo format_info = getImageFormatInfo(desc.m_format);
+    if(desc.m_conversion != DDSConversion::NONE)
+    {
+        format_info = ImageFormatInfo{1, 1, getDDSConversionSourceTexelSize(desc.m_conversion)};
+    }
+    ImageLayout layout;
+    return buildImageLayout(layout, format_info, ImageDimension::TEXTURE_2D, desc.m_width, desc.m_height, 1, mip_map_count, 1);
+}
+
+static bool generateDDSFile(const CorpusEntry& entry, std::vector<std::byte>& file)
+{
+    std::uint32_t mip_map_count = entry.m_full_mips ? computeFullMipMapCount(entry.m_extent, entry.m_extent, 1) : 1;
+
+    // Headers first, they decide how large the payload is.
+    writeDDSFile(entry, mip_map_count, 0, file);
+    DDSImageDesc desc;
+    size_t payload_size = getDDSPayloadSize(file, mip_map_count, desc);
+    if(payload_size == 0)
+    {
+        return false;
+    }
+    writeDDSFile(entry, mip_map_count, payload_size, file);
+    fillPattern((std::uint8_t*)file.data() + desc.m_data_offset, payload_size, entry.m_extent * 4);
+
+    if(entry.m_container == CorpusContainer::DDS_LZ4 || entry.m_container == CorpusContainer::DDS_ZSTD)
+    {
+        std::vector<std::byte> compressed;
+        Supercompression scheme = entry.m_container == CorpusContainer::DDS_LZ4 ? Supercompression::LZ4 : Supercompression::ZSTD;
+        if(compressDDS(file.data(), file.size(), scheme, 3, compressed) == false)
+        {
+            return false;
+        }
+        file = std::move(compressed);
+    }
+    return true;
+}
+
+static void appendToFile(void* context, void* data, int size)
+{
+    std::vector<std::byte>& file = *(std::vector<std::byte>*)context;
+    file.insert(file.end(), (const std::byte*)data, (const std::byte*)data + size);
+}
+
+static bool generateStbFile(const CorpusEntry& entry, std::vector<std::byte>& file)
+{
+    int extent = (int)entry.m_extent;
+    int channel_count = entry.m_container == CorpusContainer::PNG ? 4 : 3;
+    std::vector<std::uint8_t> texels((size_t)extent * extent * channel_count);
+    fillPattern(texels.data(), texels.size(), extent * channel_count);
+
+    file.clear();
+    switch(entry.m_container)
+    {
+    case CorpusContainer::PNG:
+    case CorpusContainer::PNG_RGB:
+        return stbi_write_png_to_func(appendToFile, &file, extent, extent, channel_count, texels.data(), extent * channel_count) != 0;
+    case CorpusContainer::JPEG:
+        return stbi_write_jpg_to_func(appendToFile, &file, extent, extent, channel_count, texels.data(), 90) != 0;
+    case CorpusContainer::TGA:
+        return stbi_write_tga_to_func(appendToFile, &file, extent, extent, channel_count, texels.data()) != 0;
+    case CorpusContainer::BMP:
+        return stbi_write_bmp_to_func(appendToFile, &file, extent, extent, channel_count, texels.data()) != 0;
+    case CorpusContainer::HDR:
+    {
+        std::vector<float> radiance(texels.size());
+        for(size_t index = 0; index < texels.size(); ++index)
+        {
+            radiance[index] = texels[index] / 64.0f;
+        }
+        return stbi_write_hdr_to_func(appendToFile, &file, extent, extent, channel_count, radiance.data()) != 0;
+    }
+    default:
+        return false;
+    }
+}
+
+static bool isDDSContainer(CorpusContainer container)
+{
+    return container == CorpusContainer::DDS_DX10
+        || container == CorpusContainer::DDS_LEGACY
+        || container == CorpusContainer::DDS_LZ4
+        || container == CorpusContainer::DDS_ZSTD;
+}
+
+static bool generateFile(const CorpusEntry& entry, std::vector<std::byte>& file)
+{
+    return isDDSContainer(entry.m_container) ? generateDDSFile(entry, file) : generateStbFile(entry, file);
+}
+
+static std::vector<CorpusEntry> buildCorpus(const BenchmarkOptions& options)
+{
+    std::vector<CorpusEntry> corpus;
+    auto addEntry = [&](const CorpusEntry& base)
+    {
+        for(std::uint32_t extent : options.m_extents)
+        {
+            // stb images carry a single level.
+            for(bool full_mips : {false, true})
+            {
+                if(full_mips && isDDSContainer(base.m_container) == false)
+                {
+                    continue;
+                }
+                CorpusEntry entry = base;
+                entry.m_extent = extent;
+                entry.m_full_mips = full_mips;
+                if(entry.getName().find(options.m_filter) != std::string::npos)
+                {
+                    corpus.emplace_back(entry);
+                }
+            }
+        }
+    };
+
+    for(std::uint32_t dxgi_format = g_first_dxgi_format; dxgi_format <= g_last_dxgi_format; ++dxgi_format)
+    {
+        CorpusEntry entry;
+        entry.m_container = CorpusContainer::DDS_DX10;
+        entry.m_container_name = "dds_dx10";
+        entry.m_format_name = "dxgi_" + std::to_string(dxgi_format);
+        entry.m_dxgi_format = dxgi_format;
+        addEntry(entry);
+    }
+
+    for(const LegacyPixelFormat& pixel_format : g_legacy_pixel_formats)
+    {
+        CorpusEntry entry;
+        entry.m_container = CorpusContainer::DDS_LEGACY;
+        entry.m_container_name = "dds_legacy";
+        entry.m_format_name = pixel_format.m_name;
+        entry.m_pixel_format_flags = pixel_format.m_flags;
+        entry.m_fourcc = pixel_format.m_fourcc;
+        entry.m_bit_count = pixel_format.m_bit_count;
+        std::memcpy(entry.m_masks, pixel_format.m_masks, sizeof(entry.m_masks));
+        addEntry(entry);
+    }
+
+    // DXGI_FORMAT_R8G8B8A8_UNORM and DXGI_FORMAT_BC7_UNORM
+    for(CorpusContainer container : {CorpusContainer::DDS_LZ4, CorpusContainer::DDS_ZSTD})
+    {
+        for(std::uint32_t dxgi_format : {28u, 98u})
+        {
+            CorpusEntry entry;
+            entry.m_container = container;
+            entry.m_container_name = container == CorpusContainer::DDS_LZ4 ? "dds_lz4" : "dds_zstd";
+            entry.m_format_name = "dxgi_" + std::to_string(dxgi_format);
+            entry.m_dxgi_format = dxgi_format;
+            addEntry(entry);
+        }
+    }
+
+    struct StbContainer
+    {
+        CorpusContainer m_container;
+        const char* m_container_name;
+        const char* m_format_name;
+    };
+    static const StbContainer stb_containers[] =
+    {
+        { CorpusContainer::PNG, "png", "rgba8" },
+        { CorpusContainer::PNG_RGB, "png", "rgb8" },
+        { CorpusContainer::JPEG, "jpeg", "rgb8" },
+        { CorpusContainer::HDR, "hdr", "rgbe" },
+        { CorpusContainer::TGA, "tga", "rgb8" },
+        { CorpusContainer::BMP, "bmp", "rgb8" },
+    };
+    for(const StbContainer& stb_container : stb_containers)
+    {
+        CorpusEntry entry;
+        entry.m_container = stb_container.m_container;
+        entry.m_container_name = stb_container.m_container_name;
+        entry.m_format_name = stb_container.m_format_name;
+        addEntry(entry);
+    }
+    return corpus;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Measurement
+
+// One load of file, returns the size of the loaded image or 0 on failure.
+static size_t loadOnce(ImageLoader& image_loader, const CorpusEntry& entry, BenchmarkOperation operation, std::vector<std::byte>& file, PooledBuffer& output)
+{
+    ImageAllocator allocator = [&image_loader, &output](size_t size) -> void*
+    {
+        output = image_loader.getBufferPool().allocate(size);
+        return output.getData();
+    };
+
+    ImageLayout layout;
+    Interface::FileLoader::ImageBuffer image_buffer{};
+    if(operation == BenchmarkOperation::ZERO_COPY)
+    {
+        image_buffer = image_loader.loadDDS((void*)file.data(), file.size(), layout);
+    }
+    else if(isDDSContainer(entry.m_container))
+    {
+        image_buffer = image_loader.loadDDS((const void*)file.data(), file.size(), allocator, layout);
+    }
+    else
+    {
+        image_buffer = image_loader.loadImage(file.data(), file.size(), allocator);
+    }
+    output.reset();
+    return image_buffer.m_buffer != nullptr ? image_buffer.m_size : 0;
+}
+
+static bool runBenchmark(ImageLoader& image_loader, const CorpusEntry& entry, BenchmarkOperation operation, size_t thread_count, double min_time, std::vector<std::byte>& file, BenchmarkResult& result)
+{
+    result.m_name = entry.getName();
+    result.m_entry = &entry;
+    result.m_operation = operation;
+    result.m_thread_count = thread_count;
+    result.m_input_size = file.size();
+
+    // Warm up, and skip what the loader rejects.
+    PooledBuffer output;
+    result.m_output_size = loadOnce(image_loader, entry, operation, file, output);
+    if(result.m_output_size == 0)
+    {
+        return false;
+    }
+
+    std::atomic<bool> is_stopping{false};
+    std::atomic<std::uint64_t> iteration_count{0};
+    std::vector<std::chrono::steady_clock::time_point> end_times(thread_count);
+    auto start_time = std::chrono::steady_clock::now();
+
+    auto worker = [&](size_t thread_index)
+    {
+        PooledBuffer thread_output;
+        std::uint64_t thread_iteration_count = 0;
+        while(is_stopping.load(std::memory_order_relaxed) == false)
+        {
+            loadOnce(image_loader, entry, operation, file, thread_output);
+            ++thread_iteration_count;
+        }
+        iteration_count.fetch_add(thread_iteration_count, std::memory_order_relaxed);
+        end_times[thread_index] = std::chrono::steady_clock::now();
+    };
+
+    std::vector<std::thread> threads;
+    for(size_t thread_index = 1; thread_index < thread_count; ++thread_index)
+    {
+        threads.emplace_back(worker, thread_index);
+    }
+    std::thread timer([&]()
+    {
+        std::this_thread::sleep_for(std::chrono::duration<double>(min_time));
+        is_stopping.store(true, std::memory_order_relaxed);
+    });
+    worker(0);
+    timer.join();
+    for(std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    auto end_time = *std::max_element(end_times.begin(), end_times.end());
+    result.m_iteration_count = iteration_count.load(std::memory_order_relaxed);
+    result.m_seconds = std::chrono::duration<double>(end_time - start_time).count();
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reporting
+
+static const char* getOperationName(BenchmarkOperation operation)
+{
+    return operation == BenchmarkOperation::ZERO_COPY ? "zero_copy" : "decode";
+}
+
+static const char* getSimdLevelName(SimdLevel simd_level)
+{
+    switch(simd_level)
+    {
+    case SimdLevel::AVX2: return "avx2";
+    case SimdLevel::SSE41: return "sse4.1";
+    default: return "scalar";
+    }
+}
+
+static double getImagesPerSecond(const BenchmarkResult& result)
+{
+    return result.m_seconds > 0.0 ? result.m_iteration_count / result.m_seconds : 0.0;
+}
+
+static double getMegabytesPerSecond(const BenchmarkResult& result, size_t size)
+{
+    return getImagesPerSecond(result) * size / (1024.0 * 1024.0);
+}
+
+static void printResult(const BenchmarkResult& result)
+{
+    std::printf(
+        "%-40s %-9s %3zu %12.1f %12.1f %12.1f\n",
+        result.m_name.c_str(),
+        getOperationName(result.m_operation),
+        result.m_thread_count,
+        getImagesPerSecond(result),
+        getMegabytesPerSecond(result, result.m_input_size),
+        getMegabytesPerSecond(result, result.m_output_size)
+    );
+}
+
+static bool writeResults(const std::string& path, const std::vector<BenchmarkResult>& results, const std::vector<std::string>& skipped)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if(file == nullptr)
+    {
+        return false;
+    }
+
+    std::fprintf(file, "{\n");
+    std::fprintf(file, "  \"version\": 1,\n");
+    std::fprintf(file, "  \"simd\": \"%s\",\n", getSimdLevelName(getSimdLevel()));
+    std::fprintf(file, "  \"hardware_threads\": %u,\n", std::thread::hardware_concurrency());
+    std::fprintf(file, "  \"results\": [\n");
+    for(size_t index = 0; index < results.size(); ++index)
+    {
+        const BenchmarkResult& result = results[index];
+        std::fprintf(
+            file,
+            "    {\"name\": \"%s\", \"container\": \"%s\", \"format\": \"%s\", \"extent\": %u, \"full_mips\": %s, "
+            "\"operation\": \"%s\", \"threads\": %zu, \"input_bytes\": %zu, \"output_bytes\": %zu, "
+            "\"iterations\": %llu, \"seconds\": %.4f, \"images_per_s\": %.2f, \"input_mb_per_s\": %.2f, \"output_mb_per_s\": %.2f}%s\n",
+            result.m_name.c_str(),
+            result.m_entry->m_container_name.c_str(),
+            result.m_entry->m_format_name.c_str(),
+            result.m_entry->m_extent,
+            result.m_entry->m_full_mips ? "true" : "false",
+            getOperationName(result.m_operation),
+            result.m_thread_count,
+            result.m_input_size,
+            result.m_output_size,
+            (unsigned long long)result.m_iteration_count,
+            result.m_seconds,
+            getImagesPerSecond(result),
+            getMegabytesPerSecond(result, result.m_input_size),
+            getMegabytesPerSecond(result, result.m_output_size),
+            index + 1 < results.size() ? "," : ""
+        );
+    }
+    std::fprintf(file, "  ],\n");
+    std::fprintf(file, "  \"skipped\": [\n");
+    for(size_t index = 0; index < skipped.size(); ++index)
+    {
+        std::fprintf(file, "    \"%s\"%s\n", skipped[index].c_str(), index + 1 < skipped.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n");
+    std::fprintf(file, "}\n");
+    return std::fclose(file) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Kernel verification
+
+static const size_t g_verify_iteration_count = 4096;
+
+static void fillRandom(PatternRandom& random, std::uint8_t* data, size_t size)
+{
+    for(size_t offset = 0; offset < size; ++offset)
+    {
+        data[offset] = (std::uint8_t)random.next();
+    }
+}
+
+// Runs one decoder of both tables on the same random blocks. The destinations
+// start out identical so bytes a kernel leaves alone compare equal too.
+static bool verifyBCDecoder(const char* name, SimdLevel simd_level, BCBlockDecodeFunc reference, BCBlockDecodeFunc kernel)
+{
+    // Four texels of up to 16 bytes per row, enough for BC6H.
+    const size_t row_pitch = 4 * 16;
+    std::uint8_t block[16];
+    std::uint8_t expected[4 * row_pitch];
+    std::uint8_t actual[4 * row_pitch];
+    PatternRandom random;
+    for(size_t iteration = 0; iteration < g_verify_iteration_count; ++iteration)
+    {
+        fillRandom(random, block, sizeof(block));
+        // The lowest set bit of the first byte picks the BC7 mode, cycle it so
+        // every mode and the reserved one come up equally often.
+        std::uint32_t mode = (std::uint32_t)(iteration % 9);
+        block[0] = mode < 8 ? (std::uint8_t)((block[0] & ~((2u << mode) - 1)) | (1u << mode)) : 0;
+        for(bool swap_red_blue : {false, true})
+        {
+            std::memset(expected, 0xCD, sizeof(expected));
+            std::memset(actual, 0xCD, sizeof(actual));
+            reference(block, expected, row_pitch, swap_red_blue);
+            kernel(block, actual, row_pitch, swap_red_blue);
+            if(std::memcmp(expected, actual, sizeof(expected)) != 0)
+            {
+                std::fprintf(stderr, "%s %s differs from scalar at block %zu\n", getSimdLevelName(simd_level), name, iteration);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool verifyBCDecoders(SimdLevel simd_level)
+{
+    const BCBlockDecoders& reference = getScalarBCBlockDecoders();
+    const BCBlockDecoders& kernels = getBCBlockDecoders(simd_level);
+    bool is_equal = true;
+    is_equal &= verifyBCDecoder("bc1", simd_level, reference.m_bc1, kernels.m_bc1);
+    is_equal &= verifyBCDecoder("bc2", simd_level, reference.m_bc2, kernels.m_bc2);
+    is_equal &= verifyBCDecoder("bc3", simd_level, reference.m_bc3, kernels.m_bc3);
+    is_equal &= verifyBCDecoder("bc4_unorm", simd_level, reference.m_bc4_unorm, kernels.m_bc4_unorm);
+    is_equal &= verifyBCDecoder("bc4_snorm", simd_level, reference.m_bc4_snorm, kernels.m_bc4_snorm);
+    is_equal &= verifyBCDecoder("bc5_unorm", simd_level, reference.m_bc5_unorm, kernels.m_bc5_unorm);
+    is_equal &= verifyBCDecoder("bc5_snorm", simd_level, reference.m_bc5_snorm, kernels.m_bc5_snorm);
+    is_equal &= verifyBCDecoder("bc6h_ufloat", simd_level, reference.m_bc6h_ufloat, kernels.m_bc6h_ufloat);
+    is_equal &= verifyBCDecoder("bc6h_sfloat", simd_level, reference.m_bc6h_sfloat, kernels.m_bc6h_sfloat);
+    is_equal &= verifyBCDecoder("bc7", simd_level, reference.m_bc7, kernels.m_bc7);
+    return is_equal;
+}
+
+// Compares the error and the indices of the encoder's index search.
+static bool verifyBCEncodeKernels(SimdLevel simd_level)
+{
+    const BCEncodeKernels& reference = getScalarBCEncodeKernels();
+    const BCEncodeKernels& kernels = getBCEncodeKernels(simd_level);
+    std::uint32_t pixels[16];
+    std::uint32_t palette[16];
+    std::uint8_t values[16];
+    std::uint8_t channel_palette[8];
+    std::uint8_t expected[16];
+    std::uint8_t actual[16];
+    PatternRandom random;
+    for(size_t iteration = 0; iteration < g_verify_iteration_count; ++iteration)
+    {
+        fillRandom(random, (std::uint8_t*)pixels, sizeof(pixels));
+        fillRandom(random, (std::uint8_t*)palette, sizeof(palette));
+        // Every other round repeats a palette entry so ties are covered.
+        if(iteration & 1)
+        {
+            palette[1] = palette[0];
+            pixels[0] = palette[0];
+        }
+        for(std::uint32_t palette_size : {3u, 4u, 8u, 16u})
+        {
+            for(bool use_alpha : {false, true})
+            {
+                std::uint32_t expected_error = reference.m_select_color_indices(pixels, palette, palette_size, use_alpha, expected);
+                std::uint32_t actual_error = kernels.m_select_color_indices(pixels, palette, palette_size, use_alpha, actual);
+                if(expected_error != actual_error || std::memcmp(expected, actual, sizeof(expected)) != 0)
+                {
+                    std::fprintf(stderr, "%s select_color_indices differs from scalar at round %zu, palette size %u\n", getSimdLevelName(simd_level), iteration, palette_size);
+                    return false;
+                }
+            }
+        }
+
+        fillRandom(random, values, sizeof(values));
+        fillRandom(random, channel_palette, sizeof(channel_palette));
+        if(iteration & 1)
+        {
+            channel_palette[1] = channel_palette[0];
+            values[0] = channel_palette[0];
+        }
+        std::uint32_t expected_error = reference.m_select_channel_indices(values, channel_palette, expected);
+        std::uint32_t actual_error = kernels.m_select_channel_indices(values, channel_palette, actual);
+        if(expected_error != actual_error || std::memcmp(expected, actual, sizeof(expected)) != 0)
+        {
+            std::fprintf(stderr, "%s select_channel_indices differs from scalar at round %zu\n", getSimdLevelName(simd_level), iteration);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Texel counts run past every vector width with a ragged tail, the kernels
+// hand the remainder to scalar code.
+static bool verifyDDSConversionKernels(SimdLevel simd_level)
+{
+    const DDSConversionKernels& reference = getScalarDDSConversionKernels();
+    const DDSConversionKernels& kernels = getDDSConversionKernels(simd_level);
+    const size_t max_texel_count = 67;
+    // Up to 8 bytes per texel on the way out for 11:11:10 float to RGBA16F.
+    std::vector<std::uint8_t> source(max_texel_count * 4);
+    std::vector<std::uint8_t> expected(max_texel_count * 8);
+    std::vector<std::uint8_t> actual(max_texel_count * 8);
+    PatternRandom random;
+    for(size_t iteration = 0; iteration < g_verify_iteration_count / 16; ++iteration)
+    {
+        fillRandom(random, source.data(), source.size());
+        for(size_t texel_count = 1; texel_count <= max_texel_count; ++texel_count)
+        {
+            for(size_t kernel_index = 0; kernel_index < 6; ++kernel_index)
+            {
+                std::fill(expected.begin(), expected.end(), (std::uint8_t)0xCD);
+                std::fill(actual.begin(), actual.end(), (std::uint8_t)0xCD);
+                const char* name = nullptr;
+                switch(kernel_index)
+                {
+                case 0:
+                    name = "expand_24_to_32";
+                    reference.m_expand_24_to_32(source.data(), expected.data(), texel_count);
+                    kernels.m_expand_24_to_32(source.data(), actual.data(), texel_count);
+                    break;
+                case 1:
+                    name = "fill_alpha";
+                    reference.m_fill_alpha(source.data(), expected.data(), texel_count * 4, 0xFF000000);
+                    kernels.m_fill_alpha(source.data(), actual.data(), texel_count * 4, 0xFF000000);
+                    break;
+                case 2:
+                    name = "fill_alpha 16 bit";
+                    reference.m_fill_alpha(source.data(), expected.data(), texel_count * 2, 0x80008000);
+                    kernels.m_fill_alpha(source.data(), actual.data(), texel_count * 2, 0x80008000);
+                    break;
+                case 3:
+                    name = "unpack_10_10_10_2";
+                    reference.m_unpack_10_10_10_2(source.data(), expected.data(), texel_count, false);
+                    kernels.m_unpack_10_10_10_2(source.data(), actual.data(), texel_count, false);
+                    break;
+                case 4:
+                    name = "unpack_10_10_10_2 swapped";
+                    reference.m_unpack_10_10_10_2(source.data(), expected.data(), texel_count, true);
+                    kernels.m_unpack_10_10_10_2(source.data(), actual.data(), texel_count, true);
+                    break;
+                default:
+                    name = "unpack_11_11_10_float";
+                    reference.m_unpack_11_11_10_float(source.data(), expected.data(), texel_count);
+                    kernels.m_unpack_11_11_10_float(source.data(), actual.data(), texel_count);
+                    break;
+                }
+                if(expected != actual)
+                {
+                    std::fprintf(stderr, "%s %s differs from scalar at %zu texels\n", getSimdLevelName(simd_level), name, texel_count);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Legacy DDS files with padding load through the registered IImageLoader
+// entry point by filling alpha in place, and have to match the allocator
+// path. Conversions that change the texel size are rejected there.
+static bool verifyInterfaceLoads()
+{
+    TaskPool task_pool(1);
+    bool is_equal = true;
+    {
+        ImageLoader image_loader(task_pool, 0);
+        Interface::FileLoader::IImageLoader& interface_loader = image_loader;
+        for(const LegacyPixelFormat& pixel_format : g_legacy_pixel_formats)
+        {
+            std::string name = pixel_format.m_name;
+            bool is_in_place = name == "X8R8G8B8" || name == "X8B8G8R8" || name == "X1R5G5B5" || name == "X4R4G4B4";
+            if(is_in_place == false && name != "R8G8B8")
+            {
+                continue;
+            }
+
+            CorpusEntry entry;
+            entry.m_container = CorpusContainer::DDS_LEGACY;
+            entry.m_container_name = "dds_legacy";
+            entry.m_format_name = name;
+            entry.m_extent = 67;
+            entry.m_full_mips = true;
+            entry.m_pixel_format_flags = pixel_format.m_flags;
+            entry.m_fourcc = pixel_format.m_fourcc;
+            entry.m_bit_count = pixel_format.m_bit_count;
+            std::memcpy(entry.m_masks, pixel_format.m_masks, sizeof(entry.m_masks));
+
+            std::vector<std::byte> file;
+            if(generateFile(entry, file) == false)
+            {
+                std::fprintf(stderr, "%s cannot be generated\n", entry.getName().c_str());
+                is_equal = false;
+                continue;
+            }
+
+            std::vector<std::byte> expected;
+            ImageLayout layout;
+            Interface::FileLoader::ImageBuffer expected_buffer = image_loader.loadDDS(
+                (const void*)file.data(),
+                file.size(),
+                [&](size_t size) { expected.resize(size); return (void*)expected.data(); },
+                layout
+            );
+            Interface::FileLoader::ImageBuffer actual_buffer = interface_loader.loadDDS(file.data(), file.size());
+            bool is_loaded = actual_buffer.m_buffer != nullptr;
+            if(is_in_place != is_loaded)
+            {
+                std::fprintf(stderr, "%s %s through IImageLoader::loadDDS\n", entry.getName().c_str(), is_loaded ? "loaded" : "failed");
+                is_equal = false;
+            }
+            else if(is_loaded
+                && (expected_buffer.m_buffer == nullptr
+                    || actual_buffer.m_format != expected_buffer.m_format
+                    || actual_buffer.m_size != expected_buffer.m_size
+                    || std::memcmp(actual_buffer.m_buffer, expected_buffer.m_buffer, expected_buffer.m_size) != 0))
+            {
+                std::fprintf(stderr, "%s through IImageLoader::loadDDS differs from the allocator path\n", entry.getName().c_str());
+                is_equal = false;
+            }
+        }
+    }
+    task_pool.shutdown();
+    std::printf("dds interface loads %s\n", is_equal ? "match" : "differ");
+    return is_equal;
+}
+
+// Every SIMD level the CPU runs against the scalar reference, bit for bit.
+static bool verifyKernels()
+{
+    bool is_equal = true;
+    for(SimdLevel simd_level : {SimdLevel::SSE41, SimdLevel::AVX2})
+    {
+        if(simd_level > getSimdLevel())
+        {
+            std::printf("%s not supported, skipped\n", getSimdLevelName(simd_level));
+            continue;
+        }
+        bool is_level_equal = verifyBCDecoders(simd_level);
+        is_level_equal &= verifyBCEncodeKernels(simd_level);
+        is_level_equal &= verifyDDSConversionKernels(simd_level);
+        std::printf("%s %s\n", getSimdLevelName(simd_level), is_level_equal ? "matches scalar" : "differs from scalar");
+        is_equal &= is_level_equal;
+    }
+    return is_equal;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+static bool parseList(const char* text, std::vector<T>& values)
+{
+    values.clear();
+    std::string list = text;
+    size_t begin = 0;
+    while(begin <= list.size())
+    {
+        size_t end = std::min(list.find(',', begin), list.size());
+        unsigned long value = std::strtoul(list.substr(begin, end - begin).c_str(), nullptr, 10);
+        if(value == 0)
+        {
+            return false;
+        }
+        values.emplace_back((T)value);
+        begin = end + 1;
+    }
+    return values.empty() == false;
+}
+
+static bool parseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+    for(int arg_index = 1; arg_index < argc; ++arg_index)
+    {
+        std::string arg = argv[arg_index];
+        if(arg == "--verify")
+        {
+            options.m_verify = true;
+            continue;
+        }
+
+        const char* value = arg_index + 1 < argc ? argv[arg_index + 1] : nullptr;
+        if(value == nullptr)
+        {
+            return false;
+        }
+        ++arg_index;
+
+        if(arg == "--output")
+        {
+            options.m_output_path = value;
+        }
+        else if(arg == "--corpus")
+        {
+            options.m_corpus_path = value;
+        }
+        else if(arg == "--filter")
+        {
+            options.m_filter = value;
+        }
+        else if(arg == "--min-time")
+        {
+            options.m_min_time = std::strtod(value, nullptr);
+        }
+        else if(arg == "--threads")
+        {
+            if(parseList(value, options.m_thread_counts) == false)
+            {
+                return false;
+            }
+        }
+        else if(arg == "--sizes")
+        {
+            if(parseList(value, options.m_extents) == false)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    if(options.m_thread_counts.empty())
+    {
+        options.m_thread_counts.emplace_back(1);
+        size_t hardware_thread_count = std::thread::hardware_concurrency();
+        if(hardware_thread_count > 1)
+        {
+            options.m_thread_counts.emplace_back(hardware_thread_count);
+        }
+    }
+    return options.m_min_time > 0.0;
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    if(parseOptions(argc, argv, options) == false)
+    {
+        std::fprintf(stderr, "usage: %s [--output file] [--threads n,n] [--sizes n,n] [--min-time seconds] [--filter text] [--corpus directory] [--verify]\n", argv[0]);
+        return 1;
+    }
+    Core::Logger::setDefaultLogger("image_loader_benchmark");
+
+    if(options.m_verify)
+    {
+        bool is_verified = verifyKernels();
+        is_verified &= verifyInterfaceLoads();
+        return is_verified ? 0 : 1;
+    }
+
+    // One loader per thread count so internal parallel stages (supercompressed
+    // DDS) get as many workers as there are loading threads.
+    std::vector<std::unique_ptr<TaskPool>> task_pools;
+    std::vector<std::unique_ptr<ImageLoader>> image_loaders;
+    for(size_t thread_count : options.m_thread_counts)
+    {
+        task_pools.emplace_back(std::make_unique<TaskPool>(thread_count));
+        image_loaders.emplace_back(std::make_unique<ImageLoader>(*task_pools.back(), 0));
+    }
+
+    std::vector<CorpusEntry> corpus = buildCorpus(options);
+    std::printf("%zu corpus files, simd %s\n\n", corpus.size(), getSimdLevelName(getSimdLevel()));
+    std::printf("%-40s %-9s %3s %12s %12s %12s\n", "name", "operation", "thr", "images/s", "in MB/s", "out MB/s");
+
+    std::vector<BenchmarkResult> results;
+    std::vector<std::string> skipped;
+    std::vector<std::byte> file;
+    for(const CorpusEntry& entry : corpus)
+    {
+        // Files are generated one at a time, the large sizes of every format
+        // together would not fit in memory.
+        if(generateFile(entry, file) == false)
+        {
+            skipped.emplace_back(entry.getName());
+            continue;
+        }
+
+        if(options.m_corpus_path.empty() == false)
+        {
+            std::filesystem::path path = std::filesystem::path(options.m_corpus_path) / (entry.getName() + "." + (isDDSContainer(entry.m_container) ? "dds" : entry.m_container_name));
+            std::filesystem::create_directories(path.parent_path());
+            std::ofstream(path, std::ios::binary).write((const char*)file.data(), file.size());
+        }
+
+        std::vector<BenchmarkOperation> operations{BenchmarkOperation::DECODE};
+        DDSImageDesc desc;
+        if(isDDSContainer(entry.m_container)
+            && parseDDSHeader(file.data(), file.size(), desc)
+            && desc.m_conversion == DDSConversion::NONE
+            && desc.m_supercompression == Supercompression::NONE)
+        {
+            operations.insert(operations.begin(), BenchmarkOperation::ZERO_COPY);
+        }
+
+        bool is_loaded = false;
+        for(BenchmarkOperation operation : operations)
+        {
+            for(size_t index = 0; index < options.m_thread_counts.size(); ++index)
+            {
+                BenchmarkResult result;
+                if(runBenchmark(*image_loaders[index], entry, operation, options.m_thread_counts[index], options.m_min_time, file, result))
+                {
+                    printResult(result);
+                    results.emplace_back(std::move(result));
+                    is_loaded = true;
+                }
+            }
+        }
+        if(is_loaded == false)
+        {
+            skipped.emplace_back(entry.getName());
+        }
+    }
+
+    image_loaders.clear();
+    for(std::unique_ptr<TaskPool>& task_pool : task_pools)
+    {
+        task_pool->shutdown();
+    }
+
+    std::printf("\n%zu results, %zu skipped\n", results.size(), skipped.size());
+    if(options.m_output_path.empty() == false && writeResults(options.m_output_path, results, skipped) == false)
+    {
+        std::fprintf(stderr, "cannot write %s\n", options.m_output_path.c_str());
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "base/prerequisites.h"
+#include "core/core.h"
+
+#include "image_loader.h"
+#include "texture_pack_builder.h"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+// Usage: arieo_texture_pack_builder <output pack> <dds file or directory>...
+//
+// Directories are searched recursively for .dds files, which are named by
+// their path relative to the directory with '/' separators; files given
+// directly are named by their file name.
+
+using namespace Arieo;
+
+struct PackInput
+{
+    std::filesystem::path m_path;
+    std::string m_name;
+};
+
+static void collectInputs(const std::filesystem::path& path, std::vector<PackInput>& inputs)
+{
+    if(std::filesystem::is_directory(path) == false)
+    {
+        inputs.emplace_back(PackInput{path, path.filename().generic_string()});
+        return;
+    }
+    for(const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(path))
+    {
+        if(entry.is_regular_file() && entry.path().extension() == ".dds")
+        {
+            inputs.emplace_back(PackInput{entry.path(), std::filesystem::relative(entry.path(), path).generic_string()});
+        }
+    }
+}
+
+static bool readFile(const std::filesystem::path& path, std::vector<char>& content)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if(file.is_open() == false)
+    {
+        return false;
+    }
+    content.resize((size_t)file.tellg());
+    file.seekg(0);
+    file.read(content.data(), content.size());
+    return file.good();
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 3)
+    {
+        std::fprintf(stderr, "usage: %s <output pack> <dds file or directory>...\n", argv[0]);
+        return 1;
+    }
+    Core::Logger::setDefaultLogger("texture_pack_builder");
+
+    std::vector<PackInput> inputs;
+    for(int arg_index = 2; arg_index < argc; ++arg_index)
+    {
+        collectInputs(argv[arg_index], inputs);
+    }
+
+    TaskPool task_pool;
+    ImageLoader image_loader(task_pool);
+    TexturePackBuilder builder;
+    std::vector<char> content;
+    std::unique_ptr<std::byte[]> texels;
+    ImageAllocator allocator = [&texels](size_t size) -> void*
+    {
+        texels.reset(new std::byte[size]);
+        return texels.get();
+    };
+
+    int failed_count = 0;
+    for(const PackInput& input : inputs)
+    {
+        ImageLayout layout;
+        Interface::FileLoader::ImageBuffer image_buffer{};
+        if(readFile(input.m_path, content))
+        {
+            // The allocator path resolves legacy formats the RHI cannot sample.
+            image_buffer = image_loader.loadDDS(content.data(), content.size(), allocator, layout);
+        }
+        if(image_buffer.m_buffer == nullptr || builder.add(input.m_name, image_buffer, layout) == false)
+        {
+            std::fprintf(stderr, "skipped %s\n", input.m_path.string().c_str());
+            ++failed_count;
+        }
+    }
+
+    bool written = builder.write(argv[1]);
+    task_pool.shutdown();
+    if(written == false)
+    {
+        return 1;
+    }
+    std::printf("%zu textures written to %s, %d skipped\n", builder.getEntryCount(), argv[1], failed_count);
+    return failed_count == 0 ? 0 : 2;
+}
\ No newline at end of file